@@ -0,0 +1,77 @@
+/**
+ * @file buzzer_timing.h
+ * @brief Header for buzzer_timing.c file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef BUZZER_TIMING_H_
+#define BUZZER_TIMING_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Prescaler and auto-reload values of a 16-bit timer of the buzzer. The timer overflows every `(psc + 1) * (arr + 1)` clock cycles.
+ *
+ */
+typedef struct
+{
+    uint32_t psc;   /*!<Value of the PSC register*/
+    uint32_t arr;   /*!<Value of the ARR register*/
+} buzzer_timing_t;
+
+/**
+ * @brief Register values of a note, ready to be written to the PWM timer and the timer of the note duration. They are 16-bit, as the registers of the PWM timer.
+ *
+ */
+typedef struct
+{
+    uint16_t pwm_psc;       /*!<PSC of the PWM timer*/
+    uint16_t pwm_arr;       /*!<ARR of the PWM timer. 0 is a silence*/
+    uint16_t pwm_ccr;       /*!<CCR1 of the PWM timer, the duty cycle of the note*/
+    uint16_t duration_psc;  /*!<PSC of the timer of the note duration*/
+    uint16_t duration_arr;  /*!<ARR of the timer of the note duration*/
+} buzzer_timing_note_t;
+
+/* Function prototypes and explanation ---------------------------------------*/
+/**
+ * @brief Return the duration in ms of a note played at a speed, truncated as it is passed to the timer of the note duration.
+ *
+ * @param duration_ms Duration of the note in the melody, in ms
+ * @param speed Speed of the player
+ * @return uint32_t Duration of the note in ms
+ */
+uint32_t buzzer_timing_get_scaled_duration(uint32_t duration_ms, double speed);
+
+/**
+ * @brief Compute the PSC and ARR of the timer of the note duration (TIM2), with the smallest prescaler that fits.
+ *
+ * @param clock_hz Clock of the timer in Hz, `SystemCoreClock` in the firmware
+ * @param duration_ms Duration in ms
+ * @param p_timing Pointer to store the PSC and ARR
+ */
+void buzzer_timing_get_duration(uint32_t clock_hz, uint32_t duration_ms, buzzer_timing_t *p_timing);
+
+/**
+ * @brief Compute the PSC and ARR of the PWM timer (TIM3) of a note, with the smallest prescaler that fits.
+ *
+ * @param clock_hz Clock of the timer in Hz, `SystemCoreClock` in the firmware
+ * @param frequency_hz Frequency of the note in Hz, not 0
+ * @param p_timing Pointer to store the PSC and ARR
+ */
+void buzzer_timing_get_pwm(uint32_t clock_hz, double frequency_hz, buzzer_timing_t *p_timing);
+
+/**
+ * @brief Rescale the ARR and the counter of the timer of the note duration by a ratio, to change the speed of a note while it plays. The elapsed fraction of the note is kept and its remaining time is multiplied by the ratio. The prescaler is not changed, so the ARR may not fit in 16 bits.
+ *
+ * @param p_arr Pointer to the ARR of the timer, replaced by the rescaled one
+ * @param p_cnt Pointer to the counter of the timer, replaced by the rescaled one, never above the rescaled ARR
+ * @param ratio Ratio of the new duration to the old one, greater than 0
+ */
+void buzzer_timing_rescale_duration(uint32_t *p_arr, uint32_t *p_cnt, double ratio);
+
+#endif /* BUZZER_TIMING_H_ */
@@ -0,0 +1,143 @@
+/**
+ * @file fsm_active.h
+ * @brief Header for fsm_active.c file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef FSM_ACTIVE_H_
+#define FSM_ACTIVE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include <fsm.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define FSM_ACTIVE_MAX_OBJECTS 8        /*!<Maximum number of FSMs registered in the dispatcher*/
+#define FSM_ACTIVE_QUEUE_SIZE 32        /*!<Number of events of the queue of each FSM. It must be a power of 2. It is larger than the events of a full batch of commands, up to 3 per command*/
+#define FSM_ACTIVE_MAX_EVENTS 32        /*!<Maximum number of events processed in a call to `fsm_active_dispatch()`, to bound the time spent in it*/
+
+/* Enums */
+/**
+ * @brief Enumerator that defines the signals of the events.
+ *
+ */
+enum FSM_EVENT_SIGNAL {
+    FSM_EVENT_POLL = 0,     /*!<The FSM is busy waiting for a time or it has just changed state, so its guards must be checked again*/
+    FSM_EVENT_IRQ,          /*!<An ISR of the peripheral of the FSM has been served*/
+    FSM_EVENT_CHANGED,      /*!<An FSM this one listens to has fired a transition*/
+    FSM_EVENT_ACTION,       /*!<Action requested on a player, one of `USER_ACTIONS`, in `param`*/
+    FSM_EVENT_MELODY,       /*!<Melody to play, a `melody_t`, in `p_data`*/
+    FSM_EVENT_SPEED,        /*!<Speed of a player in `value`*/
+    FSM_EVENT_EFFECT,       /*!<Pitch effect of a player, one of `PORT_BUZZER_EFFECTS`, in `param`*/
+    FSM_EVENT_OUTPUT        /*!<Output of a player, one of `PORT_BUZZER_OUTPUTS`, in `param`*/
+};
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Event posted to an FSM. Its parameters depend on the signal, and the ones a signal does not use are ignored.
+ *
+ */
+typedef struct
+{
+    uint8_t signal;             /*!<Signal of the event, one of `FSM_EVENT_SIGNAL`*/
+    uint8_t param;              /*!<Integer parameter of the event*/
+    union
+    {
+        const void *p_data;     /*!<Pointer parameter of the event. The data must outlive the event*/
+        float value;            /*!<Real parameter of the event*/
+    };
+} fsm_event_t;
+
+/* Function prototypes and explanation ---------------------------------------*/
+/**
+ * @brief Register an FSM in the dispatcher as an active object with its own event queue. The FSMs registered first have higher priority.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @param p_fire Dispatch function of the FSM (`fsm_xxx_fire()`). It returns the row fired or -1.
+ * @param p_on_event Function that turns an event into the inputs of the FSM before it is fired. NULL if the FSM only reads its inputs in the guards.
+ * @param p_check_busy Function that returns true while the FSM must be fired on every dispatch, because it waits for a time. `fsm_active_always_busy()` for an FSM that must always be fired. NULL if the FSM only runs on events.
+ * @param irq_events Mask of `PORT_IRQ_EVENT_XXX` events that post `FSM_EVENT_IRQ` to the FSM
+ * @param trace_id Identifier of the FSM in the trace, one of `FSM_TRACE_ID`
+ * @return int Priority of the FSM (0 is the highest), used in `fsm_active_listen()`. -1 if there is no room for more FSMs.
+ */
+int fsm_active_register(fsm_t *p_fsm, int (*p_fire)(fsm_t *), void (*p_on_event)(fsm_t *, fsm_event_t), bool (*p_check_busy)(fsm_t *), uint32_t irq_events, uint32_t trace_id);
+
+/**
+ * @brief Post `FSM_EVENT_CHANGED` to an FSM every time another FSM fires a transition.
+ *
+ * @param listener Priority of the FSM that receives the events, as returned by `fsm_active_register()`
+ * @param source Priority of the FSM whose transitions are listened to, as returned by `fsm_active_register()`
+ */
+void fsm_active_listen(int listener, int source);
+
+/**
+ * @brief Post an event to an FSM. It must be called from the main loop, not from an ISR: the ISRs use `port_system_post_irq_event()`.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @param event Event to post
+ * @return true if the event has been queued
+ * @return false if the FSM is not registered or its queue is full. The event is lost, so the caller must report it.
+ */
+bool fsm_active_post(fsm_t *p_fsm, fsm_event_t event);
+
+/**
+ * @brief Get the priority of an FSM in the dispatcher.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @return int Priority of the FSM, as returned by `fsm_active_register()`. -1 if the FSM is not registered.
+ */
+int fsm_active_get_priority(fsm_t *p_fsm);
+
+/**
+ * @brief Process the pending events until all queues are empty, or `FSM_ACTIVE_MAX_EVENTS` events have been processed.
+ *
+ * > 1. **Turn the IRQ events** posted by the ISRs into `FSM_EVENT_IRQ` events. \n
+ * > 2. **Post `FSM_EVENT_POLL`** to the busy FSMs. \n
+ * > 3. **Take the first event** of the FSM with the highest priority and a non-empty queue, pass it to the `p_on_event` function of the FSM and **fire the FSM once** (run to completion). \n
+ * > 4. If the FSM has changed state, post `FSM_EVENT_POLL` to itself so that the next transition is checked, and post `FSM_EVENT_CHANGED` to its listeners if it has fired any transition. \n
+ * > 5. **Repeat from 3**, so that an event posted to an FSM of higher priority is processed before the rest of the events. \n
+ * > 6. If an FSM has requested the low power mode with `fsm_active_request_idle()` and all queues are empty, **enter it**.
+ *
+ * The FSMs with no events and not busy are not fired at all. The first fire after a wake-up from STOP mode adds its latency to `LATENCY_SEGMENT_WAKE_TO_FIRE`.
+ *
+ * @return uint32_t Number of events processed
+ */
+uint32_t fsm_active_dispatch(void);
+
+/**
+ * @brief Request the low power mode from the output of an FSM. The dispatcher calls `p_idle` at the end of `fsm_active_dispatch()`, and only if every queue is empty by then, so the FSMs of lower priority process the events posted in this dispatch before the system sleeps. Otherwise the request is dropped, and the FSM requests it again in a later dispatch. If the FSM is not registered, `p_idle` is called at once.
+ *
+ * @param p_fsm Pointer to the FSM that requests the low power mode
+ * @param p_idle Function that enters the low power mode. It receives `p_fsm`.
+ */
+void fsm_active_request_idle(fsm_t *p_fsm, void (*p_idle)(fsm_t *));
+
+/**
+ * @brief Get the epoch of the inputs. It changes at the start of every dispatch, when the ISRs may have changed the inputs, every time an event is passed to a `p_on_event` function, and every time an FSM fires a transition, whose output may have changed them. The guards can memoize the inputs they read while it does not change.
+ *
+ * @return uint32_t Epoch
+ */
+uint32_t fsm_active_get_epoch(void);
+
+/**
+ * @brief Unregister all the FSMs and empty their queues.
+ *
+ */
+void fsm_active_reset(void);
+
+/**
+ * @brief Busy function of the FSMs that must be fired on every dispatch.
+ *
+ * @param p_this Pointer to the FSM
+ * @return true always
+ */
+bool fsm_active_always_busy(fsm_t *p_this);
+
+#endif /* FSM_ACTIVE_H_ */
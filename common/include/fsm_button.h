@@ -18,15 +18,17 @@
 #include "fsm.h"
 
 /* Defines -------------------------------------------------------------------*/
+#ifndef FSM_BUTTON_POOL_SIZE
+#define FSM_BUTTON_POOL_SIZE 1  /*!<Number of button FSMs that can be created with `fsm_button_new_static()`. It can be overridden at compile time*/
+#endif
+
 /**
  * @brief Enumerator that defines the different states the finite state machine can be in.
  * 
  */
 enum FSM_BUTTON {
     BUTTON_RELEASED = 0,  /*!<Starting state. Also comes here when the button has been released*/
-    BUTTON_RELEASED_WAIT, /*!<State to perform the anti-debounce mechanism for a falling edge*/
     BUTTON_PRESSED,       /*!<State while the button is being pressed*/
-    BUTTON_PRESSED_WAIT , /*!<State to perform the anti-debounce mechanism for a rising edge*/ 
 };
 
 /* Typedefs ------------------------------------------------------------------*/
@@ -37,10 +39,10 @@ enum FSM_BUTTON {
 typedef struct
 {
     fsm_t f;                /*!< Internal FSM from the library */
-    uint32_t debounce_time; /*!< Button debounce time in ms */
-    uint32_t next_timeout;  /*!< Next timeout for the debounce in ms */
-    uint32_t tick_pressed;  /*!< Number of system ticks when the button was pressed */
+    uint32_t debounce_time; /*!< Button debounce time in ms, done by the port layer */
+    uint64_t time_pressed_us; /*!< Time in us when the button was pressed, from the timestamp of its edge */
     uint32_t duration;      /*!< How much time the button has been pressed */
+    bool press_consumed;    /*!< True if the current press has already been handled while held, so its duration is not reported again on release */
     uint32_t button_id;     /*!< Button ID*/
 } fsm_button_t;
 
@@ -48,13 +50,25 @@ typedef struct
 /**
  * @brief Creates a new FSM that meassures how long has the button been pressed.
  *
- * @param debounce_time time (in ms) the FSM will wait 150 ms in intermediate steps to avoid mechanical gltiches.
+ * @param debounce_time time (in ms) the port layer ignores the edges of the button after each press or release, to avoid mechanical gltiches.
  * @param button_id	Unique button identifier number.
  *
  * @return fsm_t Pointer to the button FSM.
  */
 fsm_t * fsm_button_new(uint32_t debounce_time, uint32_t button_id);
 
+/**
+ * @brief Create a new button FSM from a static pool of `FSM_BUTTON_POOL_SIZE` elements, without using the heap.
+ *
+ * @warning The FSM must not be passed to `fsm_destroy()`, because it has not been allocated with `malloc()`.
+ *
+ * @param debounce_time time (in ms) the port layer ignores the edges of the button after each press or release, to avoid mechanical gltiches.
+ * @param button_id	Unique button identifier number.
+ *
+ * @return fsm_t Pointer to the button FSM. NULL if the pool is exhausted.
+ */
+fsm_t * fsm_button_new_static(uint32_t debounce_time, uint32_t button_id);
+
 /**
  * @brief Initializes all the parameters of the button FSM.
  *
@@ -73,12 +87,20 @@ void fsm_button_init(fsm_t *p_this, uint32_t debounce_time, uint32_t button_id);
 uint32_t fsm_button_get_duration(fsm_t *p_this);
 
 /**
- * @brief Resets the duration measured by the FSM button.
+ * @brief Resets the duration measured by the FSM button. If the button is still pressed, the current press is considered handled: its held duration becomes 0 and its duration is not reported on release.
  * 
  * @param p_this Pointer to an fsm_t struct than contains an fsm_button_t.
  */
 void fsm_button_reset_duration(fsm_t *p_this);
 
+/**
+ * @brief Return how long the button has been held so far, while it is still pressed. It lets an action trigger as soon as a press crosses its threshold, without waiting for the release.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_button_t.
+ * @return uint32_t Time in ms since the button was pressed. 0 if it is not pressed, or if `fsm_button_reset_duration()` has been called during the current press.
+ */
+uint32_t fsm_button_get_held_duration(fsm_t *p_this);
+
 /** 
  * @brief Checks the status of the button to determine whether its active or not. The button is inactive when it is in the status BUTTON_RELEASED.
  * @param p_this Pointer to an fsm_t struct than contains an fsm_button_t.
@@ -87,5 +109,13 @@ void fsm_button_reset_duration(fsm_t *p_this);
  */  
 bool fsm_button_check_activity(fsm_t *p_this);
 
+/**
+ * @brief Fire the button FSM. It is equivalent to `fsm_fire()`, but the transitions table is compiled into a switch by `tools/fsm_codegen.py`, so only the transitions of the current state are checked and the guards and outputs are called directly.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_button_t struct
+ * @return int Position in the transitions table of the row fired. -1 if no guard is true.
+ */
+int fsm_button_fire(fsm_t *p_this);
+
 #endif // FSM_BUTTON_H_
 
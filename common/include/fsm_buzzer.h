@@ -17,11 +17,19 @@
 /* Other includes */
 #include <fsm.h>
 #include "melodies.h"
+#include "fsm_active.h"
+#include "buzzer_timing.h"
 
 /* HW dependent includes */
 
 
 /* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#ifndef FSM_BUZZER_POOL_SIZE
+#define FSM_BUZZER_POOL_SIZE 1  /*!<Number of buzzer melody player FSMs that can be created with `fsm_buzzer_new_static()`. It can be overridden at compile time*/
+#endif
+#define FSM_BUZZER_REBUILD_NOTES 4  /*!<Durations of a compiled melody rebuilt at each note after a change of speed*/
+
 /* Enums */
 /**
  * @brief Enumerator for the buzzer finite state machine.
@@ -59,11 +67,19 @@ typedef struct
     uint8_t buzzer_id;      /*!< Buzzer melody player ID */
     uint8_t user_action;    /*!< Action to perform on the player*/
     double player_speed;    /*!< Speed of the player*/
+    uint32_t note_count;    /*!< Number of notes started since the FSM was initialized. It wraps around when it overflows*/
+    double note_freq;       /*!< Frequency of the last note started, in Hz*/
+    uint8_t effect;         /*!< Pitch effect of the notes, one of `PORT_BUZZER_EFFECTS`*/
+    buzzer_timing_note_t *p_compiled;   /*!< Scratch buffer of the register values of the notes of the melody, or NULL to play the notes from their frequency and duration*/
+    uint32_t compiled_capacity;         /*!< Number of notes of the scratch buffer*/
+    bool compiled;                      /*!< True if the melody is compiled in the scratch buffer*/
+    uint32_t rebuild_start;             /*!< Note from which the durations are rebuilt, in order of play, after a change of speed*/
+    uint32_t rebuild_count;             /*!< Number of durations rebuilt at the current speed from `rebuild_start`*/
 } fsm_buzzer_t;
 
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
- * @brief Set the melody to play.
+ * @brief Set the melody to play. It is compiled at the current speed if there is a scratch buffer, see `fsm_buzzer_set_compile_buffer()`.
  * 
  * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
  * @param p_melody 
@@ -71,13 +87,38 @@ typedef struct
 void fsm_buzzer_set_melody (fsm_t *p_this, const melody_t *p_melody);
 
 /**
- * @brief Set the speed of the player.
+ * @brief Set the scratch buffer where `fsm_buzzer_set_melody()` compiles the melodies. A compiled melody has the register values of all its notes at the current speed, so each note is played with a sequential load and the stores to the timers. The melodies longer than the buffer are not compiled.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param p_buffer Scratch buffer, or NULL to stop compiling the melodies
+ * @param capacity Number of notes of the scratch buffer
+ */
+void fsm_buzzer_set_compile_buffer (fsm_t *p_this, buzzer_timing_note_t *p_buffer, uint32_t capacity);
+
+/**
+ * @brief Set the speed of the player. The note that is playing is rescaled with `port_buzzer_rescale_note_duration()`, so its remaining time takes the new speed without restarting it. If the melody is compiled, only its durations are rebuilt, `FSM_BUZZER_REBUILD_NOTES` at each note from the next one, so the change of speed takes constant time.
  * 
  * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
  * @param speed Speed of the player
  */
 void fsm_buzzer_set_speed (fsm_t *p_this, double speed);
 
+/**
+ * @brief Set the pitch effect of the notes: vibrato, or glide from the previous note. The effect runs on the timer and DMA of the port layer, so the player still only works per note. Every melody starts without glide.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param effect Pitch effect, one of `PORT_BUZZER_EFFECTS`
+ */
+void fsm_buzzer_set_effect (fsm_t *p_this, uint8_t effect);
+
+/**
+ * @brief Set the output of the notes: the square wave of the PWM timer, or the wavetable synthesis on the DAC. The note that is playing is silenced and the melody goes on with the next note on the new output.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param output Output, one of `PORT_BUZZER_OUTPUTS`
+ */
+void fsm_buzzer_set_output (fsm_t *p_this, uint8_t output);
+
 /**
  * @brief Set the action to perform on the player
  * 
@@ -86,6 +127,14 @@ void fsm_buzzer_set_speed (fsm_t *p_this, double speed);
  */
 void fsm_buzzer_set_action (fsm_t *p_this, uint8_t action);
 
+/**
+ * @brief Event function of the buzzer FSM for the dispatcher of `fsm_active`. The changes requested by other FSMs (`FSM_EVENT_ACTION`, `FSM_EVENT_MELODY`, `FSM_EVENT_SPEED`, `FSM_EVENT_EFFECT` and `FSM_EVENT_OUTPUT`) are applied with the setters of the buzzer, one per event, so they reach the player in the order they were posted. The other events only make the FSM check its guards.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param event Event posted to the buzzer FSM
+ */
+void fsm_buzzer_on_event (fsm_t *p_this, fsm_event_t event);
+
 /**
  * @brief Get the action of the user perform on the player
  * 
@@ -94,6 +143,15 @@ void fsm_buzzer_set_action (fsm_t *p_this, uint8_t action);
  */
 uint8_t fsm_buzzer_get_action (fsm_t *p_this);
 
+/**
+ * @brief Get the last note started by the player. The FSMs that listen to the buzzer with `fsm_active_listen()` detect the start of every note when the count changes.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param p_freq Pointer to store the frequency of the note in Hz. It may be NULL.
+ * @return uint32_t Number of notes started since the FSM was initialized
+ */
+uint32_t fsm_buzzer_get_note (fsm_t *p_this, double *p_freq);
+
 /**
  * @brief Creates a new buzzer FSM
  * 
@@ -102,6 +160,16 @@ uint8_t fsm_buzzer_get_action (fsm_t *p_this);
  */
 fsm_t * fsm_buzzer_new (uint32_t buzzer_id);
 
+/**
+ * @brief Create a new buzzer melody player FSM from a static pool of `FSM_BUZZER_POOL_SIZE` elements, without using the heap.
+ *
+ * @warning The FSM must not be passed to `fsm_destroy()`, because it has not been allocated with `malloc()`.
+ * 
+ * @param buzzer_id Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @return fsm_t* A pointer to the new buzzer finite state machine. NULL if the pool is exhausted.
+ */
+fsm_t * fsm_buzzer_new_static(uint32_t buzzer_id);
+
 /**
  * @brief Initialize a buzzer FSM
  * 
@@ -119,4 +187,12 @@ void fsm_buzzer_init (fsm_t *p_this, uint32_t buzzer_id);
  */
 bool fsm_buzzer_check_activity (fsm_t *p_this);
 
+/**
+ * @brief Fire the buzzer melody player FSM. It is equivalent to `fsm_fire()`, but the transitions table is compiled into a switch by `tools/fsm_codegen.py`, so only the transitions of the current state are checked and the guards and outputs are called directly.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @return int Position in the transitions table of the row fired. -1 if no guard is true.
+ */
+int fsm_buzzer_fire(fsm_t *p_this);
+
 #endif /* FSM_BUZZER_H_ */
\ No newline at end of file
@@ -0,0 +1,161 @@
+/**
+ * @file fsm_gesture.h
+ * @brief Header for fsm_gesture.c file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef FSM_GESTURE_H_
+#define FSM_GESTURE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include <fsm.h>
+#include "fsm_active.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define FSM_GESTURE_MAX_BUTTONS 4       /*!<Maximum number of buttons of a gesture FSM*/
+#define FSM_GESTURE_MAX_CLICKS 3        /*!<Number of clicks of the longest multi-click. It is reported as soon as its last click ends*/
+
+#ifndef FSM_GESTURE_POOL_SIZE
+#define FSM_GESTURE_POOL_SIZE 1  /*!<Number of gesture FSMs that can be created with `fsm_gesture_new_static()`. It can be overridden at compile time*/
+#endif
+
+/* Enums */
+/**
+ * @brief Enumerator that defines the different states that the gesture finite state machine can be in
+ *
+ */
+enum FSM_GESTURE {
+    GESTURE_IDLE = 0,           /*!<Starting state. All the buttons are released and no gesture is in progress*/
+    GESTURE_PRESSED,            /*!<State while any button is pressed and the hold time has not passed*/
+    GESTURE_HELD,               /*!<State while the buttons are held after reporting a press-and-hold*/
+    GESTURE_RELEASED_WAIT       /*!<State to wait for another click after a click*/
+};
+
+/**
+ * @brief Enumerator that defines the gestures recognized.
+ *
+ */
+enum FSM_GESTURE_TYPE {
+    GESTURE_NONE = 0,           /*!<No gesture*/
+    GESTURE_SINGLE_CLICK,       /*!<A press and release, not followed by another press within the click gap*/
+    GESTURE_DOUBLE_CLICK,       /*!<Two clicks of the same buttons*/
+    GESTURE_TRIPLE_CLICK,       /*!<Three clicks of the same buttons*/
+    GESTURE_HOLD,               /*!<A single button held for the hold time. It is reported while the button is still pressed*/
+    GESTURE_CHORD               /*!<Several buttons pressed at the same time. It is reported when all of them are released*/
+};
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Gesture FSM structure. It recognizes gestures from the states of one or more button FSMs, whose presses and releases are already debounced by the port layer.
+ *
+ */
+typedef struct
+{
+    fsm_t f;                                            /*!<Gesture FSM*/
+    fsm_t *p_fsm_buttons[FSM_GESTURE_MAX_BUTTONS];      /*!<Pointers to the button FSMs. Button `i` is bit `i` of the masks*/
+    uint32_t num_buttons;                               /*!<Number of buttons*/
+    uint32_t click_gap_ms;                              /*!<Maximum time in ms between the release of a click and the press of the next one*/
+    uint32_t hold_time_ms;                              /*!<Time in ms a button must be held to report a press-and-hold*/
+    uint32_t buttons;                                   /*!<Mask of the buttons pressed during the gesture in progress*/
+    uint32_t clicks;                                    /*!<Clicks of the gesture in progress*/
+    uint32_t deadline_ms;                               /*!<System time in ms of the hold time or the end of the click gap. It is the only timer of all the buttons*/
+    uint32_t gesture;                                   /*!<Last gesture recognized, one of `FSM_GESTURE_TYPE`. `GESTURE_NONE` once it is cleared*/
+    uint32_t gesture_buttons;                           /*!<Mask of the buttons of the last gesture recognized*/
+} fsm_gesture_t;
+
+/* Function prototypes and explanation ---------------------------------------*/
+/**
+ * @brief Create a new gesture FSM.
+ *
+ * @param pp_fsm_buttons Array of pointers to the button FSMs
+ * @param num_buttons Number of buttons. At most `FSM_GESTURE_MAX_BUTTONS`, the rest are ignored.
+ * @param click_gap_ms Maximum time in ms between the release of a click and the press of the next one
+ * @param hold_time_ms Time in ms a button must be held to report a press-and-hold
+ * @return fsm_t* A pointer to the gesture FSM
+ */
+fsm_t * fsm_gesture_new(fsm_t **pp_fsm_buttons, uint32_t num_buttons, uint32_t click_gap_ms, uint32_t hold_time_ms);
+
+/**
+ * @brief Create a new gesture FSM from a static pool of `FSM_GESTURE_POOL_SIZE` elements, without using the heap.
+ *
+ * @warning The FSM must not be passed to `fsm_destroy()`, because it has not been allocated with `malloc()`.
+ *
+ * @param pp_fsm_buttons Array of pointers to the button FSMs
+ * @param num_buttons Number of buttons. At most `FSM_GESTURE_MAX_BUTTONS`, the rest are ignored.
+ * @param click_gap_ms Maximum time in ms between the release of a click and the press of the next one
+ * @param hold_time_ms Time in ms a button must be held to report a press-and-hold
+ * @return fsm_t* A pointer to the gesture FSM. NULL if the pool is exhausted.
+ */
+fsm_t * fsm_gesture_new_static(fsm_t **pp_fsm_buttons, uint32_t num_buttons, uint32_t click_gap_ms, uint32_t hold_time_ms);
+
+/**
+ * @brief Initialize a gesture FSM.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t struct
+ * @param pp_fsm_buttons Array of pointers to the button FSMs
+ * @param num_buttons Number of buttons. At most `FSM_GESTURE_MAX_BUTTONS`, the rest are ignored.
+ * @param click_gap_ms Maximum time in ms between the release of a click and the press of the next one
+ * @param hold_time_ms Time in ms a button must be held to report a press-and-hold
+ */
+void fsm_gesture_init(fsm_t *p_this, fsm_t **pp_fsm_buttons, uint32_t num_buttons, uint32_t click_gap_ms, uint32_t hold_time_ms);
+
+/**
+ * @brief Get the last gesture recognized. It is kept until `fsm_gesture_clear()` is called or another gesture is recognized.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t struct
+ * @param p_buttons Pointer to store the mask of the buttons of the gesture. It may be NULL.
+ * @return uint32_t Gesture, one of `FSM_GESTURE_TYPE`
+ */
+uint32_t fsm_gesture_get(fsm_t *p_this, uint32_t *p_buttons);
+
+/**
+ * @brief Clear the last gesture recognized, once it has been handled.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t struct
+ */
+void fsm_gesture_clear(fsm_t *p_this);
+
+/**
+ * @brief Event function of the gesture FSM for `fsm_active_register()`. On every transition of a button FSM it adds the buttons pressed to the gesture in progress, so a chord is recognized even if its buttons are not pressed in the same dispatch.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t struct
+ * @param event Event received
+ */
+void fsm_gesture_on_event(fsm_t *p_this, fsm_event_t event);
+
+/**
+ * @brief Check whether a gesture is in progress. The FSM only needs to be fired on the transitions of the buttons, or while a gesture waits for its deadline.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t struct
+ * @return true
+ * @return false
+ */
+bool fsm_gesture_check_activity(fsm_t *p_this);
+
+/**
+ * @brief Get the system time at which the gesture FSM must be fired again: the end of the hold time or of the click gap.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t struct
+ * @param p_deadline_ms Pointer to store the deadline in ms, in the time base of `port_system_get_millis()`
+ * @return true if the FSM has a deadline
+ * @return false otherwise
+ */
+bool fsm_gesture_get_deadline(fsm_t *p_this, uint32_t *p_deadline_ms);
+
+/**
+ * @brief Fire the gesture FSM. It is equivalent to `fsm_fire()`, but the transitions table is compiled into a switch by `tools/fsm_codegen.py`, so only the transitions of the current state are checked and the guards and outputs are called directly.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_gesture_t struct
+ * @return int Position in the transitions table of the row fired. -1 if no guard is true.
+ */
+int fsm_gesture_fire(fsm_t *p_this);
+
+#endif /* FSM_GESTURE_H_ */
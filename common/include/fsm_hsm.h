@@ -0,0 +1,78 @@
+/**
+ * @file fsm_hsm.h
+ * @brief Header for fsm_hsm.c file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef FSM_HSM_H_
+#define FSM_HSM_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include <fsm.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define FSM_HSM_NO_PARENT -1        /*!<Parent of a top-level state*/
+#define FSM_HSM_INTERNAL -2         /*!<Destination of an internal transition: the output is called and the FSM stays in its current state, without exit or entry actions*/
+#define FSM_HSM_MAX_DEPTH 4         /*!<Maximum number of nested states, including the leaf state*/
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief State of a hierarchical state machine.
+ *
+ * The hierarchy of an FSM is a table of these states ended by `{-1, -1, NULL, NULL}`. The states not listed are top-level states without entry or exit actions. The FSM is always in a leaf state: the superstates only group the transitions and actions shared by their substates.
+ *
+ */
+typedef struct
+{
+    int state;                  /*!<State*/
+    int parent;                 /*!<Superstate that contains it. `FSM_HSM_NO_PARENT` if it is a top-level state*/
+    void (*entry)(fsm_t *);     /*!<Action when the state is entered. It may be NULL*/
+    void (*exit)(fsm_t *);      /*!<Action when the state is left. It may be NULL*/
+} fsm_hsm_state_t;
+
+/* Function prototypes and explanation ---------------------------------------*/
+/**
+ * @brief Fire a hierarchical state machine. It is the reference engine for the tables with superstates, as `fsm_fire()` is for the flat tables, and the generated dispatch of `tools/fsm_codegen.py` behaves exactly as it.
+ *
+ * > 1. **Check the rows of the current state** in table order, then the rows of its superstate, and so on up to the top-level state. The first row whose guard is true is fired. \n
+ * > 2. If the destination is `FSM_HSM_INTERNAL`, **only the output is called**. \n
+ * > 3. Otherwise, **call the exit actions** from the current state up to the common ancestor of the current and the destination states (not included), **update the state**, **call the output**, and **call the entry actions** from below the common ancestor down to the destination state.
+ *
+ * A transition to the current state runs no exit or entry actions, as in a flat FSM. The destination of a transition must be a leaf state.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @param p_tt Pointer to the transitions table. The rows of a superstate use it as origin state.
+ * @param p_states Pointer to the table of states
+ * @return int Position in the transitions table of the row fired. -1 if no guard is true.
+ */
+int fsm_hsm_fire(fsm_t *p_fsm, fsm_trans_t *p_tt, const fsm_hsm_state_t *p_states);
+
+/**
+ * @brief Get the superstate of a state.
+ *
+ * @param p_states Pointer to the table of states
+ * @param state State
+ * @return int Superstate. `FSM_HSM_NO_PARENT` if it is a top-level state.
+ */
+int fsm_hsm_get_parent(const fsm_hsm_state_t *p_states, int state);
+
+/**
+ * @brief Check if a state is a given state or one of its substates, at any depth.
+ *
+ * @param p_states Pointer to the table of states
+ * @param state State to check, usually the current state of the FSM
+ * @param ancestor State or superstate
+ * @return true if `state` is `ancestor` or is contained in it
+ * @return false otherwise
+ */
+bool fsm_hsm_is_in(const fsm_hsm_state_t *p_states, int state, int ancestor);
+
+#endif /* FSM_HSM_H_ */
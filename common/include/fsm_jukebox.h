@@ -19,6 +19,14 @@
 /* Defines and enums ----------------------------------------------------------*/
 /* Defines */
 #define MELODIES_MEMORY_SIZE 10  /*!<Size of the arrays of melodies*/
+#define JUKEBOX_COMMAND_SEPARATOR ";"   /*!<Separator between the commands of a batch received in a single line*/
+#define JUKEBOX_MAX_BATCH_COMMANDS 8    /*!<Maximum number of commands executed from a single line*/
+#define JUKEBOX_REPLY_SEPARATOR "; "    /*!<Separator between the replies of the commands of a batch*/
+#define JUKEBOX_REPLY_OVERFLOW "..."    /*!<Marker at the end of the reply of a batch that does not fit in the output buffer of the USART*/
+
+#ifndef FSM_JUKEBOX_POOL_SIZE
+#define FSM_JUKEBOX_POOL_SIZE 1  /*!<Number of Jukebox FSMs that can be created with `fsm_jukebox_new_static()`. It can be overridden at compile time*/
+#endif
 
 /* Enums */
 /**
@@ -30,11 +38,26 @@ enum FSM_JUKEBOX {
   START_UP,         /*!<State to play the intro melody and initialize the Jukebox*/
   WAIT_COMMAND,     /*!<State to wait for a command from the USART*/
   SHUT_DOWN,        /*!<State to play de outro melody to turn off the jukebox*/
-  SLEEP_WHILE_OFF,  /*!<State to start the low power mode while the Jukebox is OFF*/
-  SLEEP_WHILE_ON    /*!<State to start the low power mode while the Jukebox is ON*/
+  LOW_POWER         /*!<Superstate of OFF and WAIT_COMMAND, in which the low power mode is started while all the elements are inactive. The FSM is never in this state*/
 };
 
 /* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Snapshot of the inputs of the Jukebox FSM. All the guards read it, so the elements of the system are checked once per snapshot and every guard of a fire sees the same view of them.
+ * 
+ */
+typedef struct
+{
+    uint32_t epoch;             /*!<Epoch of the dispatcher when the snapshot was taken. The snapshot is taken again when it changes*/
+    bool valid;                 /*!<False if the snapshot must be taken again before it is read*/
+    bool activity;              /*!<True if any element of the system needs the CPU. The button does not: it only needs an interrupt, or a wakeup at its deadline*/
+    bool command_received;      /*!<True if the USART has received a command*/
+    bool melody_finished;       /*!<True if the action of the buzzer is STOP*/
+    uint32_t button_duration;   /*!<Duration in ms of the last button press*/
+    uint32_t button_held;       /*!<Time in ms the button has been held so far, while it is pressed*/
+    uint32_t gesture;           /*!<Last gesture of the buttons not handled yet, one of `FSM_GESTURE_TYPE`*/
+} fsm_jukebox_inputs_t;
+
 /**
  * @brief This structure contains the information of a melody, including the name of the melody and the melody itself.
  * 
@@ -53,6 +76,9 @@ typedef struct
     double speed;                               /*!<Speed of the melody playing*/
     fsm_t *p_fsm_led0;                          /*!<Pointer to the LED 0 FSM*/
     fsm_t *p_fsm_led1;                          /*!<Pointer to the LED 1 FSM*/
+    fsm_t *p_fsm_telemetry;                     /*!<Pointer to the telemetry FSM. NULL if the system has no telemetry*/
+    fsm_t *p_fsm_gesture;                       /*!<Pointer to the gesture FSM. NULL if the system does not recognize gestures*/
+    fsm_jukebox_inputs_t inputs;                /*!<Snapshot of the inputs read by the guards*/
 } fsm_jukebox_t ;
 
 /* Function prototypes and explanation ---------------------------------------*/
@@ -69,6 +95,20 @@ typedef struct
  */
 fsm_t * fsm_jukebox_new(fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t *p_fsm_usart, fsm_t *p_fsm_buzzer, uint32_t next_song_press_time_ms, fsm_t *p_fsm_led0, fsm_t *p_fsm_led1);	
 
+/**
+ * @brief Create a new Jukebox FSM from a static pool of `FSM_JUKEBOX_POOL_SIZE` elements, without using the heap.
+ *
+ * @warning The FSM must not be passed to `fsm_destroy()`, because it has not been allocated with `malloc()`.
+ * 
+ * @param p_fsm_button Pointer to the button FSM
+ * @param on_off_press_time_ms 	Button press time in milliseconds to turn the system ON or OFF
+ * @param p_fsm_usart Pointer to the USART FSM
+ * @param p_fsm_buzzer 	Pointer to the buzzer FSM.
+ * @param next_song_press_time_ms Button press time in milliseconds to change to the next song.
+ * @return fsm_t* A pointer to the Jukebox FSM. NULL if the pool is exhausted.
+ */
+fsm_t * fsm_jukebox_new_static(fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t *p_fsm_usart, fsm_t *p_fsm_buzzer, uint32_t next_song_press_time_ms, fsm_t *p_fsm_led0, fsm_t *p_fsm_led1);
+
 /**
  * @brief Initialize a Jukebox FSM
  * 
@@ -82,4 +122,35 @@ fsm_t * fsm_jukebox_new(fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_
  */
 void fsm_jukebox_init(fsm_t *p_this, fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t *p_fsm_usart, fsm_t *p_fsm_buzzer, uint32_t next_song_press_time_ms, fsm_t *p_fsm_led0, fsm_t *p_fsm_led1);	
 
+/**
+ * @brief Attach a telemetry FSM to the Jukebox, so that the host can subscribe to it with the `telemetry` command.
+ * 
+ * @param p_this Pointer to the Jukebox FSM
+ * @param p_fsm_telemetry Pointer to the telemetry FSM
+ */
+void fsm_jukebox_set_telemetry(fsm_t *p_this, fsm_t *p_fsm_telemetry);
+
+/**
+ * @brief Attach a gesture FSM to the Jukebox. A double click pauses or resumes the melody while the Jukebox is ON.
+ * 
+ * @param p_this Pointer to the Jukebox FSM
+ * @param p_fsm_gesture Pointer to the gesture FSM
+ */
+void fsm_jukebox_set_gesture(fsm_t *p_this, fsm_t *p_fsm_gesture);
+
+/**
+ * @brief Discard the snapshot of the inputs, so that the next fire takes a new one. The dispatcher makes it unnecessary, because its epoch changes on every dispatch and every transition. It is only needed when the Jukebox is fired directly and its inputs are changed between fires, as in the tests.
+ * 
+ * @param p_this Pointer to the Jukebox FSM
+ */
+void fsm_jukebox_invalidate_inputs(fsm_t *p_this);
+
+/**
+ * @brief Fire the Jukebox FSM. It is equivalent to `fsm_fire()`, but the transitions table is compiled into a switch by `tools/fsm_codegen.py`, so only the transitions of the current state are checked and the guards and outputs are called directly.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_jukebox_t struct
+ * @return int Position in the transitions table of the row fired. -1 if no guard is true.
+ */
+int fsm_jukebox_fire(fsm_t *p_this);
+
 #endif /* FSM_JUKEBOX_H_ */
\ No newline at end of file
@@ -18,6 +18,12 @@
 #include "fsm.h"
 
 /* Defines -------------------------------------------------------------------*/
+#ifndef FSM_LED_POOL_SIZE
+#define FSM_LED_POOL_SIZE 2  /*!<Number of LED FSMs that can be created with `fsm_led_new_static()`. It can be overridden at compile time*/
+#endif
+#define FSM_LED_PITCH_MIN_HZ 130.813    /*!<Frequency of the dimmest note in the pitch mode (DO3). The lower notes are shown with the same brightness*/
+#define FSM_LED_PITCH_OCTAVES 4.0       /*!<Octaves from the dimmest note to the brightest one in the pitch mode*/
+
 /**
  * @brief Enumerator that defines the different states the finite state machine can be in.
  * 
@@ -27,6 +33,15 @@ enum FSM_LED{
     LED_ON,       /*!<The LED is on*/
 };
 
+/**
+ * @brief Enumerator that defines how the visualizer shows the notes of the melody on the LED.
+ * 
+ */
+enum FSM_LED_MODE{
+    LED_MODE_PULSE = 0, /*!<A pulse of full brightness that fades out on every note, i.e. on the beat. The silences give no pulse*/
+    LED_MODE_PITCH,     /*!<A steady brightness for each note that grows with its pitch. The silences turn the LED off*/
+};
+
 /* Typedefs ------------------------------------------------------------------*/
 /**
  * @brief LED FSM structure 
@@ -36,6 +51,9 @@ typedef struct{
     fsm_t f;            /*!< Internal FSM from the library */
     uint32_t led_id;    /*!< LED ID*/
     bool is_illuminated;    /*!<Flag that indicates that the LED has been pressed*/
+    fsm_t *p_fsm_buzzer;    /*!< Pointer to the buzzer FSM whose notes are shown. NULL if the visualizer is not set*/
+    uint32_t mode;          /*!< Mode of the visualizer, one of `FSM_LED_MODE`*/
+    uint32_t note_count;    /*!< Count of notes of the buzzer FSM of the last note shown*/
 } fsm_led_t;
 
 /* Function prototypes and documentation ---------------------------------------*/
@@ -47,6 +65,17 @@ typedef struct{
  */
 fsm_t* fsm_led_new(uint32_t led_id);
 
+/**
+ * @brief Create a new LED FSM from a static pool of `FSM_LED_POOL_SIZE` elements, without using the heap.
+ *
+ * @warning The FSM must not be passed to `fsm_destroy()`, because it has not been allocated with `malloc()`.
+ *
+ * @param led_id Unique LED identifier number.
+ *
+ * @return fsm_t Pointer to the LED FSM. NULL if the pool is exhausted.
+ */
+fsm_t * fsm_led_new_static(uint32_t led_id);
+
 /**
  * @brief Initializes all the parameters of the LED FSM.
  *
@@ -55,6 +84,17 @@ fsm_t* fsm_led_new(uint32_t led_id);
  */
 void fsm_led_init(fsm_t *p_this, uint32_t led_id);
 
+/**
+ * @brief Set the LED FSM as a visualizer of the notes of a buzzer FSM. The LED is on while the player plays, and each note is shown according to the mode. The patterns are played by the visualizer timer and DMA of the port layer, so there is no work per note but starting them.
+ *
+ * @note The LED FSM must listen to the buzzer FSM with `fsm_active_listen()`, so that it is fired when a note starts.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_led_t.
+ * @param p_fsm_buzzer Pointer to the buzzer FSM. NULL turns the visualizer off.
+ * @param mode Mode of the visualizer, one of `FSM_LED_MODE`
+ */
+void fsm_led_set_visualizer(fsm_t *p_this, fsm_t *p_fsm_buzzer, uint32_t mode);
+
 /** 
  * @brief Check if the LED is on
  * @param p_this Pointer to an fsm_t struct than contains an fsm_led_t.
@@ -77,5 +117,13 @@ void fsm_led_turn_on(uint32_t led_id);
  */
 void fsm_led_turn_off(uint32_t led_id);
 
+/**
+ * @brief Fire the LED FSM. It is equivalent to `fsm_fire()`, but the transitions table is compiled into a switch by `tools/fsm_codegen.py`, so only the transitions of the current state are checked and the guards and outputs are called directly.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_led_t struct
+ * @return int Position in the transitions table of the row fired. -1 if no guard is true.
+ */
+int fsm_led_fire(fsm_t *p_this);
+
 #endif 
 
@@ -0,0 +1,41 @@
+/**
+ * @file fsm_pool.h
+ * @brief Static pools of FSMs, shared by the `fsm_xxx_new_static()` functions.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef FSM_POOL_H_
+#define FSM_POOL_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stddef.h>
+
+/* Other includes */
+#include <fsm.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+/**
+ * @brief Define a static pool of FSMs and the private function that takes them from it.
+ *
+ * It defines the array `<name>_pool` of `size` structures of type `type`, the number of them already in use `<name>_pool_used`, and `fsm_t *<name>_pool_take(void)`, which returns the next free structure, or NULL if the pool is exhausted. The structures are never given back, so the FSMs of the pool must not be passed to `fsm_destroy()`.
+ *
+ * @param name Prefix of the names, e.g. `fsm_button`
+ * @param type Type of the FSM structure, whose first member is an `fsm_t`
+ * @param size Number of structures of the pool, usually an `FSM_XXX_POOL_SIZE` that can be overridden at compile time
+ */
+#define FSM_POOL_DEFINE(name, type, size)                               \
+    static type name##_pool[size];                                      \
+    static uint32_t name##_pool_used = 0;                               \
+    static fsm_t *name##_pool_take(void){                               \
+        if (name##_pool_used >= (size)){                                \
+            return NULL;                                                \
+        }                                                               \
+        return (fsm_t *)(&name##_pool[name##_pool_used++]);             \
+    }
+
+#endif /* FSM_POOL_H_ */
@@ -0,0 +1,148 @@
+/**
+ * @file fsm_telemetry.h
+ * @brief Header for fsm_telemetry.c file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef FSM_TELEMETRY_H_
+#define FSM_TELEMETRY_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include <fsm.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define TELEMETRY_MIN_PERIOD_MS 50      /*!<Minimum period between frames in ms. A frame takes about 26 ms at 9600 bauds*/
+#define TELEMETRY_SYNC_0 0xA5           /*!<First synchronization byte of a frame*/
+#define TELEMETRY_SYNC_1 0x5A           /*!<Second synchronization byte of a frame*/
+
+/**
+ * @brief Layout of a telemetry frame. All the multi-byte fields are little endian.
+ *
+ * | Byte  | Field |
+ * | ----- | ----- |
+ * | 0-1   | Synchronization bytes `TELEMETRY_SYNC_0` and `TELEMETRY_SYNC_1` |
+ * | 2     | Sequence number |
+ * | 3     | State of the Jukebox FSM |
+ * | 4     | State of the button FSM |
+ * | 5     | State of the USART FSM |
+ * | 6     | State of the buzzer FSM |
+ * | 7     | State of the LED FSMs (bit 0: LED 0, bit 1: LED 1) |
+ * | 8     | User action of the buzzer |
+ * | 9-10  | Index of the note playing |
+ * | 11-12 | Speed of the player x100 |
+ * | 13    | Queue depth: bytes of the USART input buffer waiting for the end of line |
+ * | 14-17 | Loop iterations per second |
+ * | 18-19 | Button interrupts since the previous frame |
+ * | 20-21 | USART interrupts since the previous frame |
+ * | 22-23 | Note duration timer interrupts since the previous frame |
+ * | 24    | Checksum: two's complement of the sum of bytes 2-23 |
+ */
+#define TELEMETRY_FRAME_LENGTH 25
+
+#ifndef FSM_TELEMETRY_POOL_SIZE
+#define FSM_TELEMETRY_POOL_SIZE 1  /*!<Number of telemetry FSMs that can be created with `fsm_telemetry_new_static()`. It can be overridden at compile time*/
+#endif
+
+/* Enums */
+/**
+ * @brief Enumerator that defines the different states that the telemetry finite state machine can be in
+ *
+ */
+enum FSM_TELEMETRY {
+    TELEMETRY_IDLE = 0,     /*!<Starting state. Also comes here when the host unsubscribes from the stream*/
+    TELEMETRY_STREAMING     /*!<State to send a frame every period*/
+};
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Telemetry FSM structure
+ *
+ */
+typedef struct
+{
+    fsm_t f;                                    /*!<Telemetry FSM*/
+    fsm_t *p_fsm_jukebox;                       /*!<Pointer to the Jukebox FSM. The other FSMs are reached through it*/
+    uint32_t period_ms;                         /*!<Period between frames in ms. 0 if the host is not subscribed*/
+    uint32_t next_frame_ms;                     /*!<System time in ms when the next frame is due*/
+    uint32_t last_frame_ms;                     /*!<System time in ms when the previous frame was sent*/
+    uint32_t loop_count;                        /*!<Loop iterations since the previous frame*/
+    uint32_t isr_count_button;                  /*!<Button interrupts when the previous frame was sent*/
+    uint32_t isr_count_usart;                   /*!<USART interrupts when the previous frame was sent*/
+    uint32_t isr_count_buzzer;                  /*!<Note duration timer interrupts when the previous frame was sent*/
+    uint8_t seq;                                /*!<Sequence number of the next frame*/
+    uint8_t frame[TELEMETRY_FRAME_LENGTH];      /*!<Last frame built*/
+} fsm_telemetry_t;
+
+/* Function prototypes and explanation ---------------------------------------*/
+/**
+ * @brief Create a new telemetry FSM.
+ *
+ * The telemetry FSM is a low priority task: it must be fired once per iteration of the main loop, after all the other FSMs.
+ *
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @return fsm_t* A pointer to the telemetry FSM
+ */
+fsm_t * fsm_telemetry_new(fsm_t *p_fsm_jukebox);
+
+/**
+ * @brief Create a new telemetry FSM from a static pool of `FSM_TELEMETRY_POOL_SIZE` elements, without using the heap.
+ *
+ * @warning The FSM must not be passed to `fsm_destroy()`, because it has not been allocated with `malloc()`.
+ *
+ * The telemetry FSM is a low priority task: it must be fired once per iteration of the main loop, after all the other FSMs.
+ *
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @return fsm_t* A pointer to the telemetry FSM. NULL if the pool is exhausted.
+ */
+fsm_t * fsm_telemetry_new_static(fsm_t *p_fsm_jukebox);
+
+/**
+ * @brief Initialize a telemetry FSM.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_telemetry_t struct
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ */
+void fsm_telemetry_init(fsm_t *p_this, fsm_t *p_fsm_jukebox);
+
+/**
+ * @brief Subscribe to the stream with a given period, or unsubscribe from it.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_telemetry_t struct
+ * @param period_ms Period between frames in ms. It is rounded up to TELEMETRY_MIN_PERIOD_MS. 0 to unsubscribe.
+ */
+void fsm_telemetry_set_period(fsm_t *p_this, uint32_t period_ms);
+
+/**
+ * @brief Get the period between frames.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_telemetry_t struct
+ * @return uint32_t Period between frames in ms. 0 if the host is not subscribed.
+ */
+uint32_t fsm_telemetry_get_period(fsm_t *p_this);
+
+/**
+ * @brief Check whether the telemetry FSM is streaming. The system must not sleep while streaming, otherwise the frames would stop.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_telemetry_t struct
+ * @return true
+ * @return false
+ */
+bool fsm_telemetry_check_activity(fsm_t *p_this);
+
+/**
+ * @brief Fire the telemetry FSM. It is equivalent to `fsm_fire()`, but the transitions table is compiled into a switch by `tools/fsm_codegen.py`, so only the transitions of the current state are checked and the guards and outputs are called directly.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_telemetry_t struct
+ * @return int Position in the transitions table of the row fired. -1 if no guard is true.
+ */
+int fsm_telemetry_fire(fsm_t *p_this);
+
+#endif /* FSM_TELEMETRY_H_ */
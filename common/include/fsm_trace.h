@@ -0,0 +1,110 @@
+/**
+ * @file fsm_trace.h
+ * @brief Header for fsm_trace.c file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef FSM_TRACE_H_
+#define FSM_TRACE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Other includes */
+#include <fsm.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#ifndef FSM_TRACE_ENABLED
+#define FSM_TRACE_ENABLED 1             /*!<Set it to 0 (`-DFSM_TRACE_ENABLED=0`) to compile out the recording of the transitions*/
+#endif
+#ifndef FSM_TRACE_SIZE
+#define FSM_TRACE_SIZE 64               /*!<Number of transitions kept in the ring. It must be a power of 2*/
+#endif
+#define FSM_TRACE_DUMP_ENTRIES 4        /*!<Number of transitions in a dump*/
+#define FSM_TRACE_DUMP_LENGTH 86        /*!<Length of the text of a dump, including the null terminator*/
+
+/* Enums */
+/**
+ * @brief Enumerator that identifies the FSMs in the trace. Keep it in sync with `tools/fsm_trace_timeline.py`.
+ *
+ */
+enum FSM_TRACE_ID {
+    FSM_TRACE_ID_BUTTON = 0,        /*!<Button FSM*/
+    FSM_TRACE_ID_USART,             /*!<USART FSM*/
+    FSM_TRACE_ID_BUZZER,            /*!<Buzzer FSM*/
+    FSM_TRACE_ID_JUKEBOX,           /*!<Jukebox FSM*/
+    FSM_TRACE_ID_LED_0,             /*!<FSM of LED 0*/
+    FSM_TRACE_ID_LED_1,             /*!<FSM of LED 1*/
+    FSM_TRACE_ID_TELEMETRY,         /*!<Telemetry FSM*/
+    FSM_TRACE_ID_GESTURE,           /*!<Gesture FSM*/
+    FSM_TRACE_NUM_IDS               /*!<Number of FSMs that can be traced*/
+};
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Transition recorded in the trace.
+ *
+ */
+typedef struct
+{
+    uint32_t millis;    /*!<System time when the transition was fired, in ms*/
+    uint8_t fsm_id;     /*!<FSM that fired the transition, one of `FSM_TRACE_ID`*/
+    uint8_t from;       /*!<State before the transition*/
+    uint8_t to;         /*!<State after the transition*/
+    uint8_t row;        /*!<Position of the transition in the transitions table of the FSM*/
+} fsm_trace_entry_t;
+
+/* Function prototypes and explanation ---------------------------------------*/
+/**
+ * @brief Record a transition in the ring, overwriting the oldest one if it is full.
+ *
+ * A self-transition that repeats the last row recorded for the same FSM is not recorded again, so the rows that fire on every iteration of the main loop (such as the frame counter of the telemetry or the sleep of the Jukebox) do not flush the ring.
+ *
+ * There is a single writer (the main loop), so the ring needs no lock: the entry is written before the head is advanced.
+ *
+ * @param fsm_id FSM identifier, one of `FSM_TRACE_ID`
+ * @param from State before the transition
+ * @param to State after the transition
+ * @param row Position of the transition in the transitions table of the FSM
+ */
+void fsm_trace_record(uint32_t fsm_id, int from, int to, int row);
+
+/**
+ * @brief Clear the ring.
+ *
+ */
+void fsm_trace_reset(void);
+
+/**
+ * @brief Get the total number of transitions recorded since the last reset. It is also the sequence number of the next transition.
+ *
+ * @return uint32_t Number of transitions recorded
+ */
+uint32_t fsm_trace_get_head(void);
+
+/**
+ * @brief Get a transition of the ring by its sequence number.
+ *
+ * @param seq Sequence number of the transition
+ * @param p_entry Pointer to store the transition
+ * @return true if the transition is still in the ring
+ * @return false if it has been overwritten or not recorded yet
+ */
+bool fsm_trace_get_entry(uint32_t seq, fsm_trace_entry_t *p_entry);
+
+/**
+ * @brief Write up to `FSM_TRACE_DUMP_ENTRIES` transitions as a single line of text, to be sent through the USART and decoded by `tools/fsm_trace_timeline.py`.
+ *
+ * The format is `TRC<first> <head> <entries>`, where the sequence number of the first transition and the head are 8 hex digits and each entry is 16 hex digits without separators: time in ms (8), FSM id (2), from (2), to (2) and row (2). If `seq` has already been overwritten, the dump starts at the oldest transition in the ring.
+ *
+ * @param seq Sequence number of the first transition to dump
+ * @param p_text Pointer to store the text. It must be at least `FSM_TRACE_DUMP_LENGTH` long.
+ */
+void fsm_trace_dump(uint32_t seq, char *p_text);
+
+#endif /* FSM_TRACE_H_ */
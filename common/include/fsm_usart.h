@@ -21,6 +21,11 @@
 #include "port_usart.h"
 
 /* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#ifndef FSM_USART_POOL_SIZE
+#define FSM_USART_POOL_SIZE 1  /*!<Number of USART FSMs that can be created with `fsm_usart_new_static()`. It can be overridden at compile time*/
+#endif
+
 /* Enums */
 /**
  * @brief Enumerates the states that the USART finite state machine can be in.
@@ -41,6 +46,7 @@ typedef struct
     bool data_received;                         /*!<Flag to indicate that a data has been received*/
     char in_data [USART_INPUT_BUFFER_LENGTH];   /*!<Input data*/
     char out_data [USART_OUTPUT_BUFFER_LENGTH]; /*!<Output data*/
+    uint8_t out_length;                         /*!<Length of the output data in binary mode. 0 if the output data is a text message*/
     uint8_t usart_id;                           /*!<Unique USART identifier number*/
 } fsm_usart_t ;
 
@@ -53,6 +59,16 @@ typedef struct
 */
 fsm_t * fsm_usart_new (uint32_t usart_id);
 
+/**
+ * @brief Create a new USART FSM from a static pool of `FSM_USART_POOL_SIZE` elements, without using the heap.
+ *
+ * @warning The FSM must not be passed to `fsm_destroy()`, because it has not been allocated with `malloc()`.
+ *
+ * @param usart_id	Unique USART identifier number.
+ * @return A pointer to the USART FSM. NULL if the pool is exhausted.
+*/
+fsm_t * fsm_usart_new_static(uint32_t usart_id);
+
 /**
  * @brief Initialize a USART FSM.
  * @param p_this	Pointer to an fsm_t struct than contains an fsm_usart_t struct.
@@ -82,6 +98,25 @@ void fsm_usart_get_in_data (fsm_t *p_this, char *p_data);
 */
 void fsm_usart_set_out_data (fsm_t *p_this, char *p_data);
 
+/**
+ * @brief Set a binary frame to send by the USART.
+ * 
+ * Unlike `fsm_usart_set_out_data()`, the frame is sent byte by byte up to `length`, so it may contain EMPTY_BUFFER_CONSTANT and END_CHAR_CONSTANT values. The first byte of the frame must not be EMPTY_BUFFER_CONSTANT.
+ * 
+ * @param p_this	Pointer to an fsm_t struct than contains an fsm_usart_t struct.
+ * @param p_data	Pointer to the frame to copy to the out_data array.
+ * @param length	Length of the frame. It must not be greater than USART_OUTPUT_BUFFER_LENGTH.
+*/
+void fsm_usart_set_out_frame (fsm_t *p_this, const uint8_t *p_data, uint32_t length);
+
+/**
+ * @brief Check whether the USART can accept new output data without overwriting a message that has not been sent yet.
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_usart_t struct.
+ * @return true if the USART is waiting and there is no output data pending
+ * @return false otherwise
+*/
+bool fsm_usart_check_tx_idle (fsm_t *p_this);
+
 /**
  * @brief Reset the input data buffer.
  * @param p_this  
@@ -121,5 +156,13 @@ void fsm_usart_enable_rx_interrupt (fsm_t *p_this);
 void fsm_usart_enable_tx_interrupt (fsm_t *p_this);
 
 
+/**
+ * @brief Fire the USART FSM. It is equivalent to `fsm_fire()`, but the transitions table is compiled into a switch by `tools/fsm_codegen.py`, so only the transitions of the current state are checked and the guards and outputs are called directly.
+ *
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_usart_t struct
+ * @return int Position in the transitions table of the row fired. -1 if no guard is true.
+ */
+int fsm_usart_fire(fsm_t *p_this);
+
 #endif /* FSM_USART_H_ */
 
@@ -0,0 +1,115 @@
+/**
+ * @file latency_trace.h
+ * @brief Header for latency_trace.c file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef LATENCY_TRACE_H_
+#define LATENCY_TRACE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define LATENCY_HISTOGRAM_BUCKETS 16    /*!<Number of buckets of each histogram. Bucket k counts latencies in [2^k, 2^(k+1)) us, bucket 0 also counts 0 us and the last bucket counts everything above*/
+#define LATENCY_DUMP_LENGTH 84          /*!<Length of the text of a dump, including the null terminator*/
+
+/* Enums */
+/**
+ * @brief Enumerator that defines the trace points of a command, in the order in which they are reached.
+ *
+ */
+enum LATENCY_STAGE {
+    LATENCY_STAGE_RX_ISR = 0,       /*!<End char stored by the USART ISR (`port_usart_store_data()`)*/
+    LATENCY_STAGE_USART_RX,         /*!<Message read from the port layer by the USART FSM (`do_get_data_rx()`)*/
+    LATENCY_STAGE_READ_COMMAND,     /*!<Message read by the Jukebox FSM (`do_read_command()`)*/
+    LATENCY_STAGE_EXECUTE,          /*!<Command executed by the Jukebox FSM (`_execute_command()`). In a batch, the last command is kept*/
+    LATENCY_STAGE_REG_WRITE,        /*!<PWM timer reprogrammed by the buzzer (`port_buzzer_set_note_frequency()` or `port_buzzer_stop()`)*/
+    LATENCY_NUM_STAGES              /*!<Number of trace points*/
+};
+
+/**
+ * @brief Enumerator that defines the segments with a histogram. Segment `0 < i < LATENCY_NUM_STAGES` goes from stage `i - 1` to stage `i`.
+ *
+ */
+enum LATENCY_SEGMENT {
+    LATENCY_SEGMENT_TOTAL = 0,      /*!<From the USART ISR to the register write*/
+    LATENCY_SEGMENT_ISR_TO_RX,      /*!<From the USART ISR to the USART FSM*/
+    LATENCY_SEGMENT_RX_TO_READ,     /*!<From the USART FSM to the Jukebox FSM*/
+    LATENCY_SEGMENT_READ_TO_EXECUTE,/*!<From the reading of the line to the execution of the command*/
+    LATENCY_SEGMENT_EXECUTE_TO_WRITE,/*!<From the execution of the command to the register write*/
+    LATENCY_SEGMENT_WAKE_TO_FIRE,   /*!<From the wake-up from STOP mode to the first FSM fired. It is not part of the command traces*/
+    LATENCY_NUM_SEGMENTS            /*!<Number of segments*/
+};
+
+/* Function prototypes and explanation ---------------------------------------*/
+/**
+ * @brief Record that a trace point has been reached.
+ *
+ * `LATENCY_STAGE_RX_ISR` always starts a new trace. Any other stage is recorded only if it follows the previous one, or repeats it. When `LATENCY_STAGE_REG_WRITE` is recorded, the trace is complete and it is added to the histograms.
+ *
+ * A batch of commands that does not act on the player does not reprogram the buzzer. The Jukebox abandons its trace with `latency_trace_abandon()`, so it is not counted and a later register write does not close it.
+ *
+ * @param stage Trace point, one of `LATENCY_STAGE`
+ * @param cycles Timestamp in CPU cycles, as returned by `port_system_get_cycles()`
+ */
+void latency_trace_mark(uint32_t stage, uint32_t cycles);
+
+/**
+ * @brief Abandon the open trace, if any, without adding it to the histograms.
+ *
+ */
+void latency_trace_abandon(void);
+
+/**
+ * @brief Add the latency from a wake-up from STOP mode to the first FSM fired after it to the histogram of `LATENCY_SEGMENT_WAKE_TO_FIRE`.
+ *
+ * @param cycles Latency in CPU cycles
+ */
+void latency_trace_add_wake(uint32_t cycles);
+
+/**
+ * @brief Clear all the histograms and abandon the open trace, if any.
+ *
+ */
+void latency_trace_reset(void);
+
+/**
+ * @brief Get the number of complete traces added to the histograms.
+ *
+ * @return uint32_t Number of traces. It saturates at UINT16_MAX.
+ */
+uint32_t latency_trace_get_count(void);
+
+/**
+ * @brief Get the count of a bucket of the histogram of a segment.
+ *
+ * @param segment Segment, one of `LATENCY_SEGMENT`
+ * @param bucket Bucket index, lower than `LATENCY_HISTOGRAM_BUCKETS`
+ * @return uint32_t Count of the bucket. It saturates at UINT16_MAX.
+ */
+uint32_t latency_trace_get_bucket(uint32_t segment, uint32_t bucket);
+
+/**
+ * @brief Get the maximum latency of a segment.
+ *
+ * @param segment Segment, one of `LATENCY_SEGMENT`
+ * @return uint32_t Maximum latency in us
+ */
+uint32_t latency_trace_get_max_us(uint32_t segment);
+
+/**
+ * @brief Write the histogram of a segment as a single line of text, to be sent through the USART and decoded by `tools/latency_report.py`.
+ *
+ * The format is `LAT<segment> <count> <max us> <buckets>`, where the count (of complete traces, or of wake-ups for `LATENCY_SEGMENT_WAKE_TO_FIRE`) is 4 hex digits, the maximum is 8 hex digits and each of the `LATENCY_HISTOGRAM_BUCKETS` buckets is 4 hex digits, without separators.
+ *
+ * @param segment Segment, one of `LATENCY_SEGMENT`
+ * @param p_text Pointer to store the text. It must be at least `LATENCY_DUMP_LENGTH` long.
+ */
+void latency_trace_dump(uint32_t segment, char *p_text);
+
+#endif /* LATENCY_TRACE_H_ */
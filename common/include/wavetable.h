@@ -0,0 +1,80 @@
+/**
+ * @file wavetable.h
+ * @brief Header for wavetable.c file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef WAVETABLE_H_
+#define WAVETABLE_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define WAVETABLE_BITS 8                            /*!<Bits of the index of the wavetable. They are the highest bits of the phase*/
+#define WAVETABLE_LENGTH (1U << WAVETABLE_BITS)     /*!<Number of samples of a period of the wavetable*/
+#define WAVETABLE_AMPLITUDE 16383                   /*!<Peak of the samples of the wavetable. It is Q14, so the difference of two samples fits in 16 bits*/
+#define WAVETABLE_FRACTION_BITS 15                  /*!<Bits of the fraction of the phase between two samples of the wavetable used by the linear interpolation*/
+#define WAVETABLE_OUTPUT_MIDSCALE 2048              /*!<Output sample of a silence. The output samples are 12-bit unsigned, for the DAC*/
+
+#define WAVETABLE_HARMONICS_SINE {1.0}                      /*!<Harmonics of a sine wave, for `wavetable_init_table()`*/
+#define WAVETABLE_HARMONICS_ORGAN {1.0, 0.5, 0.25, 0.125}   /*!<Harmonics of an organ-like wave, for `wavetable_init_table()`*/
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Wavetable oscillator. Its phase is a Q32 fraction of a period of the wavetable.
+ *
+ */
+typedef struct
+{
+    const int16_t *p_table;     /*!<Wavetable of `WAVETABLE_LENGTH` samples*/
+    uint32_t phase;             /*!<Phase accumulator*/
+    uint32_t phase_inc;         /*!<Phase increment per output sample. 0 is a silence*/
+    bool interpolate;           /*!<True to interpolate linearly between two samples of the wavetable, false to take the sample below the phase*/
+} wavetable_osc_t;
+
+/* Function prototypes and explanation ---------------------------------------*/
+/**
+ * @brief Fill a wavetable with a sum of harmonics, normalized to `WAVETABLE_AMPLITUDE`. All the harmonics are sines, so the first sample is 0.
+ *
+ * @param p_table Wavetable of `WAVETABLE_LENGTH` samples
+ * @param p_harmonics Amplitude of each harmonic, starting from the fundamental
+ * @param num_harmonics Number of harmonics
+ */
+void wavetable_init_table(int16_t *p_table, const double *p_harmonics, uint32_t num_harmonics);
+
+/**
+ * @brief Initialize a wavetable oscillator, silent.
+ *
+ * @param p_osc Pointer to the oscillator
+ * @param p_table Wavetable of `WAVETABLE_LENGTH` samples
+ * @param interpolate True to interpolate linearly between two samples of the wavetable
+ */
+void wavetable_osc_init(wavetable_osc_t *p_osc, const int16_t *p_table, bool interpolate);
+
+/**
+ * @brief Set the frequency of a wavetable oscillator. It is the only floating point operation of the oscillator, done once per note.
+ *
+ * @param p_osc Pointer to the oscillator
+ * @param frequency_hz Frequency in Hz. 0 is a silence: the phase is reset, so the output is `WAVETABLE_OUTPUT_MIDSCALE`.
+ * @param sample_rate_hz Output sample rate in Hz
+ */
+void wavetable_osc_set_frequency(wavetable_osc_t *p_osc, double frequency_hz, uint32_t sample_rate_hz);
+
+/**
+ * @brief Fill a block of output samples of a wavetable oscillator with its fixed-point phase accumulator. On a Cortex-M4 the samples are computed in pairs with the SIMD instructions of the DSP extension, with the same results as the portable code.
+ *
+ * @note With `p_samples` aligned to 4 bytes, each pair of samples is a single aligned store.
+ *
+ * @param p_osc Pointer to the oscillator
+ * @param p_samples Array to store the samples, 12-bit unsigned
+ * @param count Number of samples
+ */
+void wavetable_fill(wavetable_osc_t *p_osc, uint16_t *p_samples, uint32_t count);
+
+#endif /* WAVETABLE_H_ */
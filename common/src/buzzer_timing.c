@@ -0,0 +1,70 @@
+/**
+ * @file buzzer_timing.c
+ * @brief Timer values of the notes of the buzzer. The port layer programs them, and the host tools use them to render and check the melodies as the firmware plays them.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <math.h>
+
+/* Other libraries */
+#include "buzzer_timing.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define BUZZER_TIMING_ARR_MAX 65535.0   /*!<Maximum value of the ARR register of a 16-bit timer*/
+
+/* Public functions -----------------------------------------------------------*/
+uint32_t buzzer_timing_get_scaled_duration(uint32_t duration_ms, double speed)
+{
+    return duration_ms / speed;
+}
+
+void buzzer_timing_get_duration(uint32_t clock_hz, uint32_t duration_ms, buzzer_timing_t *p_timing)
+{
+    double sysclk_as_double = (double)clock_hz;
+    double s_as_double = (double)duration_ms / 1000;
+    // Smallest prescaler, and ARR for it. Rounding may leave ARR above its maximum, then the next prescaler is used
+    double PSC_min = round(((sysclk_as_double * s_as_double) / (BUZZER_TIMING_ARR_MAX + 1)) - 1);
+    double ARR = round(((sysclk_as_double * s_as_double) / (PSC_min + 1)) - 1);
+    if (ARR > BUZZER_TIMING_ARR_MAX)
+    {
+        PSC_min++;
+        ARR = round(((sysclk_as_double * s_as_double) / (PSC_min + 1)) - 1);
+    }
+    p_timing->psc = PSC_min;
+    p_timing->arr = ARR;
+}
+
+void buzzer_timing_get_pwm(uint32_t clock_hz, double frequency_hz, buzzer_timing_t *p_timing)
+{
+    double sysclk_as_double = (double)clock_hz;
+    double PSC_min = round(((sysclk_as_double * (1 / frequency_hz)) / (BUZZER_TIMING_ARR_MAX + 1)) - 1);
+    double ARR = round(((sysclk_as_double * (1 / frequency_hz)) / (PSC_min + 1)) - 1);
+    if (ARR > BUZZER_TIMING_ARR_MAX)
+    {
+        PSC_min++;
+        ARR = round(((sysclk_as_double * (1 / frequency_hz)) / (PSC_min + 1)) - 1);
+    }
+    p_timing->psc = PSC_min;
+    p_timing->arr = ARR;
+}
+
+void buzzer_timing_rescale_duration(uint32_t *p_arr, uint32_t *p_cnt, double ratio)
+{
+    // The note overflows at ARR + 1 ticks, so the period is scaled, not ARR
+    double ARR = round(((double)*p_arr + 1) * ratio) - 1;
+    double CNT = round((double)*p_cnt * ratio);
+    if (ARR < 0)
+    {
+        ARR = 0;
+    }
+    if (CNT > ARR)
+    {
+        CNT = ARR;
+    }
+    *p_arr = ARR;
+    *p_cnt = CNT;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file fsm_active.c
+ * @brief Run-to-completion dispatcher of events for the FSMs.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <string.h>
+
+/* Other libraries */
+#include "fsm_active.h"
+#include "fsm_trace.h"
+#include "latency_trace.h"
+#include "port_system.h"
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Active object: an FSM with its event queue.
+ *
+ */
+typedef struct
+{
+    fsm_t *p_fsm;                                   /*!<FSM*/
+    int (*p_fire)(fsm_t *);                         /*!<Dispatch function of the FSM*/
+    void (*p_on_event)(fsm_t *, fsm_event_t);       /*!<Function that turns an event into the inputs of the FSM. It may be NULL*/
+    bool (*p_check_busy)(fsm_t *);                  /*!<Function that tells if the FSM must be polled. It may be NULL*/
+    uint32_t irq_events;                            /*!<IRQ events of the peripherals of the FSM*/
+    uint32_t listeners;                             /*!<Mask of the priorities of the FSMs that listen to this one*/
+    uint8_t trace_id;                               /*!<Identifier of the FSM in the trace*/
+    uint8_t head;                                   /*!<Position of the next event to take*/
+    uint8_t tail;                                   /*!<Position of the next event to post*/
+    fsm_event_t queue[FSM_ACTIVE_QUEUE_SIZE];       /*!<Events pending*/
+} fsm_active_t;
+
+/* Global variables */
+/**
+ * @brief Active objects, in order of priority.
+ *
+ */
+static fsm_active_t actives[FSM_ACTIVE_MAX_OBJECTS];
+
+/**
+ * @brief Number of active objects registered.
+ *
+ */
+static uint32_t num_actives = 0;
+
+/**
+ * @brief Epoch of the inputs, returned by `fsm_active_get_epoch()`.
+ *
+ */
+static uint32_t epoch = 0;
+
+/**
+ * @brief Number of wake-ups from STOP mode already measured.
+ *
+ */
+static uint32_t stop_count_seen = 0;
+
+/**
+ * @brief Function that enters the low power mode at the end of the dispatch. NULL if no FSM has requested it.
+ *
+ */
+static void (*p_idle_request)(fsm_t *) = NULL;
+
+/**
+ * @brief FSM that has requested the low power mode.
+ *
+ */
+static fsm_t *p_idle_fsm = NULL;
+
+/* Private functions */
+/**
+ * @brief Post an event to an active object.
+ *
+ * @param p_active Pointer to the active object
+ * @param event Event to post
+ * @return true if the event has been queued
+ * @return false if the queue is full
+ */
+static bool _post(fsm_active_t *p_active, fsm_event_t event){
+    if ((uint8_t)(p_active->tail - p_active->head) >= FSM_ACTIVE_QUEUE_SIZE){
+        return false;
+    }
+    p_active->queue[p_active->tail & (FSM_ACTIVE_QUEUE_SIZE - 1)] = event;
+    p_active->tail++;
+    return true;
+}
+
+/**
+ * @brief Post a poll event to an active object, unless it already has events pending: any event makes it check its guards.
+ *
+ * @param p_active Pointer to the active object
+ */
+static void _post_poll(fsm_active_t *p_active){
+    if (p_active->head == p_active->tail){
+        _post(p_active, (fsm_event_t){.signal = FSM_EVENT_POLL});
+    }
+}
+
+/**
+ * @brief Check if all the queues are empty.
+ *
+ * @return true if no active object has events pending
+ * @return false if any active object has events pending
+ */
+static bool _check_empty(void){
+    for (uint32_t i = 0; i < num_actives; i++)
+    {
+        if (actives[i].head != actives[i].tail){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Process one event of an active object: pass it to the FSM and fire the FSM once.
+ *
+ * @param p_active Pointer to the active object
+ */
+static void _process(fsm_active_t *p_active){
+    fsm_event_t event = p_active->queue[p_active->head & (FSM_ACTIVE_QUEUE_SIZE - 1)];
+    p_active->head++;
+    if (p_active->p_on_event != NULL){
+        // The event may change the inputs of the FSM, which other FSMs may read
+        p_active->p_on_event(p_active->p_fsm, event);
+        epoch++;
+    }
+
+    uint32_t stop_count = port_system_get_stop_count();
+    if (stop_count != stop_count_seen){
+        // First fire after a wake-up from STOP mode
+        stop_count_seen = stop_count;
+        latency_trace_add_wake(port_system_get_cycles() - port_system_get_stop_wake_cycles());
+    }
+
+    int from = fsm_get_state(p_active->p_fsm);
+    int row = p_active->p_fire(p_active->p_fsm);
+    if (row < 0){
+        return;
+    }
+    int to = fsm_get_state(p_active->p_fsm);
+    epoch++;
+#if FSM_TRACE_ENABLED
+    fsm_trace_record(p_active->trace_id, from, to, row);
+#endif
+    if (from != to){
+        _post_poll(p_active);
+    }
+    for (uint32_t i = 0; i < num_actives; i++)
+    {
+        if (p_active->listeners & BIT_POS_TO_MASK(i)){
+            _post(&actives[i], (fsm_event_t){.signal = FSM_EVENT_CHANGED});
+        }
+    }
+}
+
+/* Public functions */
+int fsm_active_register(fsm_t *p_fsm, int (*p_fire)(fsm_t *), void (*p_on_event)(fsm_t *, fsm_event_t), bool (*p_check_busy)(fsm_t *), uint32_t irq_events, uint32_t trace_id){
+    if (num_actives >= FSM_ACTIVE_MAX_OBJECTS){
+        return -1;
+    }
+    fsm_active_t *p_active = &actives[num_actives];
+    memset(p_active, 0, sizeof(fsm_active_t));
+    p_active->p_fsm = p_fsm;
+    p_active->p_fire = p_fire;
+    p_active->p_on_event = p_on_event;
+    p_active->p_check_busy = p_check_busy;
+    p_active->irq_events = irq_events;
+    p_active->trace_id = trace_id;
+    // The first fire checks the initial state
+    _post(p_active, (fsm_event_t){.signal = FSM_EVENT_POLL});
+    return num_actives++;
+}
+
+void fsm_active_listen(int listener, int source){
+    if ((listener < 0) || (source < 0) || (listener >= (int)num_actives) || (source >= (int)num_actives)){
+        return;
+    }
+    actives[source].listeners |= BIT_POS_TO_MASK(listener);
+}
+
+bool fsm_active_post(fsm_t *p_fsm, fsm_event_t event){
+    int priority = fsm_active_get_priority(p_fsm);
+    if (priority < 0){
+        return false;
+    }
+    return _post(&actives[priority], event);
+}
+
+int fsm_active_get_priority(fsm_t *p_fsm){
+    for (uint32_t i = 0; i < num_actives; i++)
+    {
+        if (actives[i].p_fsm == p_fsm){
+            return i;
+        }
+    }
+    return -1;
+}
+
+uint32_t fsm_active_dispatch(void){
+    epoch++;
+    uint32_t irq_events = port_system_take_irq_events();
+    for (uint32_t i = 0; i < num_actives; i++)
+    {
+        fsm_active_t *p_active = &actives[i];
+        if (irq_events & p_active->irq_events){
+            _post(p_active, (fsm_event_t){.signal = FSM_EVENT_IRQ});
+        }
+        if ((p_active->p_check_busy != NULL) && p_active->p_check_busy(p_active->p_fsm)){
+            _post_poll(p_active);
+        }
+    }
+
+    uint32_t processed = 0;
+    while (processed < FSM_ACTIVE_MAX_EVENTS)
+    {
+        uint32_t i = 0;
+        while ((i < num_actives) && (actives[i].head == actives[i].tail))
+        {
+            i++;
+        }
+        if (i == num_actives){
+            break;
+        }
+        _process(&actives[i]);
+        processed++;
+    }
+
+    void (*p_idle)(fsm_t *) = p_idle_request;
+    p_idle_request = NULL;
+    if ((p_idle != NULL) && _check_empty()){
+        p_idle(p_idle_fsm);
+    }
+    return processed;
+}
+
+void fsm_active_request_idle(fsm_t *p_fsm, void (*p_idle)(fsm_t *)){
+    if (fsm_active_get_priority(p_fsm) < 0){
+        p_idle(p_fsm);
+        return;
+    }
+    p_idle_fsm = p_fsm;
+    p_idle_request = p_idle;
+}
+
+uint32_t fsm_active_get_epoch(void){
+    return epoch;
+}
+
+void fsm_active_reset(void){
+    memset(actives, 0, sizeof(actives));
+    num_actives = 0;
+    p_idle_request = NULL;
+    p_idle_fsm = NULL;
+    epoch++;
+}
+
+bool fsm_active_always_busy(fsm_t *p_this){
+    return true;
+}
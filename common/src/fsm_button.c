@@ -9,6 +9,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdlib.h>
 #include "fsm_button.h"
+#include "fsm_pool.h"
 #include "port_button.h"
 
 
@@ -38,63 +39,72 @@ static bool check_button_released(fsm_t * p_this){
     return !port_button_is_pressed(p_button->button_id);
 }
 
+/* Private functions */
 /**
- * @brief Check if the debounce-time has passed.
+ * @brief Get the time of the first edge of the button of the given kind, from the FIFO of edges timestamped in the ISR. The edges before it are discarded.
  *
- * @param p_this Pointer to an fsm_t struct than contains an fsm_button_t.
- * @return true
- * @return false
+ * @param p_button Pointer to the button FSM
+ * @param pressed True to look for a press, false to look for a release
+ * @return uint64_t Time of the edge in us. If there is no such edge, e.g. because the FIFO was full, the current time.
  */
-static bool check_timeout(fsm_t * p_this)	
-{
-    fsm_button_t * p_button = ( fsm_button_t *) p_this ;
-    uint32_t tick_now = port_button_get_tick();
-    return tick_now > p_button -> next_timeout;
+static uint64_t _get_edge_time(fsm_button_t *p_button, bool pressed){
+    port_button_edge_t edge;
+    while (port_button_pop_edge(p_button->button_id, &edge))
+    {
+        if (edge.pressed == pressed){
+            return edge.timestamp_us;
+        }
+    }
+    return port_system_get_micros64();
 }
 
 /* State machine output or action functions */
 /**
- * @brief Store the system tick when the button was pressed.
+ * @brief Store the time when the button was pressed, taken in the ISR.
  *
  * @param p_this Pointer to an fsm_t struct than contains an fsm_button_t.
  */
 static void do_store_tick_pressed(fsm_t *p_this)
 {
     fsm_button_t *p_button = ( fsm_button_t *) p_this;
-    uint32_t tick_now = port_button_get_tick();
-    p_button -> tick_pressed = tick_now ;
-    p_button -> next_timeout = tick_now + p_button -> debounce_time ;
+    p_button -> time_pressed_us = _get_edge_time(p_button, true);
+    p_button -> press_consumed = false;
 }
 
 /**
- * @brief Store the duration of the button pressed.
+ * @brief Store the duration of the button pressed, from the times of the press and release edges taken in the ISR.
  *
  * @param p_this Pointer to an fsm_t struct than contains an fsm_button_t.
  */
 static void do_set_duration(fsm_t *p_this)
 {
     fsm_button_t *p_button = ( fsm_button_t *) p_this ;
-    uint32_t tick_now = port_button_get_tick();
+    uint64_t time_released_us = _get_edge_time(p_button, false);
 
-    p_button -> duration = tick_now - p_button -> tick_pressed ;
-    p_button -> next_timeout = tick_now + p_button -> debounce_time ;
+    p_button -> duration = p_button -> press_consumed ? 0 : (uint32_t)((time_released_us - p_button -> time_pressed_us) / 1000U);
 }
 
 /**
- * @brief Array representing the transitions table of the FSM button
- * 
- * @image html fsm_button_states.png
+ * @brief Array representing the transitions table of the FSM button. The debounce is done by the port layer with a timer, so the FSM only sees debounced presses and releases.
  */
 static fsm_trans_t fsm_trans_button[] = {
-    { BUTTON_RELEASED , check_button_pressed , BUTTON_PRESSED_WAIT , do_store_tick_pressed },
-    { BUTTON_PRESSED_WAIT , check_timeout , BUTTON_PRESSED , NULL },
-    { BUTTON_PRESSED , check_button_released , BUTTON_RELEASED_WAIT , do_set_duration } ,
-    { BUTTON_RELEASED_WAIT , check_timeout , BUTTON_RELEASED , NULL },
+    { BUTTON_RELEASED , check_button_pressed , BUTTON_PRESSED , do_store_tick_pressed },
+    { BUTTON_PRESSED , check_button_released , BUTTON_RELEASED , do_set_duration } ,
     { -1 , NULL , -1, NULL }
 };
 
+/* Switch-based dispatch of the transitions table, generated by tools/fsm_codegen.py */
+#include "fsm_button_dispatch.inc"
+
 /* Other auxiliary functions */
 
+/* Static pool */
+/**
+ * @brief Static pool of button FSMs for `fsm_button_new_static()`.
+ *
+ */
+FSM_POOL_DEFINE(fsm_button, fsm_button_t, FSM_BUTTON_POOL_SIZE)
+
 /* FSM public functions */
 uint32_t fsm_button_get_duration (fsm_t *p_this){
     fsm_button_t * p_button = (fsm_button_t *) p_this;
@@ -104,6 +114,17 @@ uint32_t fsm_button_get_duration (fsm_t *p_this){
 void fsm_button_reset_duration (fsm_t *p_fsm ){
     fsm_button_t * p_button = ( fsm_button_t *) p_fsm ;
     p_button -> duration = 0;
+    if (p_button->f.current_state == BUTTON_PRESSED){
+        p_button -> press_consumed = true;
+    }
+}
+
+uint32_t fsm_button_get_held_duration(fsm_t *p_this){
+    fsm_button_t *p_button = (fsm_button_t *)p_this;
+    if ((p_button->f.current_state != BUTTON_PRESSED) || p_button->press_consumed){
+        return 0;
+    }
+    return (uint32_t)((port_system_get_micros64() - p_button->time_pressed_us) / 1000U);
 }
 
 fsm_t * fsm_button_new(uint32_t debounce_time, uint32_t button_id){
@@ -112,17 +133,32 @@ fsm_t * fsm_button_new(uint32_t debounce_time, uint32_t button_id){
     return p_fsm;
 }
 
+fsm_t *fsm_button_new_static(uint32_t debounce_time, uint32_t button_id){
+    fsm_t *p_fsm = fsm_button_pool_take();
+    if (p_fsm == NULL){
+        return NULL;
+    }
+    fsm_button_init(p_fsm, debounce_time, button_id);
+    return p_fsm;
+}
+
 void fsm_button_init(fsm_t *p_this, uint32_t debounce_time, uint32_t button_id){
     fsm_button_t *p_button = (fsm_button_t *)p_this;
     fsm_init(&p_button->f, fsm_trans_button);
     p_button -> debounce_time = debounce_time ;
     p_button -> button_id = button_id;
-    p_button -> tick_pressed = 0;
+    p_button -> time_pressed_us = 0;
     p_button -> duration = 0;
+    p_button -> press_consumed = false;
     port_button_init(p_button->button_id);
+    port_button_set_debounce_time(p_button->button_id, debounce_time);
 }
 
 bool fsm_button_check_activity(fsm_t *p_this){
     fsm_button_t *p_button = (fsm_button_t *)p_this; 
     return(p_button->f.current_state != BUTTON_RELEASED);
-}
\ No newline at end of file
+}
+
+int fsm_button_fire(fsm_t *p_this){
+    return fsm_button_dispatch(p_this);
+}
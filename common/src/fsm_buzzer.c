@@ -13,7 +13,10 @@
 /* Other libraries */
 #include "port_buzzer.h"
 #include "fsm_buzzer.h"
+#include "fsm_pool.h"
 #include "melodies.h"
+#include "latency_trace.h"
+#include "buzzer_timing.h"
 
 /* State machine input or transition functions */
 /**
@@ -134,7 +137,62 @@ static void do_end_melody(fsm_t * p_this){
 void _start_note(fsm_t * p_this, double freq, uint32_t duration){
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     port_buzzer_set_note_frequency(p_fsm->buzzer_id, freq);
-    port_buzzer_set_note_duration(p_fsm->buzzer_id, duration / p_fsm->player_speed);
+    port_buzzer_set_note_duration(p_fsm->buzzer_id, buzzer_timing_get_scaled_duration(duration, p_fsm->player_speed));
+    p_fsm->note_freq = freq;
+    p_fsm->note_count++;
+}
+
+/**
+ * @brief Check whether the duration of a note of the compiled melody has been rebuilt at the current speed. The durations are rebuilt in order of play from `rebuild_start`.
+ * 
+ * @param p_fsm Pointer to the fsm_buzzer_t struct
+ * @param note_index Index of the note
+ * @return true 
+ * @return false 
+ */
+static bool _check_rebuilt(fsm_buzzer_t *p_fsm, uint32_t note_index){
+    uint32_t length = p_fsm->p_melody->melody_length;
+    return ((note_index + length - p_fsm->rebuild_start) % length) < p_fsm->rebuild_count;
+}
+
+/**
+ * @brief Rebuild the durations of the next `FSM_BUZZER_REBUILD_NOTES` notes of the compiled melody, in order of play, at the current speed.
+ * 
+ * @param p_fsm Pointer to the fsm_buzzer_t struct
+ */
+static void _rebuild_durations(fsm_buzzer_t *p_fsm){
+    uint32_t length = p_fsm->p_melody->melody_length;
+    for (uint32_t i = 0; (i < FSM_BUZZER_REBUILD_NOTES) && (p_fsm->rebuild_count < length); i++){
+        uint32_t note_index = (p_fsm->rebuild_start + p_fsm->rebuild_count) % length;
+        port_buzzer_compile_duration(buzzer_timing_get_scaled_duration(p_fsm->p_melody->p_durations[note_index], p_fsm->player_speed), &p_fsm->p_compiled[note_index]);
+        p_fsm->rebuild_count++;
+    }
+}
+
+/**
+ * @brief Start a note of the melody: from its register values if the melody is compiled, or from its frequency and duration.
+ * 
+ * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct
+ * @param note_index Index of the note in the melody
+ */
+static void _start_melody_note(fsm_t * p_this, uint32_t note_index){
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    double freq = p_fsm->p_melody->p_notes[note_index];
+    if (!p_fsm->compiled){
+        _start_note(p_this, freq, p_fsm->p_melody->p_durations[note_index]);
+        return;
+    }
+    if (!_check_rebuilt(p_fsm, note_index)){
+        // The player jumped out of the order of the rebuild: it goes on from here
+        p_fsm->rebuild_start = note_index;
+        p_fsm->rebuild_count = 0;
+    }
+    if (p_fsm->rebuild_count < p_fsm->p_melody->melody_length){
+        _rebuild_durations(p_fsm);
+    }
+    port_buzzer_play_compiled_note(p_fsm->buzzer_id, freq, &p_fsm->p_compiled[note_index]);
+    p_fsm->note_freq = freq;
+    p_fsm->note_count++;
 }
 
 /**
@@ -144,9 +202,8 @@ void _start_note(fsm_t * p_this, double freq, uint32_t duration){
  */
 static void do_melody_start(fsm_t * p_this){
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
-    double first_note = p_fsm->p_melody->p_notes[0];
-    double first_duration = p_fsm->p_melody-> p_durations[0];
-    _start_note(p_this, first_note, first_duration);
+    port_buzzer_set_effect(p_fsm->buzzer_id, p_fsm->effect); // The first note does not glide from the last one played
+    _start_melody_note(p_this, 0);
     p_fsm->note_index = 1;
 }
 
@@ -169,6 +226,7 @@ static void do_note_end(fsm_t * p_this){
 static void do_pause(fsm_t * p_this){
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     port_buzzer_stop(p_fsm->buzzer_id);
+    latency_trace_mark(LATENCY_STAGE_REG_WRITE, port_buzzer_get_write_timestamp(p_fsm->buzzer_id));
 }
 
 /**
@@ -178,10 +236,7 @@ static void do_pause(fsm_t * p_this){
  */
 static void do_play_note(fsm_t * p_this){
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
-    uint32_t note_index = p_fsm->note_index;
-    double current_note = p_fsm->p_melody->p_notes[note_index];
-    uint32_t current_duration = p_fsm->p_melody-> p_durations[note_index];
-    _start_note(p_this, current_note, current_duration);
+    _start_melody_note(p_this, p_fsm->note_index);
     p_fsm->note_index ++;
 }
 
@@ -191,7 +246,9 @@ static void do_play_note(fsm_t * p_this){
  * @param p_this Pointer to an fsm_t struct than contains an fsm_buzzer_t struct 
  */
 static void do_player_start(fsm_t * p_this){
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     do_melody_start(p_this);
+    latency_trace_mark(LATENCY_STAGE_REG_WRITE, port_buzzer_get_write_timestamp(p_fsm->buzzer_id));
 }
 
 /**
@@ -202,6 +259,7 @@ static void do_player_start(fsm_t * p_this){
 static void do_player_stop(fsm_t * p_this){
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     port_buzzer_stop(p_fsm->buzzer_id);
+    latency_trace_mark(LATENCY_STAGE_REG_WRITE, port_buzzer_get_write_timestamp(p_fsm->buzzer_id));
     p_fsm->note_index = 0;
 }
 
@@ -221,6 +279,16 @@ fsm_trans_t fsm_trans_buzzer[] = {
     { -1 , NULL , -1, NULL }
 };
 
+/* Switch-based dispatch of the transitions table, generated by tools/fsm_codegen.py */
+#include "fsm_buzzer_dispatch.inc"
+
+/* Static pool */
+/**
+ * @brief Static pool of buzzer melody player FSMs for `fsm_buzzer_new_static()`.
+ *
+ */
+FSM_POOL_DEFINE(fsm_buzzer, fsm_buzzer_t, FSM_BUZZER_POOL_SIZE)
+
 /* Public functions */
 
 fsm_t *fsm_buzzer_new(uint32_t buzzer_id)
@@ -230,6 +298,16 @@ fsm_t *fsm_buzzer_new(uint32_t buzzer_id)
     return p_fsm;
 }
 
+fsm_t *fsm_buzzer_new_static(uint32_t buzzer_id)
+{
+    fsm_t *p_fsm = fsm_buzzer_pool_take();
+    if (p_fsm == NULL){
+        return NULL;
+    }
+    fsm_buzzer_init(p_fsm, buzzer_id);
+    return p_fsm;
+}
+
 void fsm_buzzer_init(fsm_t *p_this, uint32_t buzzer_id)
 {
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
@@ -239,7 +317,16 @@ void fsm_buzzer_init(fsm_t *p_this, uint32_t buzzer_id)
     p_fsm->note_index = 0;
     p_fsm->user_action = STOP;
     p_fsm->player_speed = 1.0;
+    p_fsm->note_count = 0;
+    p_fsm->note_freq = 0;
+    p_fsm->effect = PORT_BUZZER_EFFECT_NONE;
+    p_fsm->p_compiled = NULL;
+    p_fsm->compiled_capacity = 0;
+    p_fsm->compiled = false;
+    p_fsm->rebuild_start = 0;
+    p_fsm->rebuild_count = 0;
     port_buzzer_init(buzzer_id);
+    port_buzzer_set_envelope(buzzer_id, true);
 }
 
 bool fsm_buzzer_check_activity(fsm_t * p_this){
@@ -247,6 +334,14 @@ bool fsm_buzzer_check_activity(fsm_t * p_this){
     return(p_fsm->f.current_state == PLAY);
 }
 
+uint32_t fsm_buzzer_get_note(fsm_t * p_this, double *p_freq){
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if (p_freq != NULL){
+        *p_freq = p_fsm->note_freq;
+    }
+    return p_fsm->note_count;
+}
+
 uint8_t fsm_buzzer_get_action(fsm_t * p_this){
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     return p_fsm->user_action;
@@ -260,12 +355,76 @@ void fsm_buzzer_set_action(fsm_t * p_this, uint8_t action){
     }
 }
 
+void fsm_buzzer_on_event(fsm_t * p_this, fsm_event_t event){
+    switch (event.signal)
+    {
+    case FSM_EVENT_ACTION:
+        fsm_buzzer_set_action(p_this, event.param);
+        break;
+    case FSM_EVENT_MELODY:
+        fsm_buzzer_set_melody(p_this, (const melody_t *)event.p_data);
+        break;
+    case FSM_EVENT_SPEED:
+        fsm_buzzer_set_speed(p_this, event.value);
+        break;
+    case FSM_EVENT_EFFECT:
+        fsm_buzzer_set_effect(p_this, event.param);
+        break;
+    case FSM_EVENT_OUTPUT:
+        fsm_buzzer_set_output(p_this, event.param);
+        break;
+    default:
+        break; // The other events only make the FSM check its guards
+    }
+}
+
+void fsm_buzzer_set_compile_buffer(fsm_t * p_this, buzzer_timing_note_t *p_buffer, uint32_t capacity){
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    p_fsm->p_compiled = p_buffer;
+    p_fsm->compiled_capacity = (p_buffer != NULL) ? capacity : 0;
+    p_fsm->compiled = false; // The next melody is compiled in the new buffer
+}
+
 void fsm_buzzer_set_melody(fsm_t * p_this, const melody_t *p_melody){	
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
     p_fsm->p_melody = (melody_t *)p_melody;
+    p_fsm->compiled = (p_melody != NULL) && (p_melody->melody_length > 0) && (p_melody->melody_length <= p_fsm->compiled_capacity);
+    if (!p_fsm->compiled){
+        return;
+    }
+    for (uint32_t i = 0; i < p_melody->melody_length; i++){
+        port_buzzer_compile_note(p_melody->p_notes[i], buzzer_timing_get_scaled_duration(p_melody->p_durations[i], p_fsm->player_speed), &p_fsm->p_compiled[i]);
+    }
+    p_fsm->rebuild_start = 0;
+    p_fsm->rebuild_count = p_melody->melody_length;
 }
 
 void fsm_buzzer_set_speed(fsm_t * p_this, double speed){
     fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    if (p_fsm->f.current_state == WAIT_NOTE){
+        // The note that is playing takes the new speed for its remaining time
+        port_buzzer_rescale_note_duration(p_fsm->buzzer_id, p_fsm->player_speed / speed);
+    }
     p_fsm->player_speed = speed;
-}
\ No newline at end of file
+    if (p_fsm->compiled){
+        // Only the durations change: they are rebuilt from the next note, a few at each note
+        p_fsm->rebuild_start = p_fsm->note_index % p_fsm->p_melody->melody_length;
+        p_fsm->rebuild_count = 0;
+    }
+}
+
+void fsm_buzzer_set_effect(fsm_t * p_this, uint8_t effect){
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    p_fsm->effect = effect;
+    port_buzzer_set_effect(p_fsm->buzzer_id, effect);
+}
+
+void fsm_buzzer_set_output(fsm_t * p_this, uint8_t output){
+    fsm_buzzer_t *p_fsm = (fsm_buzzer_t *)(p_this);
+    port_buzzer_set_output(p_fsm->buzzer_id, output);
+}
+
+int fsm_buzzer_fire(fsm_t *p_this)
+{
+    return fsm_buzzer_dispatch(p_this);
+}
@@ -0,0 +1,325 @@
+/**
+ * @file fsm_gesture.c
+ * @brief Gesture FSM main file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdlib.h>
+
+/* Other libraries */
+#include "fsm_gesture.h"
+#include "fsm_pool.h"
+#include "fsm_button.h"
+#include "port_system.h"
+
+/* Private functions */
+/**
+ * @brief Get the mask of the buttons pressed, from the states of the button FSMs.
+ *
+ * @param p_fsm Pointer to the gesture FSM
+ * @return uint32_t Mask of the buttons pressed
+ */
+static uint32_t _get_pressed_mask(fsm_gesture_t *p_fsm){
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < p_fsm->num_buttons; i++)
+    {
+        int state = fsm_get_state(p_fsm->p_fsm_buttons[i]);
+        if (state == BUTTON_PRESSED){
+            mask |= BIT_POS_TO_MASK(i);
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Check if the deadline of the gesture FSM has passed.
+ *
+ * @param p_fsm Pointer to the gesture FSM
+ * @return true
+ * @return false
+ */
+static bool _check_deadline(fsm_gesture_t *p_fsm){
+    return ((int32_t)(port_system_get_millis() - p_fsm->deadline_ms) >= 0);
+}
+
+/**
+ * @brief Report a gesture of the buttons of the gesture in progress.
+ *
+ * @param p_fsm Pointer to the gesture FSM
+ * @param gesture Gesture, one of `FSM_GESTURE_TYPE`
+ */
+static void _report(fsm_gesture_t *p_fsm, uint32_t gesture){
+    p_fsm->gesture = gesture;
+    p_fsm->gesture_buttons = p_fsm->buttons;
+}
+
+/* State machine input or transition functions */
+/**
+ * @brief Check if any button is pressed
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ * @return true
+ * @return false
+ */
+static bool check_pressed(fsm_t *p_this){
+    return (_get_pressed_mask((fsm_gesture_t *)(p_this)) != 0);
+}
+
+/**
+ * @brief Check if all the buttons are released
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ * @return true
+ * @return false
+ */
+static bool check_released(fsm_t *p_this){
+    return !check_pressed(p_this);
+}
+
+/**
+ * @brief Check if all the buttons of a chord, i.e. more than one button, are released
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ * @return true
+ * @return false
+ */
+static bool check_chord_released(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return (check_released(p_this) && ((p_fsm->buttons & (p_fsm->buttons - 1)) != 0));
+}
+
+/**
+ * @brief Check if the last click of the longest multi-click has ended
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ * @return true
+ * @return false
+ */
+static bool check_last_click_released(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return (check_released(p_this) && ((p_fsm->clicks + 1) >= FSM_GESTURE_MAX_CLICKS));
+}
+
+/**
+ * @brief Check if a single button has been held for the hold time
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ * @return true
+ * @return false
+ */
+static bool check_hold(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return (((p_fsm->buttons & (p_fsm->buttons - 1)) == 0) && _check_deadline(p_fsm));
+}
+
+/**
+ * @brief Check if the buttons of the clicks so far are pressed again
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ * @return true
+ * @return false
+ */
+static bool check_same_pressed(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return (_get_pressed_mask(p_fsm) == p_fsm->buttons);
+}
+
+/**
+ * @brief Check if the click gap has passed without another press
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ * @return true
+ * @return false
+ */
+static bool check_gap_timeout(fsm_t *p_this){
+    return _check_deadline((fsm_gesture_t *)(p_this));
+}
+
+/* State machine output or action functions */
+/**
+ * @brief Start a new gesture with the buttons pressed, and start the hold time
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ */
+static void do_start_press(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->buttons = _get_pressed_mask(p_fsm);
+    p_fsm->clicks = 0;
+    p_fsm->deadline_ms = port_system_get_millis() + p_fsm->hold_time_ms;
+}
+
+/**
+ * @brief Start another click of the gesture in progress, and start the hold time
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ */
+static void do_continue_press(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->deadline_ms = port_system_get_millis() + p_fsm->hold_time_ms;
+}
+
+/**
+ * @brief Count a click and start the click gap
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ */
+static void do_count_click(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->clicks++;
+    p_fsm->deadline_ms = port_system_get_millis() + p_fsm->click_gap_ms;
+}
+
+/**
+ * @brief Report the clicks of the gesture in progress
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ */
+static void do_report_clicks(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    _report(p_fsm, GESTURE_SINGLE_CLICK + p_fsm->clicks - 1);
+}
+
+/**
+ * @brief Count the last click of the longest multi-click and report it
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ */
+static void do_report_last_click(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->clicks++;
+    do_report_clicks(p_this);
+}
+
+/**
+ * @brief Report the clicks so far, because other buttons have been pressed, and start a new gesture with them
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ */
+static void do_report_and_start(fsm_t *p_this){
+    do_report_clicks(p_this);
+    do_start_press(p_this);
+}
+
+/**
+ * @brief Report a press-and-hold
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ */
+static void do_report_hold(fsm_t *p_this){
+    _report((fsm_gesture_t *)(p_this), GESTURE_HOLD);
+}
+
+/**
+ * @brief Report a chord
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_gesture_t
+ */
+static void do_report_chord(fsm_t *p_this){
+    _report((fsm_gesture_t *)(p_this), GESTURE_CHORD);
+}
+
+/**
+ * @brief Array representing the transitions table of the gesture FSM
+ *
+ */
+static fsm_trans_t fsm_trans_gesture[] = {
+    { GESTURE_IDLE, check_pressed, GESTURE_PRESSED, do_start_press },
+    { GESTURE_PRESSED, check_chord_released, GESTURE_IDLE, do_report_chord },
+    { GESTURE_PRESSED, check_last_click_released, GESTURE_IDLE, do_report_last_click },
+    { GESTURE_PRESSED, check_released, GESTURE_RELEASED_WAIT, do_count_click },
+    { GESTURE_PRESSED, check_hold, GESTURE_HELD, do_report_hold },
+    { GESTURE_HELD, check_released, GESTURE_IDLE, NULL },
+    { GESTURE_RELEASED_WAIT, check_same_pressed, GESTURE_PRESSED, do_continue_press },
+    { GESTURE_RELEASED_WAIT, check_pressed, GESTURE_PRESSED, do_report_and_start },
+    { GESTURE_RELEASED_WAIT, check_gap_timeout, GESTURE_IDLE, do_report_clicks },
+    { -1 , NULL , -1, NULL }
+};
+
+/* Switch-based dispatch of the transitions table, generated by tools/fsm_codegen.py */
+#include "fsm_gesture_dispatch.inc"
+
+/* Static pool */
+/**
+ * @brief Static pool of gesture FSMs for `fsm_gesture_new_static()`.
+ *
+ */
+FSM_POOL_DEFINE(fsm_gesture, fsm_gesture_t, FSM_GESTURE_POOL_SIZE)
+
+/* Public functions */
+fsm_t *fsm_gesture_new(fsm_t **pp_fsm_buttons, uint32_t num_buttons, uint32_t click_gap_ms, uint32_t hold_time_ms){
+    fsm_t *p_fsm = malloc(sizeof(fsm_gesture_t)); /* Do malloc to reserve memory of all other FSM elements, although it is interpreted as fsm_t (the first element of the structure) */
+    fsm_gesture_init(p_fsm, pp_fsm_buttons, num_buttons, click_gap_ms, hold_time_ms);
+    return p_fsm;
+}
+
+fsm_t *fsm_gesture_new_static(fsm_t **pp_fsm_buttons, uint32_t num_buttons, uint32_t click_gap_ms, uint32_t hold_time_ms){
+    fsm_t *p_fsm = fsm_gesture_pool_take();
+    if (p_fsm == NULL){
+        return NULL;
+    }
+    fsm_gesture_init(p_fsm, pp_fsm_buttons, num_buttons, click_gap_ms, hold_time_ms);
+    return p_fsm;
+}
+
+void fsm_gesture_init(fsm_t *p_this, fsm_t **pp_fsm_buttons, uint32_t num_buttons, uint32_t click_gap_ms, uint32_t hold_time_ms){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    fsm_init(p_this, fsm_trans_gesture);
+    if (num_buttons > FSM_GESTURE_MAX_BUTTONS){
+        num_buttons = FSM_GESTURE_MAX_BUTTONS;
+    }
+    for (uint32_t i = 0; i < num_buttons; i++)
+    {
+        p_fsm->p_fsm_buttons[i] = pp_fsm_buttons[i];
+    }
+    p_fsm->num_buttons = num_buttons;
+    p_fsm->click_gap_ms = click_gap_ms;
+    p_fsm->hold_time_ms = hold_time_ms;
+    p_fsm->buttons = 0;
+    p_fsm->clicks = 0;
+    p_fsm->deadline_ms = 0;
+    p_fsm->gesture = GESTURE_NONE;
+    p_fsm->gesture_buttons = 0;
+}
+
+uint32_t fsm_gesture_get(fsm_t *p_this, uint32_t *p_buttons){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    if (p_buttons != NULL){
+        *p_buttons = p_fsm->gesture_buttons;
+    }
+    return p_fsm->gesture;
+}
+
+void fsm_gesture_clear(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    p_fsm->gesture = GESTURE_NONE;
+    p_fsm->gesture_buttons = 0;
+}
+
+void fsm_gesture_on_event(fsm_t *p_this, fsm_event_t event){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    if ((event.signal == FSM_EVENT_CHANGED) && (p_fsm->f.current_state == GESTURE_PRESSED)){
+        p_fsm->buttons |= _get_pressed_mask(p_fsm);
+    }
+}
+
+bool fsm_gesture_check_activity(fsm_t *p_this){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    return (p_fsm->f.current_state != GESTURE_IDLE);
+}
+
+bool fsm_gesture_get_deadline(fsm_t *p_this, uint32_t *p_deadline_ms){
+    fsm_gesture_t *p_fsm = (fsm_gesture_t *)(p_this);
+    if ((p_fsm->f.current_state != GESTURE_PRESSED) && (p_fsm->f.current_state != GESTURE_RELEASED_WAIT)){
+        return false;
+    }
+    *p_deadline_ms = p_fsm->deadline_ms;
+    return true;
+}
+
+int fsm_gesture_fire(fsm_t *p_this){
+    return fsm_gesture_dispatch(p_this);
+}
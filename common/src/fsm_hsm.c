@@ -0,0 +1,127 @@
+/**
+ * @file fsm_hsm.c
+ * @brief Hierarchical state machines on top of the transition tables of the FSMs.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Other libraries */
+#include "fsm_hsm.h"
+
+/* Private functions */
+/**
+ * @brief Get the entry of a state in the table of states.
+ *
+ * @param p_states Pointer to the table of states
+ * @param state State
+ * @return const fsm_hsm_state_t* Entry of the state. NULL if it is not in the table.
+ */
+static const fsm_hsm_state_t *_find(const fsm_hsm_state_t *p_states, int state){
+    for (; p_states->state >= 0; p_states++)
+    {
+        if (p_states->state == state){
+            return p_states;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Get the common ancestor of two states: the innermost state that contains both, or one of them if it contains the other.
+ *
+ * @param p_states Pointer to the table of states
+ * @param a First state
+ * @param b Second state
+ * @return int Common ancestor. `FSM_HSM_NO_PARENT` if they only share the top level.
+ */
+static int _get_common_ancestor(const fsm_hsm_state_t *p_states, int a, int b){
+    for (int s = a; s != FSM_HSM_NO_PARENT; s = fsm_hsm_get_parent(p_states, s))
+    {
+        if (fsm_hsm_is_in(p_states, b, s)){
+            return s;
+        }
+    }
+    return FSM_HSM_NO_PARENT;
+}
+
+/**
+ * @brief Fire a transition of a hierarchical state machine: exit actions, state update, output and entry actions.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @param p_states Pointer to the table of states
+ * @param p_t Pointer to the transition
+ */
+static void _fire_transition(fsm_t *p_fsm, const fsm_hsm_state_t *p_states, fsm_trans_t *p_t){
+    if (p_t->dest_state == FSM_HSM_INTERNAL){
+        if (p_t->out){
+            p_t->out(p_fsm);
+        }
+        return;
+    }
+
+    int from = p_fsm->current_state;
+    int to = p_t->dest_state;
+    int ancestor = (from == to) ? from : _get_common_ancestor(p_states, from, to);
+
+    // 1. Exit from the current state up to the common ancestor
+    for (int s = from; s != ancestor; s = fsm_hsm_get_parent(p_states, s))
+    {
+        const fsm_hsm_state_t *p_state = _find(p_states, s);
+        if (p_state && p_state->exit){
+            p_state->exit(p_fsm);
+        }
+    }
+
+    // 2. Change state and call the output, as fsm_fire() does
+    p_fsm->current_state = to;
+    if (p_t->out){
+        p_t->out(p_fsm);
+    }
+
+    // 3. Enter from below the common ancestor down to the destination state
+    int path[FSM_HSM_MAX_DEPTH];
+    int depth = 0;
+    for (int s = to; (s != ancestor) && (depth < FSM_HSM_MAX_DEPTH); s = fsm_hsm_get_parent(p_states, s))
+    {
+        path[depth++] = s;
+    }
+    while (depth > 0)
+    {
+        const fsm_hsm_state_t *p_state = _find(p_states, path[--depth]);
+        if (p_state && p_state->entry){
+            p_state->entry(p_fsm);
+        }
+    }
+}
+
+/* Public functions */
+int fsm_hsm_get_parent(const fsm_hsm_state_t *p_states, int state){
+    const fsm_hsm_state_t *p_state = _find(p_states, state);
+    return (p_state != NULL) ? p_state->parent : FSM_HSM_NO_PARENT;
+}
+
+bool fsm_hsm_is_in(const fsm_hsm_state_t *p_states, int state, int ancestor){
+    for (int s = state; s != FSM_HSM_NO_PARENT; s = fsm_hsm_get_parent(p_states, s))
+    {
+        if (s == ancestor){
+            return true;
+        }
+    }
+    return false;
+}
+
+int fsm_hsm_fire(fsm_t *p_fsm, fsm_trans_t *p_tt, const fsm_hsm_state_t *p_states){
+    for (int s = p_fsm->current_state; s != FSM_HSM_NO_PARENT; s = fsm_hsm_get_parent(p_states, s))
+    {
+        for (int row = 0; p_tt[row].orig_state >= 0; row++)
+        {
+            if ((p_tt[row].orig_state == s) && p_tt[row].in(p_fsm)){
+                _fire_transition(p_fsm, p_states, &p_tt[row]);
+                return row;
+            }
+        }
+    }
+    return -1;
+}
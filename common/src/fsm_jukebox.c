@@ -15,22 +15,37 @@
 // Other includes
 #include "fsm.h"
 #include "fsm_jukebox.h"
+#include "fsm_pool.h"
 #include "fsm_button.h"
 #include "fsm_usart.h"
 #include "fsm_buzzer.h"
 #include "port_system.h"
 #include "port_usart.h"
 #include "port_led.h"
+#include "port_button.h"
+#include "port_buzzer.h"
 #include "fsm_led.h"
+#include "fsm_telemetry.h"
+#include "fsm_gesture.h"
+#include "latency_trace.h"
+#include "fsm_trace.h"
+#include "fsm_active.h"
+#include "fsm_hsm.h"
 
 /* Defines ------------------------------------------------------------------*/
 #define MAX(a, b) ((a) > (b) ? (a) : (b)) /*!< Macro to get the maximum of two values. */
 
+/* Typedefs ------------------------------------------------------------------*/
 /**
- * @brief Variable to enable alternancy between LEDs.
- * 
+ * @brief Reply of a batch of commands, built while the commands are executed.
+ *
  */
-static bool led_state = false;
+typedef struct
+{
+    char text[USART_OUTPUT_BUFFER_LENGTH];  /*!<Replies of the commands, separated by `JUKEBOX_REPLY_SEPARATOR`*/
+    bool overflow;                          /*!<Flag to indicate that a reply did not fit and the text ends with `JUKEBOX_REPLY_OVERFLOW`*/
+} jukebox_reply_t;
+
 /* Private functions */
 /**
  * @brief Parse the message received by the USART.
@@ -76,13 +91,245 @@ bool _parse_message(char *p_message, char *p_command, char *p_param){
     }
     return true;
 }
+
+/**
+ * @brief Split a line received by the USART into the commands of a batch.
+ * 
+ * Given a line such as `select 2; speed 1.5; play`, this function splits it by `JUKEBOX_COMMAND_SEPARATOR` and stores a pointer to each command in `p_commands`. The whole line is split before any command is parsed, because `_parse_message()` also uses `strtok()`.
+ * 
+ * > 1. Split the message by `JUKEBOX_COMMAND_SEPARATOR` using function `strtok()` \n
+ * > 2. Store a pointer to each token until there are no more tokens or `JUKEBOX_MAX_BATCH_COMMANDS` have been stored \n
+ * > 3. Return the number of commands stored \n
+ * 
+ * @param p_message Pointer to the message received by the USART. It is modified in place.
+ * @param p_commands Array of `JUKEBOX_MAX_BATCH_COMMANDS` pointers to store the commands of the batch.
+ * @return uint32_t Number of commands of the batch.
+ */
+uint32_t _split_commands(char *p_message, char *p_commands[]){
+    uint32_t num_commands = 0;
+    char *p_token = strtok(p_message, JUKEBOX_COMMAND_SEPARATOR);
+
+    while ((p_token != NULL) && (num_commands < JUKEBOX_MAX_BATCH_COMMANDS))
+    {
+        p_commands[num_commands] = p_token;
+        num_commands++;
+        p_token = strtok(NULL, JUKEBOX_COMMAND_SEPARATOR);
+    }
+    return num_commands;
+}
+
+/**
+ * @brief Append the reply of a command to the reply of the batch.
+ * 
+ * Replies are separated by `JUKEBOX_REPLY_SEPARATOR` so that the whole batch is answered in a single line. If a reply does not fit in the output buffer of the USART, the reply of the batch is cut and ended with `JUKEBOX_REPLY_OVERFLOW`, the `overflow` flag is set and the next replies are dropped.
+ * 
+ * @param p_reply Pointer to the reply of the batch.
+ * @param p_text Pointer to the reply of the command, without end of line.
+ * @return true if the reply of the command has been appended completely
+ * @return false if the reply of the batch has overflowed, now or in a previous command
+ */
+bool _append_reply(jukebox_reply_t *p_reply, const char *p_text){
+    // Keep room for the end char and the null terminator
+    uint32_t max_length = USART_OUTPUT_BUFFER_LENGTH - 2;
+    uint32_t length = strlen(p_reply->text);
+    uint32_t separator_length = (p_reply->text[0] != EMPTY_BUFFER_CONSTANT) ? strlen(JUKEBOX_REPLY_SEPARATOR) : 0;
+
+    if (p_reply->overflow)
+    {
+        return false; // A previous reply has already overflowed
+    }
+    if (length + separator_length + strlen(p_text) <= max_length)
+    {
+        if (separator_length != 0)
+        {
+            strcat(p_reply->text, JUKEBOX_REPLY_SEPARATOR);
+        }
+        strcat(p_reply->text, p_text);
+        return true;
+    }
+    // Fill the buffer with as much as fits, and end it with the overflow marker
+    uint32_t fit_length = max_length - strlen(JUKEBOX_REPLY_OVERFLOW);
+    if (length > fit_length)
+    {
+        p_reply->text[fit_length] = EMPTY_BUFFER_CONSTANT;
+    }
+    else
+    {
+        if (separator_length != 0)
+        {
+            strncat(p_reply->text, JUKEBOX_REPLY_SEPARATOR, fit_length - length);
+        }
+        strncat(p_reply->text, p_text, fit_length - strlen(p_reply->text));
+    }
+    strcat(p_reply->text, JUKEBOX_REPLY_OVERFLOW);
+    p_reply->overflow = true;
+    return false;
+}
+
+/**
+ * @brief Post a change of the player to the buzzer FSM. All the changes (action, melody, speed, effect and output) are posted as events, so the buzzer applies them in `fsm_buzzer_on_event()` in the order they are requested, and the dispatcher of `fsm_active` fires it after each one. If the buzzer is not run by the dispatcher, the change is applied at once.
+ *
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @param event Change of the player, with one of the player signals of `FSM_EVENT_SIGNAL`
+ * @return true if the change has been queued or applied
+ * @return false if the queue of the buzzer is full. The change is lost, and it is reported in the terminal.
+ */
+bool _post_buzzer(fsm_jukebox_t *p_fsm_jukebox, fsm_event_t event){
+    if (fsm_active_get_priority(p_fsm_jukebox->p_fsm_buzzer) < 0){
+        fsm_buzzer_on_event(p_fsm_jukebox->p_fsm_buzzer, event);
+        return true;
+    }
+    if (fsm_active_post(p_fsm_jukebox->p_fsm_buzzer, event)){
+        return true;
+    }
+    printf("Error: Player busy\n");
+    return false;
+}
+
+/**
+ * @brief Request an action on the player.
+ *
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @param action Action to perform on the player, one of `USER_ACTIONS`
+ * @return true if the request has been posted to the buzzer
+ * @return false if the queue of the buzzer is full
+ */
+bool _set_buzzer_action(fsm_jukebox_t *p_fsm_jukebox, uint8_t action){
+    return _post_buzzer(p_fsm_jukebox, (fsm_event_t){.signal = FSM_EVENT_ACTION, .param = action});
+}
+
+/**
+ * @brief Request a melody on the player.
+ *
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @param p_melody Pointer to the melody. It must not be freed while the request is in the queue.
+ * @return true if the request has been posted to the buzzer
+ * @return false if the queue of the buzzer is full
+ */
+bool _set_buzzer_melody(fsm_jukebox_t *p_fsm_jukebox, const melody_t *p_melody){
+    return _post_buzzer(p_fsm_jukebox, (fsm_event_t){.signal = FSM_EVENT_MELODY, .p_data = p_melody});
+}
+
+/**
+ * @brief Request a speed on the player.
+ *
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @param speed Speed of the player
+ * @return true if the request has been posted to the buzzer
+ * @return false if the queue of the buzzer is full
+ */
+bool _set_buzzer_speed(fsm_jukebox_t *p_fsm_jukebox, double speed){
+    return _post_buzzer(p_fsm_jukebox, (fsm_event_t){.signal = FSM_EVENT_SPEED, .value = speed});
+}
+
+/**
+ * @brief Request a pitch effect on the player.
+ *
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @param effect Pitch effect, one of `PORT_BUZZER_EFFECTS`
+ * @return true if the request has been posted to the buzzer
+ * @return false if the queue of the buzzer is full
+ */
+bool _set_buzzer_effect(fsm_jukebox_t *p_fsm_jukebox, uint8_t effect){
+    return _post_buzzer(p_fsm_jukebox, (fsm_event_t){.signal = FSM_EVENT_EFFECT, .param = effect});
+}
+
+/**
+ * @brief Request an output on the player.
+ *
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @param output Output, one of `PORT_BUZZER_OUTPUTS`
+ * @return true if the request has been posted to the buzzer
+ * @return false if the queue of the buzzer is full
+ */
+bool _set_buzzer_output(fsm_jukebox_t *p_fsm_jukebox, uint8_t output){
+    return _post_buzzer(p_fsm_jukebox, (fsm_event_t){.signal = FSM_EVENT_OUTPUT, .param = output});
+}
+
+/**
+ * @brief Get the snapshot of the inputs of the Jukebox, and take it first if the dispatcher has started a new epoch since it was taken.
+ * 
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @return const fsm_jukebox_inputs_t* Pointer to the snapshot
+ */
+const fsm_jukebox_inputs_t *_get_inputs(fsm_jukebox_t *p_fsm_jukebox){
+    fsm_jukebox_inputs_t *p_inputs = &p_fsm_jukebox->inputs;
+    uint32_t epoch = fsm_active_get_epoch();
+    if (p_inputs->valid && (p_inputs->epoch == epoch)){
+        return p_inputs;
+    }
+    p_inputs->epoch = epoch;
+    p_inputs->valid = true;
+    p_inputs->activity = fsm_buzzer_check_activity(p_fsm_jukebox->p_fsm_buzzer) || fsm_usart_check_activity(p_fsm_jukebox->p_fsm_usart) || ((p_fsm_jukebox->p_fsm_telemetry != NULL) && fsm_telemetry_check_activity(p_fsm_jukebox->p_fsm_telemetry));
+    p_inputs->command_received = fsm_usart_check_data_received(p_fsm_jukebox->p_fsm_usart);
+    p_inputs->melody_finished = (fsm_buzzer_get_action(p_fsm_jukebox->p_fsm_buzzer) == STOP);
+    p_inputs->button_duration = fsm_button_get_duration(p_fsm_jukebox->p_fsm_button);
+    p_inputs->button_held = fsm_button_get_held_duration(p_fsm_jukebox->p_fsm_button);
+    p_inputs->gesture = (p_fsm_jukebox->p_fsm_gesture != NULL) ? fsm_gesture_get(p_fsm_jukebox->p_fsm_gesture, NULL) : GESTURE_NONE;
+    return p_inputs;
+}
+
+/**
+ * @brief Get the time to sleep until the nearest deadline of the FSMs, for the tickless idle: the hold time or click gap of the gestures. The debounce of the button needs no deadline: its timer wakes the system up. While the button is held, the time when it crosses the ON/OFF time is also a deadline.
+ * 
+ * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @return uint32_t Time to sleep in ms. `PORT_SYSTEM_SLEEP_FOREVER` if no FSM has a deadline.
+ */
+uint32_t _get_sleep_time(fsm_jukebox_t *p_fsm_jukebox){
+    uint32_t now = port_system_get_millis();
+    uint32_t sleep_ms = PORT_SYSTEM_SLEEP_FOREVER;
+    uint32_t deadline_ms;
+    if ((p_fsm_jukebox->p_fsm_gesture != NULL) && fsm_gesture_get_deadline(p_fsm_jukebox->p_fsm_gesture, &deadline_ms)){
+        int32_t time_to_deadline = (int32_t)(deadline_ms - now);
+        uint32_t time_ms = (time_to_deadline > 0) ? (uint32_t)time_to_deadline : 0;
+        if (time_ms < sleep_ms){
+            sleep_ms = time_ms;
+        }
+    }
+    // Wake up when the button held crosses the ON/OFF time, to act before the release
+    uint32_t held_ms = fsm_button_get_held_duration(p_fsm_jukebox->p_fsm_button);
+    if ((held_ms > 0) && (held_ms <= p_fsm_jukebox->on_off_press_time_ms)){
+        uint32_t time_ms = p_fsm_jukebox->on_off_press_time_ms - held_ms + 1;
+        if (time_ms < sleep_ms){
+            sleep_ms = time_ms;
+        }
+    }
+    return sleep_ms;
+}
+
+/**
+ * @brief Sleep until an interrupt or the nearest deadline of the FSMs.
+ * 
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
+ */
+void _sleep(fsm_t *p_this){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
+    port_system_sleep_for(_get_sleep_time(p_fsm_jukebox));
+}
+
+/**
+ * @brief Enter STOP mode until the button wakes the system up. If an FSM has a deadline, or the debounce of the button is in progress, the timers are needed, so it sleeps in Sleep mode until the deadline or an interrupt.
+ * 
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
+ */
+void _deep_sleep(fsm_t *p_this){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
+    uint32_t sleep_ms = _get_sleep_time(p_fsm_jukebox);
+    if ((sleep_ms != PORT_SYSTEM_SLEEP_FOREVER) || port_button_check_debouncing()){
+        port_system_sleep_for(sleep_ms);
+        return;
+    }
+    port_system_stop();
+}
+
 /**
  * @brief Set the next song to be played.
  * 
  * @param p_fsm_jukebox Pointer to the Jukebox FSM
+ * @return true if the song has been posted to the buzzer
+ * @return false if the queue of the buzzer is full
  */
-void _set_next_song(fsm_jukebox_t *p_fsm_jukebox){
-    fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, STOP);
+bool _set_next_song(fsm_jukebox_t *p_fsm_jukebox){
     if(p_fsm_jukebox->melody_idx >= MELODIES_MEMORY_SIZE){
         p_fsm_jukebox->melody_idx = 0;
     }
@@ -91,18 +338,9 @@ void _set_next_song(fsm_jukebox_t *p_fsm_jukebox){
     }
     p_fsm_jukebox->p_melody= p_fsm_jukebox->melodies[p_fsm_jukebox->melody_idx].p_name;
     printf("Playing %s\n", p_fsm_jukebox->melodies[p_fsm_jukebox->melody_idx].p_name);
-    fsm_buzzer_set_melody(p_fsm_jukebox->p_fsm_buzzer, &p_fsm_jukebox->melodies[p_fsm_jukebox->melody_idx]);
-    fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, PLAY);
-    // Se alterna la iluminación de los LEDs a cada melodia reproducida
-    led_state = !led_state;  
-    if (led_state) {
-        port_led_turn_on(LED_0_ID);  
-        port_led_turn_off(LED_1_ID);  
-    } else {
-        port_led_turn_off(LED_0_ID);  
-        port_led_turn_on(LED_1_ID);  
-    }
+    bool posted = _set_buzzer_action(p_fsm_jukebox, STOP) && _set_buzzer_melody(p_fsm_jukebox, &p_fsm_jukebox->melodies[p_fsm_jukebox->melody_idx]) && _set_buzzer_action(p_fsm_jukebox, PLAY);
     p_fsm_jukebox->melody_idx++;
+    return posted;
 }
 
 /**
@@ -111,124 +349,188 @@ void _set_next_song(fsm_jukebox_t *p_fsm_jukebox){
  * @param p_fsm_jukebox Pointer to the Jukebox FSM.
  * @param p_command Pointer to the command to be executed.
  * @param p_param Pointer to the parameter of the command to be executed.
+ * @param p_reply Pointer to the reply of the batch the command belongs to. The reply of the command (if any) is appended to it.
+ * @return true if the command has requested an action on the player
+ * @return false if the command does not act on the player, or the request has not fit in the queue of the buzzer
  */
-void _execute_command(fsm_jukebox_t *p_fsm_jukebox, char *p_command, char *p_param ){
+bool _execute_command(fsm_jukebox_t *p_fsm_jukebox, char *p_command, char *p_param, jukebox_reply_t *p_reply){
+    bool player_action = false;
+    bool posted = true;
+    latency_trace_mark(LATENCY_STAGE_EXECUTE, port_system_get_cycles());
     if(!strcmp(p_command,"play")){
-        fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, PLAY);      
+        posted = _set_buzzer_action(p_fsm_jukebox, PLAY);      
+        player_action = true;
     }
     else if(!strcmp(p_command, "stop")){
-        fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, STOP);        
+        posted = _set_buzzer_action(p_fsm_jukebox, STOP);        
+        player_action = true;
     }
     else if(!strcmp(p_command, "pause")){
-        fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, PAUSE);               
+        posted = _set_buzzer_action(p_fsm_jukebox, PAUSE);               
+        player_action = true;
     }
     else if(!strcmp(p_command, "speed")){
         double param = atof(p_param);
-        fsm_buzzer_set_speed(p_fsm_jukebox->p_fsm_buzzer, MAX(param, 0.1));                
+        posted = _set_buzzer_speed(p_fsm_jukebox, MAX(param, 0.1));                
+    }
+    else if(!strcmp(p_command, "effect")){
+        if(!strcmp(p_param, "none")){
+            posted = _set_buzzer_effect(p_fsm_jukebox, PORT_BUZZER_EFFECT_NONE);
+        }
+        else if(!strcmp(p_param, "vibrato")){
+            posted = _set_buzzer_effect(p_fsm_jukebox, PORT_BUZZER_EFFECT_VIBRATO);
+        }
+        else if(!strcmp(p_param, "glide")){
+            posted = _set_buzzer_effect(p_fsm_jukebox, PORT_BUZZER_EFFECT_GLIDE);
+        }
+        else{
+            _append_reply(p_reply, "Error: Effect not found");
+        }
+    }
+    else if(!strcmp(p_command, "output")){
+        if(!strcmp(p_param, "pwm")){
+            posted = _set_buzzer_output(p_fsm_jukebox, PORT_BUZZER_OUTPUT_PWM);
+        }
+        else if(!strcmp(p_param, "dac")){
+            posted = _set_buzzer_output(p_fsm_jukebox, PORT_BUZZER_OUTPUT_DAC);
+        }
+        else{
+            _append_reply(p_reply, "Error: Output not found");
+        }
     }
     else if(!strcmp(p_command, "next")){
-        _set_next_song(p_fsm_jukebox);               
+        posted = _set_next_song(p_fsm_jukebox);               
+        player_action = true;
     }
     else if(!strcmp(p_command, "select")){
         uint32_t melody_selected = atoi(p_param);
-        if(p_fsm_jukebox->melodies[melody_selected].melody_length != 0){
+        if((melody_selected < MELODIES_MEMORY_SIZE) && (p_fsm_jukebox->melodies[melody_selected].melody_length != 0)){
             p_fsm_jukebox->melody_idx = melody_selected;
-            fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, STOP);
-            fsm_buzzer_set_melody(p_fsm_jukebox->p_fsm_buzzer, &p_fsm_jukebox->melodies[p_fsm_jukebox->melody_idx]);
             p_fsm_jukebox->p_melody= p_fsm_jukebox->melodies[p_fsm_jukebox->melody_idx].p_name;
-            fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, PLAY);
-            // Se alterna la iluminación de los LEDs a cada melodia reproducida
-            led_state = !led_state;  
-            if (led_state) {
-                port_led_turn_on(LED_0_ID);  
-                port_led_turn_off(LED_1_ID);  
-            } else {
-                port_led_turn_off(LED_0_ID);  
-                port_led_turn_on(LED_1_ID);  
-            }
-                }
+            posted = _set_buzzer_action(p_fsm_jukebox, STOP) && _set_buzzer_melody(p_fsm_jukebox, &p_fsm_jukebox->melodies[p_fsm_jukebox->melody_idx]) && _set_buzzer_action(p_fsm_jukebox, PLAY);
+            player_action = true;
+        }
         else{
-            fsm_usart_set_out_data(p_fsm_jukebox->p_fsm_usart, "Error: Melody not found\n");
+            _append_reply(p_reply, "Error: Melody not found");
         }              
     }
+    else if(!strcmp(p_command, "telemetry")){
+        char msg[USART_OUTPUT_BUFFER_LENGTH];
+        if(p_fsm_jukebox->p_fsm_telemetry == NULL){
+            _append_reply(p_reply, "Error: Telemetry not available");
+        }
+        else{
+            fsm_telemetry_set_period(p_fsm_jukebox->p_fsm_telemetry, atoi(p_param));
+            uint32_t period_ms = fsm_telemetry_get_period(p_fsm_jukebox->p_fsm_telemetry);
+            if(period_ms == 0){
+                _append_reply(p_reply, "Telemetry off");
+            }
+            else{
+                sprintf(msg, "Telemetry every %lu ms", (unsigned long)period_ms);
+                _append_reply(p_reply, msg);
+            }
+        }
+    }
+    else if(!strcmp(p_command, "latency")){
+        char msg[LATENCY_DUMP_LENGTH];
+        if(!strcmp(p_param, "reset")){
+            latency_trace_reset();
+            _append_reply(p_reply, "Latency reset");
+        }
+        else{
+            latency_trace_dump(atoi(p_param), msg);
+            _append_reply(p_reply, msg);
+        }
+    }
+    else if(!strcmp(p_command, "trace")){
+        char msg[FSM_TRACE_DUMP_LENGTH];
+        if(!strcmp(p_param, "reset")){
+            fsm_trace_reset();
+            _append_reply(p_reply, "Trace reset");
+        }
+        else{
+            fsm_trace_dump(strtoul(p_param, NULL, 10), msg);
+            _append_reply(p_reply, msg);
+        }
+    }
     else if(!strcmp(p_command, "info")){
         char msg[USART_OUTPUT_BUFFER_LENGTH];
-        sprintf(msg,"Playing %s\n", p_fsm_jukebox->p_melody);
-        fsm_usart_set_out_data(p_fsm_jukebox->p_fsm_usart, msg);
+        sprintf(msg,"Playing %s", p_fsm_jukebox->p_melody);
+        _append_reply(p_reply, msg);
     }
     else {
-        fsm_usart_set_out_data(p_fsm_jukebox->p_fsm_usart, "Error: Command not found\n");
+        _append_reply(p_reply, "Error: Command not found");
     }
-    return;
+    if(!posted){
+        _append_reply(p_reply, "Error: Player busy");
+    }
+    return player_action && posted;
 }	
 
 /* State machine input or transition functions */
 /**
- * @brief Check if any of the elements of the system is active
+ * @brief Check if the USART has received data
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  * @return true 
  * @return false 
  */
-static bool check_activity(fsm_t *p_this){
+static bool check_command_received(fsm_t *p_this){
     fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
-    //return (fsm_button_check_activity(p_fsm_jukebox->p_fsm_button) || fsm_buzzer_check_activity(p_fsm_jukebox->p_fsm_buzzer) || fsm_usart_check_activity(p_fsm_jukebox->p_fsm_usart));
-    bool a = fsm_button_check_activity(p_fsm_jukebox->p_fsm_button);
-    bool b = fsm_buzzer_check_activity(p_fsm_jukebox->p_fsm_buzzer);
-    bool c = fsm_usart_check_activity(p_fsm_jukebox->p_fsm_usart);
-    return (a || b || c);
+    return(_get_inputs(p_fsm_jukebox)->command_received);
 }
 
 /**
- * @brief Check if the USART has received data
+ * @brief Check if the buzzer has finished playing the melody
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  * @return true 
  * @return false 
  */
-static bool check_command_received(fsm_t *p_this){
+static bool check_melody_finished(fsm_t *p_this){
     fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
-    return(fsm_usart_check_data_received(p_fsm_jukebox->p_fsm_usart));
+    return(_get_inputs(p_fsm_jukebox)->melody_finished);
 }
 
 /**
- * @brief Check if the buzzer has finished playing the melody
+ * @brief Check if the button has been pressed for the required time to load the next song
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  * @return true 
  * @return false 
  */
-static bool check_melody_finished(fsm_t *p_this){
+static bool check_next_song_button(fsm_t *p_this){
     fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
-    return(fsm_buzzer_get_action(p_fsm_jukebox->p_fsm_buzzer) == STOP);
+    uint32_t duracion = _get_inputs(p_fsm_jukebox)->button_duration;
+    return((duracion > 0)&& (duracion > p_fsm_jukebox->next_song_press_time_ms) && (duracion < p_fsm_jukebox->on_off_press_time_ms));
 }
 
 /**
- * @brief Check if the button has been pressed for the required time to load the next song
+ * @brief Check if the buttons have been double clicked
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  * @return true 
  * @return false 
  */
-static bool check_next_song_button(fsm_t *p_this){
+static bool check_double_click(fsm_t *p_this){
     fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
-    uint32_t duracion = fsm_button_get_duration(p_fsm_jukebox->p_fsm_button);
-    return((duracion > 0)&& (duracion > p_fsm_jukebox->next_song_press_time_ms) && (duracion < p_fsm_jukebox->on_off_press_time_ms));
+    return (_get_inputs(p_fsm_jukebox)->gesture == GESTURE_DOUBLE_CLICK);
 }
 
 /**
- * @brief Check if all the is system active
+ * @brief Check if none of the elements of the system is active
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  * @return true 
  * @return false 
  */
 static bool check_no_activity(fsm_t *p_this){
-    return(!check_activity(p_this));
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
+    return(!_get_inputs(p_fsm_jukebox)->activity);
 }
 
 /**
- * @brief Check if the button has been pressed for the required time to turn ON the Jukebox
+ * @brief Check if the button has been pressed for the required time to turn ON the Jukebox. It is true as soon as the button held crosses the time, without waiting for the release.
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  * @return true 
@@ -236,8 +538,9 @@ static bool check_no_activity(fsm_t *p_this){
  */
 static bool check_on(fsm_t *p_this){
     fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
-    uint32_t duracion = fsm_button_get_duration(p_fsm_jukebox->p_fsm_button);
-    return((duracion > 0) && (duracion > p_fsm_jukebox->on_off_press_time_ms));
+    const fsm_jukebox_inputs_t *p_inputs = _get_inputs(p_fsm_jukebox);
+    uint32_t duracion = p_inputs->button_duration;
+    return(((duracion > 0) && (duracion > p_fsm_jukebox->on_off_press_time_ms)) || (p_inputs->button_held > p_fsm_jukebox->on_off_press_time_ms));
 }
 
 /**
@@ -264,57 +567,78 @@ static void do_load_next_song(fsm_t *p_this){
 }
 
 /**
- * @brief Read the command received by the USART
+ * @brief Pause the melody playing, or resume it if it is paused
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  */
-static void do_read_command(fsm_t *p_this){
+static void do_toggle_pause(fsm_t *p_this){
     fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
-    char p_message[USART_INPUT_BUFFER_LENGTH];
-    char p_command[USART_INPUT_BUFFER_LENGTH];
-    char p_param[USART_INPUT_BUFFER_LENGTH];
-    fsm_usart_get_in_data(p_fsm_jukebox->p_fsm_usart, p_message);
-    bool valid = _parse_message(p_message, p_command, p_param);
-    if(valid){
-        _execute_command(p_fsm_jukebox, p_command, p_param);
-    }
-    fsm_usart_reset_input_data(p_fsm_jukebox->p_fsm_usart);
+    fsm_gesture_clear(p_fsm_jukebox->p_fsm_gesture);
+    _set_buzzer_action(p_fsm_jukebox, (fsm_buzzer_get_action(p_fsm_jukebox->p_fsm_buzzer) == PLAY) ? PAUSE : PLAY);
 }
 
 /**
- * @brief Start the low power mode while the Jukebox is OFF
+ * @brief Read the batch of commands received by the USART
  * 
- * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
- */
-static void do_sleep_off(fsm_t *p_this){
-    port_system_sleep();
-}
-
-/**
- * @brief Start the low power mode while the Jukebox is waiting for a command
+ * A single line may contain several commands separated by `JUKEBOX_COMMAND_SEPARATOR` (e.g., `select 2; speed 1.5; play`). They are executed as a pipeline within this action:
+ * 
+ * > 1. Split the line into the commands of the batch \n
+ * > 2. Parse and execute each command in order \n
+ * > 3. Abandon the latency trace if no command has acted on the player \n
+ * > 4. Send the replies of all the commands in a single message \n
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  */
-static void do_sleep_wait_command(fsm_t *p_this){
-    port_system_sleep();
+static void do_read_command(fsm_t *p_this){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
+    char p_message[USART_INPUT_BUFFER_LENGTH + 1];
+    char p_command[USART_INPUT_BUFFER_LENGTH + 1];
+    char p_param[USART_INPUT_BUFFER_LENGTH + 1];
+    jukebox_reply_t reply = {.overflow = false};
+    char *p_commands[JUKEBOX_MAX_BATCH_COMMANDS];
+    bool player_action = false;
+
+    latency_trace_mark(LATENCY_STAGE_READ_COMMAND, port_system_get_cycles());
+    fsm_usart_get_in_data(p_fsm_jukebox->p_fsm_usart, p_message);
+    p_message[USART_INPUT_BUFFER_LENGTH] = EMPTY_BUFFER_CONSTANT; // The input data is not null terminated if the buffer is full
+    memset(reply.text, EMPTY_BUFFER_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
+
+    uint32_t num_commands = _split_commands(p_message, p_commands);
+    for (uint32_t i = 0; i < num_commands; i++)
+    {
+        bool valid = _parse_message(p_commands[i], p_command, p_param);
+        if(valid){
+            player_action |= _execute_command(p_fsm_jukebox, p_command, p_param, &reply);
+        }
+    }
+    if (!player_action)
+    {
+        latency_trace_abandon(); // No register write will close the trace of this batch
+    }
+    if (reply.text[0] != EMPTY_BUFFER_CONSTANT)
+    {
+        strcat(reply.text, "\n");
+        fsm_usart_set_out_data(p_fsm_jukebox->p_fsm_usart, reply.text);
+    }
+    fsm_usart_reset_input_data(p_fsm_jukebox->p_fsm_usart);
 }
 
 /**
- * @brief Start the low power mode while the Jukebox is OFF
+ * @brief Start the low power mode, while the Jukebox is OFF or waiting for a command. The dispatcher of `fsm_active` enters it with `_sleep()` once every FSM has processed its events.
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  */
-static void do_sleep_while_off(fsm_t *p_this){
-    port_system_sleep();
+static void do_sleep(fsm_t *p_this){
+    fsm_active_request_idle(p_this, _sleep);
 }
 
 /**
- * @brief Start the low power mode while the Jukebox is ON
+ * @brief Start the deep low power mode while the Jukebox is OFF. The dispatcher of `fsm_active` enters it with `_deep_sleep()` once every FSM has processed its events.
  * 
  * @param p_this Pointer to an fsm_t struct that contains an fsm_jukebox_t
  */
-static void do_sleep_while_on(fsm_t *p_this){
-    port_system_sleep();
+static void do_deep_sleep(fsm_t *p_this){
+    fsm_active_request_idle(p_this, _deep_sleep);
 }
 
 /**
@@ -326,6 +650,9 @@ static void do_start_jukebox(fsm_t *p_this){
     fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
     p_fsm_jukebox->melody_idx = 0;
     p_fsm_jukebox->p_melody = scale_melody.p_name;
+    if (p_fsm_jukebox->p_fsm_gesture != NULL){
+        fsm_gesture_clear(p_fsm_jukebox->p_fsm_gesture); // The gestures while it was OFF are not commands
+    }
 }
 
 /**
@@ -338,9 +665,9 @@ static void do_start_up(fsm_t *p_this){
     fsm_button_reset_duration(p_fsm_jukebox->p_fsm_button);
     fsm_usart_enable_rx_interrupt(p_fsm_jukebox->p_fsm_usart);
     printf("JUKEBOX ON\n");
-    fsm_buzzer_set_speed(p_fsm_jukebox->p_fsm_buzzer, 1.0);
-    fsm_buzzer_set_melody(p_fsm_jukebox->p_fsm_buzzer, &scale_melody);
-    fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, PLAY);
+    _set_buzzer_speed(p_fsm_jukebox, 1.0);
+    _set_buzzer_melody(p_fsm_jukebox, &scale_melody);
+    _set_buzzer_action(p_fsm_jukebox, PLAY);
     fsm_button_reset_duration(p_fsm_jukebox->p_fsm_button);
 }
 
@@ -353,7 +680,7 @@ static void do_stop_jukebox(fsm_t *p_this){
     fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t  *)(p_this);
     fsm_button_reset_duration(p_fsm_jukebox->p_fsm_button);
     fsm_usart_disable_rx_interrupt(p_fsm_jukebox->p_fsm_usart);
-    fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, STOP);
+    _set_buzzer_action(p_fsm_jukebox, STOP);
 }
 
 /**
@@ -366,36 +693,55 @@ static void do_shutdown_jukebox(fsm_t *p_this){
     fsm_button_reset_duration(p_fsm_jukebox->p_fsm_button);
     fsm_usart_disable_rx_interrupt(p_fsm_jukebox->p_fsm_usart);
     printf("JUKEBOX OFF\n");
-    fsm_buzzer_set_speed(p_fsm_jukebox->p_fsm_buzzer, 1.0);
-    fsm_buzzer_set_melody(p_fsm_jukebox->p_fsm_buzzer, &inverse_scale_melody);
-    fsm_buzzer_set_action(p_fsm_jukebox->p_fsm_buzzer, PLAY);
+    _set_buzzer_speed(p_fsm_jukebox, 1.0);
+    _set_buzzer_melody(p_fsm_jukebox, &inverse_scale_melody);
+    _set_buzzer_action(p_fsm_jukebox, PLAY);
     fsm_button_reset_duration(p_fsm_jukebox->p_fsm_button);
     fsm_led_turn_off(LED_0_ID);
     fsm_led_turn_off(LED_1_ID);
 }
 
+/**
+ * @brief Array representing the hierarchy of states of the FSM Jukebox. OFF and WAIT_COMMAND share the superstate LOW_POWER, so the low power mode is written once for both.
+ * 
+ */
+fsm_hsm_state_t fsm_states_jukebox[] = {
+    { OFF, LOW_POWER, NULL, NULL},
+    { WAIT_COMMAND, LOW_POWER, NULL, NULL},
+    { LOW_POWER, FSM_HSM_NO_PARENT, NULL, NULL},
+    { -1 , -1 , NULL, NULL }
+};
+
 /**
  * @brief Array representing the transitions table of the FSM Jukebox
  * > This FSM diagram is not the same as implemented in Version 4 of the project. This is the Version 5 Jukebox FSM which includes a new state SHUT DOWN. For more information look at section Version 5 in the main page of the API \n
+ * > The states SLEEP_WHILE_ON and SLEEP_WHILE_OFF of the diagram are now the internal transition of the superstate LOW_POWER, checked after the rows of OFF and WAIT_COMMAND. OFF overrides it with its own internal transition to STOP mode. \n
  * @image html fsm_jukebox_states.png
  * 
  */
 fsm_trans_t fsm_trans_jukebox[] = {
     { OFF, check_on, START_UP, do_start_up},
-    { OFF, check_no_activity, SLEEP_WHILE_OFF, do_sleep_off},
+    { OFF, check_no_activity, FSM_HSM_INTERNAL, do_deep_sleep},
     { START_UP, check_melody_finished, WAIT_COMMAND, do_start_jukebox},
     { WAIT_COMMAND, check_next_song_button, WAIT_COMMAND, do_load_next_song},
+    { WAIT_COMMAND, check_double_click, WAIT_COMMAND, do_toggle_pause},
     { WAIT_COMMAND, check_command_received, WAIT_COMMAND, do_read_command},
-    { WAIT_COMMAND, check_no_activity, SLEEP_WHILE_ON, do_sleep_wait_command},
     { WAIT_COMMAND, check_off, SHUT_DOWN, do_shutdown_jukebox},
     { SHUT_DOWN, check_melody_finished, OFF, do_stop_jukebox},
-    { SLEEP_WHILE_ON, check_no_activity, SLEEP_WHILE_ON, do_sleep_while_on},
-    { SLEEP_WHILE_ON, check_activity, WAIT_COMMAND, NULL},
-    { SLEEP_WHILE_OFF, check_no_activity, SLEEP_WHILE_OFF, do_sleep_while_off},
-    { SLEEP_WHILE_OFF, check_activity, OFF, NULL},
+    { LOW_POWER, check_no_activity, FSM_HSM_INTERNAL, do_sleep},
     { -1 , NULL , -1, NULL }
 };
 
+/* Switch-based dispatch of the transitions table, generated by tools/fsm_codegen.py */
+#include "fsm_jukebox_dispatch.inc"
+
+/* Static pool */
+/**
+ * @brief Static pool of Jukebox FSMs for `fsm_jukebox_new_static()`.
+ *
+ */
+FSM_POOL_DEFINE(fsm_jukebox, fsm_jukebox_t, FSM_JUKEBOX_POOL_SIZE)
+
 /* Public functions */
 fsm_t *fsm_jukebox_new(fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t *p_fsm_usart, fsm_t *p_fsm_buzzer, uint32_t next_song_press_time_ms, fsm_t *p_fsm_led0, fsm_t *p_fsm_led1){
     fsm_t *p_fsm = malloc(sizeof(fsm_jukebox_t));
@@ -403,6 +749,15 @@ fsm_t *fsm_jukebox_new(fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t
     return p_fsm;
 }
 
+fsm_t *fsm_jukebox_new_static(fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t *p_fsm_usart, fsm_t *p_fsm_buzzer, uint32_t next_song_press_time_ms, fsm_t *p_fsm_led0, fsm_t *p_fsm_led1){
+    fsm_t *p_fsm = fsm_jukebox_pool_take();
+    if (p_fsm == NULL){
+        return NULL;
+    }
+    fsm_jukebox_init(p_fsm, p_fsm_button, on_off_press_time_ms, p_fsm_usart, p_fsm_buzzer, next_song_press_time_ms, p_fsm_led0, p_fsm_led1);
+    return p_fsm;
+}
+
 void fsm_jukebox_init(fsm_t *p_this, fsm_t *p_fsm_button, uint32_t on_off_press_time_ms, fsm_t *p_fsm_usart, fsm_t *p_fsm_buzzer, uint32_t next_song_press_time_ms, fsm_t *p_fsm_led0, fsm_t *p_fsm_led1){
     fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)(p_this);
     fsm_init(p_this, fsm_trans_jukebox);
@@ -411,6 +766,9 @@ void fsm_jukebox_init(fsm_t *p_this, fsm_t *p_fsm_button, uint32_t on_off_press_
     p_fsm_jukebox->p_fsm_buzzer = p_fsm_buzzer;
     p_fsm_jukebox->p_fsm_led0 = p_fsm_led0;
     p_fsm_jukebox->p_fsm_led1 = p_fsm_led1;
+    p_fsm_jukebox->p_fsm_telemetry = NULL;
+    p_fsm_jukebox->p_fsm_gesture = NULL;
+    memset(&p_fsm_jukebox->inputs, 0, sizeof(p_fsm_jukebox->inputs));
     p_fsm_jukebox->on_off_press_time_ms = on_off_press_time_ms;
     p_fsm_jukebox->next_song_press_time_ms = next_song_press_time_ms;
     p_fsm_jukebox->melody_idx = 0;
@@ -419,4 +777,23 @@ void fsm_jukebox_init(fsm_t *p_this, fsm_t *p_fsm_button, uint32_t on_off_press_
     p_fsm_jukebox->melodies[1] = happy_birthday_melody;
     p_fsm_jukebox->melodies[2] = avemaria_melody;
     p_fsm_jukebox->melodies[3] = pp_hymn_melody;
-}
\ No newline at end of file
+}
+
+void fsm_jukebox_set_telemetry(fsm_t *p_this, fsm_t *p_fsm_telemetry){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)(p_this);
+    p_fsm_jukebox->p_fsm_telemetry = p_fsm_telemetry;
+}
+
+void fsm_jukebox_set_gesture(fsm_t *p_this, fsm_t *p_fsm_gesture){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)(p_this);
+    p_fsm_jukebox->p_fsm_gesture = p_fsm_gesture;
+}
+
+void fsm_jukebox_invalidate_inputs(fsm_t *p_this){
+    fsm_jukebox_t *p_fsm_jukebox = (fsm_jukebox_t *)(p_this);
+    p_fsm_jukebox->inputs.valid = false;
+}
+
+int fsm_jukebox_fire(fsm_t *p_this){
+    return fsm_jukebox_dispatch(p_this);
+}
@@ -11,11 +11,77 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <math.h>
 
 /* Other includes */
 #include "fsm_led.h"
+#include "fsm_pool.h"
+#include "fsm_buzzer.h"
 #include "port_led.h"
 
+/* Global variables */
+/**
+ * @brief Lowest frequency of each brightness of the pitch mode above 1, in hundredths of Hz. They are computed once, when the first LED is set in the pitch mode, so a note only costs integer comparisons.
+ *
+ */
+static uint32_t pitch_thresholds[PORT_LED_VISUALIZER_MAX_LEVEL - 1];
+
+/**
+ * @brief Whether `pitch_thresholds` have been computed.
+ *
+ */
+static bool pitch_thresholds_ready = false;
+
+/* Private functions */
+/**
+ * @brief Compute the thresholds of the brightness of the pitch mode: it grows linearly with the octave, from 1 at `FSM_LED_PITCH_MIN_HZ` to the maximum `FSM_LED_PITCH_OCTAVES` octaves above, rounded to the nearest level.
+ *
+ */
+static void _compute_pitch_thresholds(void){
+    for (uint32_t i = 0; i < PORT_LED_VISUALIZER_MAX_LEVEL - 1; i++)
+    {
+        // The brightness rounds up to i + 2 from half a level above i + 1
+        double octaves = (i + 0.5) * FSM_LED_PITCH_OCTAVES / (PORT_LED_VISUALIZER_MAX_LEVEL - 1);
+        pitch_thresholds[i] = (uint32_t)ceil(FSM_LED_PITCH_MIN_HZ * 100 * pow(2, octaves));
+    }
+    pitch_thresholds_ready = true;
+}
+
+/**
+ * @brief Get the brightness of a note in the pitch mode, from the thresholds of `_compute_pitch_thresholds()`.
+ *
+ * @param freq Frequency of the note in Hz
+ * @return uint32_t Brightness, from 0 for a silence to `PORT_LED_VISUALIZER_MAX_LEVEL`
+ */
+static uint32_t _get_pitch_level(double freq){
+    if (freq <= 0){
+        return 0;
+    }
+    uint32_t freq_chz = (uint32_t)(freq * 100);
+    uint32_t level = 1;
+    while ((level < PORT_LED_VISUALIZER_MAX_LEVEL) && (freq_chz >= pitch_thresholds[level - 1]))
+    {
+        level++;
+    }
+    return level;
+}
+
+/**
+ * @brief Show the last note started by the buzzer on the LED, according to the mode of the visualizer.
+ *
+ * @param p_led Pointer to the LED FSM
+ */
+static void _show_note(fsm_led_t *p_led){
+    double freq;
+    p_led->note_count = fsm_buzzer_get_note(p_led->p_fsm_buzzer, &freq);
+    if (p_led->mode == LED_MODE_PITCH){
+        port_led_visualizer_hold(p_led->led_id, _get_pitch_level(freq));
+    }
+    else {
+        port_led_visualizer_pulse(p_led->led_id, (freq > 0) ? PORT_LED_VISUALIZER_MAX_LEVEL : 0);
+    }
+}
+
 /* State machine input or transition functions */
 /**
  * @brief Check if a melody is playing
@@ -26,33 +92,53 @@
  */
 bool check_melody_start(fsm_t *p_this){
     fsm_led_t *p_led = (fsm_led_t *)p_this;
-    return port_check_melody_start(p_led->led_id);
+    return (p_led->p_fsm_buzzer != NULL) && (fsm_buzzer_get_action(p_led->p_fsm_buzzer) == PLAY);
 }
 
 /**
- * @brief Check if the melody has finished
+ * @brief Check if the melody has finished, has been paused or stopped
  * 
  * @param p_this fsm_t Pointer to the LED FSM.
  * @return true 
  * @return false 
  */
 bool check_melody_end(fsm_t *p_this){
+    return !check_melody_start(p_this);
+}
+
+/**
+ * @brief Check if the buzzer has started a note since the last one shown
+ * 
+ * @param p_this fsm_t Pointer to the LED FSM.
+ * @return true 
+ * @return false 
+ */
+bool check_new_note(fsm_t *p_this){
     fsm_led_t *p_led = (fsm_led_t *)p_this;
-    return port_check_melody_end(p_led->led_id);
+    return fsm_buzzer_get_note(p_led->p_fsm_buzzer, NULL) != p_led->note_count;
 }
 
 /* State machine output or action functions */
 /**
- * @brief Turns the LED on.
+ * @brief Turns the LED on, showing the current note.
  * 
  * @param p_this fsm_t Pointer to the LED FSM.
  */
 void do_turn_on(fsm_t *p_this){
     fsm_led_t *p_led = (fsm_led_t *)p_this;
-    port_led_turn_on(p_led->led_id);
+    _show_note(p_led);
     p_led->is_illuminated=true;
 }
 
+/**
+ * @brief Show a new note on the LED.
+ * 
+ * @param p_this fsm_t Pointer to the LED FSM.
+ */
+void do_show_note(fsm_t *p_this){
+    _show_note((fsm_led_t *)p_this);
+}
+
 /**
  * @brief Turn the LED off
  * 
@@ -60,23 +146,34 @@ void do_turn_on(fsm_t *p_this){
  */
 void do_turn_off(fsm_t *p_this){
     fsm_led_t *p_led = (fsm_led_t *)p_this;
-    port_led_turn_off(p_led->led_id);
+    port_led_visualizer_stop(p_led->led_id);
     p_led->is_illuminated=false;
 }
 
 /**
- * @brief Array representing the transitions table of the FSM button
+ * @brief Array representing the transitions table of the FSM LED
  * 
  * @image html fsm_led_states.png
  */
 static fsm_trans_t fsm_trans_led[] = {
     { LED_OFF, check_melody_start, LED_ON, do_turn_on },
     { LED_ON , check_melody_end, LED_OFF, do_turn_off },
+    { LED_ON , check_new_note, LED_ON, do_show_note },
     { -1 , NULL , -1, NULL }
 };
 
+/* Switch-based dispatch of the transitions table, generated by tools/fsm_codegen.py */
+#include "fsm_led_dispatch.inc"
+
 /* Other auxiliary functions */
 
+/* Static pool */
+/**
+ * @brief Static pool of LED FSMs for `fsm_led_new_static()`.
+ *
+ */
+FSM_POOL_DEFINE(fsm_led, fsm_led_t, FSM_LED_POOL_SIZE)
+
 /* FSM public functions */
 fsm_t * fsm_led_new( uint32_t led_id){
     fsm_t *p_fsm = malloc(sizeof(fsm_led_t)); /* Do malloc to reserve memory of all other FSM elements, although it is interpreted as fsm_t (the first element of the structure)*/
@@ -84,13 +181,35 @@ fsm_t * fsm_led_new( uint32_t led_id){
     return p_fsm;
 }
 
+fsm_t *fsm_led_new_static(uint32_t led_id){
+    fsm_t *p_fsm = fsm_led_pool_take();
+    if (p_fsm == NULL){
+        return NULL;
+    }
+    fsm_led_init(p_fsm, led_id);
+    return p_fsm;
+}
+
 void fsm_led_init(fsm_t *p_this, uint32_t led_id){
     fsm_led_t *p_led = (fsm_led_t *)p_this;
     fsm_init(&p_led->f, fsm_trans_led);
     p_led->led_id = led_id;
+    p_led->is_illuminated = false;
+    p_led->p_fsm_buzzer = NULL;
+    p_led->mode = LED_MODE_PULSE;
+    p_led->note_count = 0;
     port_led_init(led_id);
 }
 
+void fsm_led_set_visualizer(fsm_t *p_this, fsm_t *p_fsm_buzzer, uint32_t mode){
+    fsm_led_t *p_led = (fsm_led_t *)p_this;
+    p_led->p_fsm_buzzer = p_fsm_buzzer;
+    p_led->mode = mode;
+    if ((mode == LED_MODE_PITCH) && !pitch_thresholds_ready){
+        _compute_pitch_thresholds();
+    }
+}
+
 bool fsm_led_check_activity(fsm_t *p_this){
     fsm_led_t *p_led = (fsm_led_t *)p_this; 
     return(p_led->f.current_state != LED_OFF);
@@ -102,4 +221,8 @@ void fsm_led_turn_on(uint32_t led_id){
 
 void fsm_led_turn_off(uint32_t led_id){
     port_led_turn_off(led_id);
-}
\ No newline at end of file
+}
+
+int fsm_led_fire(fsm_t *p_this){
+    return fsm_led_dispatch(p_this);
+}
@@ -0,0 +1,314 @@
+/**
+ * @file fsm_telemetry.c
+ * @brief Telemetry FSM main file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdlib.h>
+#include <string.h>
+
+/* Other libraries */
+#include "fsm_telemetry.h"
+#include "fsm_pool.h"
+#include "fsm_jukebox.h"
+#include "fsm_button.h"
+#include "fsm_usart.h"
+#include "fsm_buzzer.h"
+#include "fsm_led.h"
+#include "port_system.h"
+#include "port_button.h"
+#include "port_usart.h"
+#include "port_buzzer.h"
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Snapshot of the FSMs of the system, taken at once before building a frame.
+ *
+ */
+typedef struct
+{
+    uint8_t jukebox_state;  /*!<State of the Jukebox FSM*/
+    uint8_t button_state;   /*!<State of the button FSM*/
+    uint8_t usart_state;    /*!<State of the USART FSM*/
+    uint8_t buzzer_state;   /*!<State of the buzzer FSM*/
+    uint8_t leds_state;     /*!<State of the LED FSMs, one bit per LED*/
+    uint8_t user_action;    /*!<User action of the buzzer*/
+    uint16_t note_index;    /*!<Index of the note playing*/
+    uint16_t speed_x100;    /*!<Speed of the player x100*/
+    uint8_t queue_depth;    /*!<Bytes of the USART input buffer waiting for the end of line*/
+    uint32_t isr_count_button;  /*!<Button interrupts since the system started*/
+    uint32_t isr_count_usart;   /*!<USART interrupts since the system started*/
+    uint32_t isr_count_buzzer;  /*!<Note duration timer interrupts since the system started*/
+} telemetry_snapshot_t;
+
+/* Private functions */
+/**
+ * @brief Take a snapshot of the FSMs of the system.
+ *
+ * @param p_fsm Pointer to the telemetry FSM
+ * @param p_snapshot Pointer to the snapshot to fill
+ */
+static void _take_snapshot(fsm_telemetry_t *p_fsm, telemetry_snapshot_t *p_snapshot){
+    fsm_jukebox_t *p_jukebox = (fsm_jukebox_t *)(p_fsm->p_fsm_jukebox);
+    fsm_button_t *p_button = (fsm_button_t *)(p_jukebox->p_fsm_button);
+    fsm_usart_t *p_usart = (fsm_usart_t *)(p_jukebox->p_fsm_usart);
+    fsm_buzzer_t *p_buzzer = (fsm_buzzer_t *)(p_jukebox->p_fsm_buzzer);
+
+    p_snapshot->jukebox_state = p_jukebox->f.current_state;
+    p_snapshot->button_state = p_button->f.current_state;
+    p_snapshot->usart_state = p_usart->f.current_state;
+    p_snapshot->buzzer_state = p_buzzer->f.current_state;
+    p_snapshot->leds_state = (fsm_led_check_activity(p_jukebox->p_fsm_led0) ? 0x01 : 0x00) | (fsm_led_check_activity(p_jukebox->p_fsm_led1) ? 0x02 : 0x00);
+    p_snapshot->user_action = p_buzzer->user_action;
+    p_snapshot->note_index = p_buzzer->note_index;
+    p_snapshot->speed_x100 = (uint16_t)(p_buzzer->player_speed * 100);
+    p_snapshot->queue_depth = port_usart_get_input_pending(p_usart->usart_id);
+    p_snapshot->isr_count_button = port_button_get_isr_count(p_button->button_id);
+    p_snapshot->isr_count_usart = port_usart_get_isr_count(p_usart->usart_id);
+    p_snapshot->isr_count_buzzer = port_buzzer_get_isr_count(p_buzzer->buzzer_id);
+}
+
+/**
+ * @brief Store a 16-bit value in a frame in little endian, saturating it if needed.
+ *
+ * @param p_data Pointer to the first byte of the field
+ * @param value Value to store
+ */
+static void _put_u16(uint8_t *p_data, uint32_t value){
+    if (value > UINT16_MAX){
+        value = UINT16_MAX;
+    }
+    p_data[0] = value & 0xFF;
+    p_data[1] = (value >> 8) & 0xFF;
+}
+
+/**
+ * @brief Store a 32-bit value in a frame in little endian.
+ *
+ * @param p_data Pointer to the first byte of the field
+ * @param value Value to store
+ */
+static void _put_u32(uint8_t *p_data, uint32_t value){
+    p_data[0] = value & 0xFF;
+    p_data[1] = (value >> 8) & 0xFF;
+    p_data[2] = (value >> 16) & 0xFF;
+    p_data[3] = (value >> 24) & 0xFF;
+}
+
+/**
+ * @brief Build a frame from a snapshot. See `TELEMETRY_FRAME_LENGTH` for the layout.
+ *
+ * @param p_fsm Pointer to the telemetry FSM
+ * @param p_snapshot Pointer to the snapshot
+ * @param loop_rate Loop iterations per second
+ */
+static void _build_frame(fsm_telemetry_t *p_fsm, const telemetry_snapshot_t *p_snapshot, uint32_t loop_rate){
+    uint8_t *p_frame = p_fsm->frame;
+    uint8_t checksum = 0;
+
+    p_frame[0] = TELEMETRY_SYNC_0;
+    p_frame[1] = TELEMETRY_SYNC_1;
+    p_frame[2] = p_fsm->seq;
+    p_frame[3] = p_snapshot->jukebox_state;
+    p_frame[4] = p_snapshot->button_state;
+    p_frame[5] = p_snapshot->usart_state;
+    p_frame[6] = p_snapshot->buzzer_state;
+    p_frame[7] = p_snapshot->leds_state;
+    p_frame[8] = p_snapshot->user_action;
+    _put_u16(&p_frame[9], p_snapshot->note_index);
+    _put_u16(&p_frame[11], p_snapshot->speed_x100);
+    p_frame[13] = p_snapshot->queue_depth;
+    _put_u32(&p_frame[14], loop_rate);
+    _put_u16(&p_frame[18], p_snapshot->isr_count_button - p_fsm->isr_count_button);
+    _put_u16(&p_frame[20], p_snapshot->isr_count_usart - p_fsm->isr_count_usart);
+    _put_u16(&p_frame[22], p_snapshot->isr_count_buzzer - p_fsm->isr_count_buzzer);
+
+    for (uint32_t i = 2; i < TELEMETRY_FRAME_LENGTH - 1; i++)
+    {
+        checksum += p_frame[i];
+    }
+    p_frame[TELEMETRY_FRAME_LENGTH - 1] = (uint8_t)(-checksum);
+}
+
+/* State machine input or transition functions */
+/**
+ * @brief Check if the host has subscribed to the stream
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_telemetry_t
+ * @return true
+ * @return false
+ */
+static bool check_subscribed(fsm_t *p_this){
+    fsm_telemetry_t *p_fsm = (fsm_telemetry_t *)(p_this);
+    return (p_fsm->period_ms > 0);
+}
+
+/**
+ * @brief Check if the host has unsubscribed from the stream
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_telemetry_t
+ * @return true
+ * @return false
+ */
+static bool check_unsubscribed(fsm_t *p_this){
+    return !check_subscribed(p_this);
+}
+
+/**
+ * @brief Check if a frame is due and the USART can send it without overwriting another message. If the USART is busy the frame is delayed, never the playback.
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_telemetry_t
+ * @return true
+ * @return false
+ */
+static bool check_frame_due(fsm_t *p_this){
+    fsm_telemetry_t *p_fsm = (fsm_telemetry_t *)(p_this);
+    fsm_jukebox_t *p_jukebox = (fsm_jukebox_t *)(p_fsm->p_fsm_jukebox);
+    int32_t time_to_frame = (int32_t)(p_fsm->next_frame_ms - port_system_get_millis());
+    return ((time_to_frame <= 0) && fsm_usart_check_tx_idle(p_jukebox->p_fsm_usart));
+}
+
+/**
+ * @brief Check if no frame has to be sent in this iteration
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_telemetry_t
+ * @return true
+ * @return false
+ */
+static bool check_frame_not_due(fsm_t *p_this){
+    return !check_frame_due(p_this);
+}
+
+/* State machine output or action functions */
+/**
+ * @brief Start the stream: the first frame is due after a period
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_telemetry_t
+ */
+static void do_start_stream(fsm_t *p_this){
+    fsm_telemetry_t *p_fsm = (fsm_telemetry_t *)(p_this);
+    telemetry_snapshot_t snapshot;
+    _take_snapshot(p_fsm, &snapshot);
+
+    p_fsm->last_frame_ms = port_system_get_millis();
+    p_fsm->next_frame_ms = p_fsm->last_frame_ms + p_fsm->period_ms;
+    p_fsm->loop_count = 0;
+    p_fsm->isr_count_button = snapshot.isr_count_button;
+    p_fsm->isr_count_usart = snapshot.isr_count_usart;
+    p_fsm->isr_count_buzzer = snapshot.isr_count_buzzer;
+}
+
+/**
+ * @brief Count an iteration of the main loop
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_telemetry_t
+ */
+static void do_count_loop(fsm_t *p_this){
+    fsm_telemetry_t *p_fsm = (fsm_telemetry_t *)(p_this);
+    p_fsm->loop_count++;
+}
+
+/**
+ * @brief Take a snapshot of the system and send it in a frame through the USART
+ *
+ * @param p_this Pointer to an fsm_t struct that contains an fsm_telemetry_t
+ */
+static void do_send_frame(fsm_t *p_this){
+    fsm_telemetry_t *p_fsm = (fsm_telemetry_t *)(p_this);
+    fsm_jukebox_t *p_jukebox = (fsm_jukebox_t *)(p_fsm->p_fsm_jukebox);
+    telemetry_snapshot_t snapshot;
+    uint32_t now = port_system_get_millis();
+    uint32_t elapsed_ms = now - p_fsm->last_frame_ms;
+
+    _take_snapshot(p_fsm, &snapshot);
+    p_fsm->loop_count++;
+    _build_frame(p_fsm, &snapshot, (elapsed_ms > 0) ? (p_fsm->loop_count * 1000) / elapsed_ms : 0);
+    fsm_usart_set_out_frame(p_jukebox->p_fsm_usart, p_fsm->frame, TELEMETRY_FRAME_LENGTH);
+
+    p_fsm->seq++;
+    p_fsm->loop_count = 0;
+    p_fsm->last_frame_ms = now;
+    p_fsm->next_frame_ms = now + p_fsm->period_ms;
+    p_fsm->isr_count_button = snapshot.isr_count_button;
+    p_fsm->isr_count_usart = snapshot.isr_count_usart;
+    p_fsm->isr_count_buzzer = snapshot.isr_count_buzzer;
+}
+
+/**
+ * @brief Array representing the transitions table of the telemetry FSM
+ *
+ */
+static fsm_trans_t fsm_trans_telemetry[] = {
+    { TELEMETRY_IDLE, check_subscribed, TELEMETRY_STREAMING, do_start_stream },
+    { TELEMETRY_STREAMING, check_unsubscribed, TELEMETRY_IDLE, NULL },
+    { TELEMETRY_STREAMING, check_frame_due, TELEMETRY_STREAMING, do_send_frame },
+    { TELEMETRY_STREAMING, check_frame_not_due, TELEMETRY_STREAMING, do_count_loop },
+    { -1 , NULL , -1, NULL }
+};
+
+/* Switch-based dispatch of the transitions table, generated by tools/fsm_codegen.py */
+#include "fsm_telemetry_dispatch.inc"
+
+/* Static pool */
+/**
+ * @brief Static pool of telemetry FSMs for `fsm_telemetry_new_static()`.
+ *
+ */
+FSM_POOL_DEFINE(fsm_telemetry, fsm_telemetry_t, FSM_TELEMETRY_POOL_SIZE)
+
+/* Public functions */
+fsm_t *fsm_telemetry_new(fsm_t *p_fsm_jukebox){
+    fsm_t *p_fsm = malloc(sizeof(fsm_telemetry_t)); /* Do malloc to reserve memory of all other FSM elements, although it is interpreted as fsm_t (the first element of the structure) */
+    fsm_telemetry_init(p_fsm, p_fsm_jukebox);
+    return p_fsm;
+}
+
+fsm_t *fsm_telemetry_new_static(fsm_t *p_fsm_jukebox){
+    fsm_t *p_fsm = fsm_telemetry_pool_take();
+    if (p_fsm == NULL){
+        return NULL;
+    }
+    fsm_telemetry_init(p_fsm, p_fsm_jukebox);
+    return p_fsm;
+}
+
+void fsm_telemetry_init(fsm_t *p_this, fsm_t *p_fsm_jukebox){
+    fsm_telemetry_t *p_fsm = (fsm_telemetry_t *)(p_this);
+    fsm_init(p_this, fsm_trans_telemetry);
+    p_fsm->p_fsm_jukebox = p_fsm_jukebox;
+    p_fsm->period_ms = 0;
+    p_fsm->next_frame_ms = 0;
+    p_fsm->last_frame_ms = 0;
+    p_fsm->loop_count = 0;
+    p_fsm->isr_count_button = 0;
+    p_fsm->isr_count_usart = 0;
+    p_fsm->isr_count_buzzer = 0;
+    p_fsm->seq = 0;
+    memset(p_fsm->frame, 0, sizeof(p_fsm->frame));
+}
+
+void fsm_telemetry_set_period(fsm_t *p_this, uint32_t period_ms){
+    fsm_telemetry_t *p_fsm = (fsm_telemetry_t *)(p_this);
+    if ((period_ms > 0) && (period_ms < TELEMETRY_MIN_PERIOD_MS)){
+        period_ms = TELEMETRY_MIN_PERIOD_MS;
+    }
+    p_fsm->period_ms = period_ms;
+}
+
+uint32_t fsm_telemetry_get_period(fsm_t *p_this){
+    fsm_telemetry_t *p_fsm = (fsm_telemetry_t *)(p_this);
+    return p_fsm->period_ms;
+}
+
+bool fsm_telemetry_check_activity(fsm_t *p_this){
+    fsm_telemetry_t *p_fsm = (fsm_telemetry_t *)(p_this);
+    return (p_fsm->f.current_state != TELEMETRY_IDLE);
+}
+
+int fsm_telemetry_fire(fsm_t *p_this){
+    return fsm_telemetry_dispatch(p_this);
+}
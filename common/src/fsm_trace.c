@@ -0,0 +1,89 @@
+/**
+ * @file fsm_trace.c
+ * @brief Ring buffer of the transitions fired by the FSMs.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>  // sprintf
+#include <string.h>
+
+/* Other libraries */
+#include "fsm_trace.h"
+#include "port_system.h"
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Structure with the ring of transitions.
+ *
+ */
+typedef struct
+{
+    fsm_trace_entry_t entries[FSM_TRACE_SIZE];      /*!<Transitions. The transition with sequence number `seq` is at `seq % FSM_TRACE_SIZE`*/
+    volatile uint32_t head;                         /*!<Sequence number of the next transition*/
+    uint8_t last_row[FSM_TRACE_NUM_IDS];            /*!<Last row recorded for each FSM plus one. 0 if the FSM has not recorded any transition*/
+} fsm_trace_t;
+
+/* Global variables */
+/**
+ * @brief Ring of transitions of all the FSMs.
+ *
+ */
+static fsm_trace_t trace;
+
+/* Public functions */
+void fsm_trace_record(uint32_t fsm_id, int from, int to, int row){
+    if (fsm_id >= FSM_TRACE_NUM_IDS){
+        return;
+    }
+    if ((from == to) && (trace.last_row[fsm_id] == row + 1)){
+        return;
+    }
+    trace.last_row[fsm_id] = row + 1;
+
+    uint32_t head = trace.head;
+    fsm_trace_entry_t *p_entry = &trace.entries[head & (FSM_TRACE_SIZE - 1)];
+    p_entry->millis = port_system_get_millis();
+    p_entry->fsm_id = fsm_id;
+    p_entry->from = from;
+    p_entry->to = to;
+    p_entry->row = row;
+    trace.head = head + 1;
+}
+
+void fsm_trace_reset(void){
+    memset(trace.last_row, 0, sizeof(trace.last_row));
+    trace.head = 0;
+}
+
+uint32_t fsm_trace_get_head(void){
+    return trace.head;
+}
+
+bool fsm_trace_get_entry(uint32_t seq, fsm_trace_entry_t *p_entry){
+    if ((trace.head - seq - 1) >= FSM_TRACE_SIZE){
+        return false;
+    }
+    *p_entry = trace.entries[seq & (FSM_TRACE_SIZE - 1)];
+    // The entry may have been overwritten while it was copied
+    return (trace.head - seq - 1) < FSM_TRACE_SIZE;
+}
+
+void fsm_trace_dump(uint32_t seq, char *p_text){
+    uint32_t head = trace.head;
+    if ((head > FSM_TRACE_SIZE) && (seq < head - FSM_TRACE_SIZE)){
+        seq = head - FSM_TRACE_SIZE;
+    }
+    p_text += sprintf(p_text, "TRC%08lX %08lX ", (unsigned long)seq, (unsigned long)head);
+    for (uint32_t i = 0; i < FSM_TRACE_DUMP_ENTRIES; i++)
+    {
+        fsm_trace_entry_t entry;
+        if (!fsm_trace_get_entry(seq + i, &entry)){
+            break;
+        }
+        p_text += sprintf(p_text, "%08lX%02X%02X%02X%02X", (unsigned long)entry.millis, entry.fsm_id, entry.from, entry.to, entry.row);
+    }
+}
@@ -13,8 +13,11 @@
 #include <stdbool.h>
 
 /* Other libraries */
+#include "port_system.h"
 #include "port_usart.h"
 #include "fsm_usart.h"
+#include "fsm_pool.h"
+#include "latency_trace.h"
 /* State machine input or transition functions */
 
 /**
@@ -60,6 +63,8 @@ static bool check_tx_end (fsm_t *p_this){
 */ 
 static void do_get_data_rx (fsm_t *p_this){
     fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    latency_trace_mark(LATENCY_STAGE_RX_ISR, port_usart_get_rx_timestamp(p_fsm -> usart_id));
+    latency_trace_mark(LATENCY_STAGE_USART_RX, port_system_get_cycles());
     port_usart_get_from_input_buffer(p_fsm -> usart_id, p_fsm -> in_data);
     port_usart_reset_input_buffer(p_fsm -> usart_id);
     p_fsm -> data_received = true;
@@ -74,6 +79,9 @@ static void do_set_data_tx (fsm_t *p_this){
     fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
     port_usart_reset_output_buffer(p_fsm -> usart_id);
     port_usart_copy_to_output_buffer(p_fsm -> usart_id, p_fsm -> out_data, USART_OUTPUT_BUFFER_LENGTH);
+    if (p_fsm -> out_length > 0){
+        port_usart_set_output_length(p_fsm -> usart_id, p_fsm -> out_length);
+    }
     while (!port_usart_get_txr_status(p_fsm ->usart_id));
     port_usart_write_data(p_fsm -> usart_id);
     port_usart_enable_tx_interrupt(p_fsm -> usart_id);
@@ -88,6 +96,7 @@ static void do_tx_end (fsm_t *p_this){
     fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
     port_usart_reset_output_buffer(p_fsm -> usart_id);
     memset(p_fsm -> out_data, EMPTY_BUFFER_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
+    p_fsm -> out_length = 0;
 }
 
 /**
@@ -102,6 +111,16 @@ static fsm_trans_t fsm_trans_usart[] ={
     { -1 , NULL , -1, NULL }
 };
 
+/* Switch-based dispatch of the transitions table, generated by tools/fsm_codegen.py */
+#include "fsm_usart_dispatch.inc"
+
+/* Static pool */
+/**
+ * @brief Static pool of USART FSMs for `fsm_usart_new_static()`.
+ *
+ */
+FSM_POOL_DEFINE(fsm_usart, fsm_usart_t, FSM_USART_POOL_SIZE)
+
 /* Public functions */
 void fsm_usart_get_in_data(fsm_t *p_this, char *p_data)
 {
@@ -115,6 +134,24 @@ void fsm_usart_set_out_data(fsm_t *p_this, char *p_data)
     // Ensure to reset the output data before setting a new one
     memset(p_fsm->out_data, EMPTY_BUFFER_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
     memcpy(p_fsm->out_data, p_data, USART_OUTPUT_BUFFER_LENGTH);
+    p_fsm->out_length = 0;
+}
+
+void fsm_usart_set_out_frame(fsm_t *p_this, const uint8_t *p_data, uint32_t length)
+{
+    fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    if (length > USART_OUTPUT_BUFFER_LENGTH){
+        length = USART_OUTPUT_BUFFER_LENGTH;
+    }
+    memset(p_fsm->out_data, EMPTY_BUFFER_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
+    memcpy(p_fsm->out_data, p_data, length);
+    p_fsm->out_length = length;
+}
+
+bool fsm_usart_check_tx_idle(fsm_t *p_this)
+{
+    fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
+    return ((p_fsm->f.current_state == WAIT_DATA) && (p_fsm->out_data[0] == EMPTY_BUFFER_CONSTANT));
 }
 
 fsm_t *fsm_usart_new(uint32_t usart_id)
@@ -124,12 +161,23 @@ fsm_t *fsm_usart_new(uint32_t usart_id)
     return p_fsm;
 }
 
+fsm_t *fsm_usart_new_static(uint32_t usart_id)
+{
+    fsm_t *p_fsm = fsm_usart_pool_take();
+    if (p_fsm == NULL){
+        return NULL;
+    }
+    fsm_usart_init(p_fsm, usart_id);
+    return p_fsm;
+}
+
 void fsm_usart_init(fsm_t *p_this, uint32_t usart_id)
 {
     fsm_usart_t *p_fsm = (fsm_usart_t *)(p_this);
     fsm_init(p_this, fsm_trans_usart);
     p_fsm -> usart_id = usart_id;
     p_fsm -> data_received = false;
+    p_fsm -> out_length = 0;
     memset(p_fsm -> in_data, EMPTY_BUFFER_CONSTANT, USART_INPUT_BUFFER_LENGTH);
     memset(p_fsm -> out_data, EMPTY_BUFFER_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
     port_usart_init (p_fsm -> usart_id);
@@ -172,8 +220,7 @@ void fsm_usart_enable_tx_interrupt (fsm_t *p_this){
     port_usart_enable_tx_interrupt(p_fsm -> usart_id);   
 }
 
-
-
-
-
-
+int fsm_usart_fire(fsm_t *p_this)
+{
+    return fsm_usart_dispatch(p_this);
+}
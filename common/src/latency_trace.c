@@ -0,0 +1,149 @@
+/**
+ * @file latency_trace.c
+ * @brief Command latency tracing main file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>  // sprintf
+#include <string.h>
+#include <stdbool.h>
+
+/* Other libraries */
+#include "latency_trace.h"
+#include "port_system.h"
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Structure with the open trace and the histograms of the complete traces.
+ *
+ */
+typedef struct
+{
+    uint32_t stage_cycles[LATENCY_NUM_STAGES];                              /*!<Timestamps of the open trace in CPU cycles*/
+    int32_t last_stage;                                                     /*!<Last stage recorded in the open trace. -1 if there is no open trace*/
+    uint16_t count;                                                         /*!<Number of complete traces*/
+    uint16_t wake_count;                                                    /*!<Number of wake-ups from STOP mode measured*/
+    uint16_t buckets[LATENCY_NUM_SEGMENTS][LATENCY_HISTOGRAM_BUCKETS];      /*!<Histograms of the segments*/
+    uint32_t max_us[LATENCY_NUM_SEGMENTS];                                  /*!<Maximum latency of the segments in us*/
+} latency_trace_t;
+
+/* Global variables */
+/**
+ * @brief Open trace and histograms. There is a single USART and a single buzzer, so a single trace can be open at a time.
+ *
+ */
+static latency_trace_t latency = {.last_stage = -1};
+
+/* Private functions */
+/**
+ * @brief Get the bucket of a latency: the position of its most significant bit.
+ *
+ * @param us Latency in us
+ * @return uint32_t Bucket index
+ */
+static uint32_t _get_bucket(uint32_t us){
+    uint32_t bucket = 0;
+    while ((us > 1) && (bucket < LATENCY_HISTOGRAM_BUCKETS - 1))
+    {
+        us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+/**
+ * @brief Add a latency to the histogram of a segment.
+ *
+ * @param segment Segment, one of `LATENCY_SEGMENT`
+ * @param cycles Latency in CPU cycles
+ */
+static void _add_sample(uint32_t segment, uint32_t cycles){
+    uint32_t us = cycles / port_system_get_cycles_per_us();
+    uint32_t bucket = _get_bucket(us);
+    if (latency.buckets[segment][bucket] < UINT16_MAX){
+        latency.buckets[segment][bucket]++;
+    }
+    if (us > latency.max_us[segment]){
+        latency.max_us[segment] = us;
+    }
+}
+
+/* Public functions */
+void latency_trace_mark(uint32_t stage, uint32_t cycles){
+    if (stage >= LATENCY_NUM_STAGES){
+        return;
+    }
+    if (stage == LATENCY_STAGE_RX_ISR){
+        latency.last_stage = LATENCY_STAGE_RX_ISR;
+    }
+    else if ((latency.last_stage >= 0) && (((int32_t)stage == latency.last_stage) || ((int32_t)stage == latency.last_stage + 1))){
+        latency.last_stage = stage;
+    }
+    else{
+        return;
+    }
+    latency.stage_cycles[stage] = cycles;
+
+    if (stage == LATENCY_STAGE_REG_WRITE){
+        // Unsigned differences are correct even if the cycle counter has wrapped around
+        _add_sample(LATENCY_SEGMENT_TOTAL, latency.stage_cycles[LATENCY_STAGE_REG_WRITE] - latency.stage_cycles[LATENCY_STAGE_RX_ISR]);
+        for (uint32_t i = 1; i < LATENCY_NUM_STAGES; i++)
+        {
+            _add_sample(i, latency.stage_cycles[i] - latency.stage_cycles[i - 1]);
+        }
+        if (latency.count < UINT16_MAX){
+            latency.count++;
+        }
+        latency.last_stage = -1;
+    }
+}
+
+void latency_trace_abandon(void){
+    latency.last_stage = -1;
+}
+
+void latency_trace_add_wake(uint32_t cycles){
+    _add_sample(LATENCY_SEGMENT_WAKE_TO_FIRE, cycles);
+    if (latency.wake_count < UINT16_MAX){
+        latency.wake_count++;
+    }
+}
+
+void latency_trace_reset(void){
+    memset(&latency, 0, sizeof(latency));
+    latency.last_stage = -1;
+}
+
+uint32_t latency_trace_get_count(void){
+    return latency.count;
+}
+
+uint32_t latency_trace_get_bucket(uint32_t segment, uint32_t bucket){
+    if ((segment >= LATENCY_NUM_SEGMENTS) || (bucket >= LATENCY_HISTOGRAM_BUCKETS)){
+        return 0;
+    }
+    return latency.buckets[segment][bucket];
+}
+
+uint32_t latency_trace_get_max_us(uint32_t segment){
+    if (segment >= LATENCY_NUM_SEGMENTS){
+        return 0;
+    }
+    return latency.max_us[segment];
+}
+
+void latency_trace_dump(uint32_t segment, char *p_text){
+    if (segment >= LATENCY_NUM_SEGMENTS){
+        segment = LATENCY_SEGMENT_TOTAL;
+    }
+    uint16_t count = (segment == LATENCY_SEGMENT_WAKE_TO_FIRE) ? latency.wake_count : latency.count;
+    uint32_t length = sprintf(p_text, "LAT%lu %04X %08lX ", (unsigned long)segment, count, (unsigned long)latency.max_us[segment]);
+    for (uint32_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    {
+        length += sprintf(&p_text[length], "%04X", latency.buckets[segment][i]);
+    }
+}
@@ -0,0 +1,118 @@
+/**
+ * @file wavetable.c
+ * @brief Wavetable oscillator with a fixed-point phase accumulator, for the DAC output of the buzzer.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <math.h>
+#include <string.h>
+
+/* Other libraries */
+#include "wavetable.h"
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+/* Defines ------------------------------------------------------------------*/
+#define WAVETABLE_INDEX_SHIFT (32 - WAVETABLE_BITS)                                 /*!<Shift of the phase to get the index of the wavetable*/
+#define WAVETABLE_FRACTION_SHIFT (WAVETABLE_INDEX_SHIFT - WAVETABLE_FRACTION_BITS)  /*!<Shift of the phase to get the fraction between two samples*/
+#define WAVETABLE_FRACTION_MASK ((1U << WAVETABLE_FRACTION_BITS) - 1)               /*!<Mask of the fraction between two samples*/
+#define WAVETABLE_OUTPUT_SHIFT 3                                                    /*!<Shift from the Q14 samples of the wavetable to the 12-bit output*/
+#define WAVETABLE_PI 3.14159265358979323846                                         /*!<Number pi. `M_PI` is not standard C*/
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Get the sample of the wavetable at a phase, interpolated or not. The interpolation weighs the two samples with `32767 - f` and `f`, which is what `SMUAD` computes from two pairs of 16-bit values.
+ *
+ * @param p_osc Pointer to the oscillator
+ * @param phase Phase
+ * @return int32_t Sample, Q14
+ */
+static inline int32_t _get_sample(const wavetable_osc_t *p_osc, uint32_t phase)
+{
+    uint32_t index = phase >> WAVETABLE_INDEX_SHIFT;
+    int32_t a = p_osc->p_table[index];
+    if (!p_osc->interpolate)
+    {
+        return a;
+    }
+    int32_t b = p_osc->p_table[(index + 1) & (WAVETABLE_LENGTH - 1)];
+    int32_t f = (phase >> WAVETABLE_FRACTION_SHIFT) & WAVETABLE_FRACTION_MASK;
+#if defined(__ARM_FEATURE_SIMD32)
+    uint32_t samples = ((uint32_t)a & 0xFFFF) | ((uint32_t)b << 16);
+    uint32_t weights = (uint32_t)(WAVETABLE_FRACTION_MASK - f) | ((uint32_t)f << 16);
+    return __smuad((int16x2_t)samples, (int16x2_t)weights) >> WAVETABLE_FRACTION_BITS;
+#else
+    return (a * (int32_t)(WAVETABLE_FRACTION_MASK - f) + b * f) >> WAVETABLE_FRACTION_BITS;
+#endif
+}
+
+/* Public functions -----------------------------------------------------------*/
+void wavetable_init_table(int16_t *p_table, const double *p_harmonics, uint32_t num_harmonics)
+{
+    double wave[WAVETABLE_LENGTH];
+    double peak = 0.0;
+    for (uint32_t i = 0; i < WAVETABLE_LENGTH; i++)
+    {
+        wave[i] = 0.0;
+        for (uint32_t k = 0; k < num_harmonics; k++)
+        {
+            wave[i] += p_harmonics[k] * sin(2.0 * WAVETABLE_PI * (double)((k + 1) * i) / WAVETABLE_LENGTH);
+        }
+        peak = fmax(peak, fabs(wave[i]));
+    }
+    for (uint32_t i = 0; i < WAVETABLE_LENGTH; i++)
+    {
+        p_table[i] = (peak > 0.0) ? (int16_t)lround(wave[i] * WAVETABLE_AMPLITUDE / peak) : 0;
+    }
+}
+
+void wavetable_osc_init(wavetable_osc_t *p_osc, const int16_t *p_table, bool interpolate)
+{
+    p_osc->p_table = p_table;
+    p_osc->phase = 0;
+    p_osc->phase_inc = 0;
+    p_osc->interpolate = interpolate;
+}
+
+void wavetable_osc_set_frequency(wavetable_osc_t *p_osc, double frequency_hz, uint32_t sample_rate_hz)
+{
+    if ((frequency_hz <= 0.0) || (sample_rate_hz == 0))
+    {
+        p_osc->phase = 0;
+        p_osc->phase_inc = 0;
+        return;
+    }
+    // The phase wraps around at 2^32, a period of the wavetable
+    p_osc->phase_inc = (uint32_t)llround(frequency_hz * 4294967296.0 / sample_rate_hz);
+}
+
+void wavetable_fill(wavetable_osc_t *p_osc, uint16_t *p_samples, uint32_t count)
+{
+    uint32_t phase = p_osc->phase;
+    uint32_t phase_inc = p_osc->phase_inc;
+    uint32_t i = 0;
+#if defined(__ARM_FEATURE_SIMD32)
+    // Two samples per store: their offset to midscale is added to both halves at once. The pair is copied with memcpy, a single store on the Cortex-M4, as the buffer is of uint16_t
+    for (; i + 1 < count; i += 2)
+    {
+        int32_t s0 = _get_sample(p_osc, phase) >> WAVETABLE_OUTPUT_SHIFT;
+        int32_t s1 = _get_sample(p_osc, phase + phase_inc) >> WAVETABLE_OUTPUT_SHIFT;
+        phase += 2 * phase_inc;
+        uint32_t pair = ((uint32_t)s0 & 0xFFFF) | ((uint32_t)s1 << 16);
+        pair = (uint32_t)__sadd16((int16x2_t)pair, (int16x2_t)((WAVETABLE_OUTPUT_MIDSCALE << 16) | WAVETABLE_OUTPUT_MIDSCALE));
+        memcpy(&p_samples[i], &pair, sizeof(pair));
+    }
+#endif
+    for (; i < count; i++)
+    {
+        p_samples[i] = (uint16_t)((_get_sample(p_osc, phase) >> WAVETABLE_OUTPUT_SHIFT) + WAVETABLE_OUTPUT_MIDSCALE);
+        phase += phase_inc;
+    }
+    p_osc->phase = phase;
+}
@@ -23,10 +23,20 @@
 #include "fsm_jukebox.h"
 #include "fsm_led.h"
 #include "port_led.h"
+#include "fsm_telemetry.h"
+#include "fsm_gesture.h"
+#include "fsm_trace.h"
+#include "fsm_active.h"
 
 /* Defines ------------------------------------------------------------------*/
 #define ON_OFF_PRESS_TIME_MS 1000
 #define NEXT_SONG_BUTTON_TIME_MS 500
+#define CLICK_GAP_MS 300
+#define HOLD_TIME_MS 2000
+#define MELODY_COMPILE_NOTES 128    /*!<Notes of the scratch buffer of the compiled melodies*/
+
+/* Global variables ----------------------------------------------------------*/
+static buzzer_timing_note_t melody_compiled[MELODY_COMPILE_NOTES]; /*!<Scratch buffer of the compiled melodies of the buzzer*/
 
 /**
  * @brief  The application entry point.
@@ -36,30 +46,42 @@ int main(void)
 {
     /* Init board */
     port_system_init();
-    fsm_t *p_fsm_button = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
-    fsm_t *p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
-    fsm_t *p_fsm_usart = fsm_usart_new(USART_0_ID);
-    fsm_t *p_fsm_led0 = fsm_led_new(LED_0_ID);
-    fsm_t *p_fsm_led1 = fsm_led_new(LED_1_ID);
-    fsm_t *p_fsm_jukebox = fsm_jukebox_new(p_fsm_button, ON_OFF_PRESS_TIME_MS, p_fsm_usart, p_fsm_buzzer, NEXT_SONG_BUTTON_TIME_MS, p_fsm_led0, p_fsm_led1);
+    /* The FSMs are taken from static pools: there is no heap allocation, and they must not be destroyed */
+    fsm_t *p_fsm_button = fsm_button_new_static(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    fsm_t *p_fsm_buzzer = fsm_buzzer_new_static(BUZZER_0_ID);
+    fsm_buzzer_set_compile_buffer(p_fsm_buzzer, melody_compiled, MELODY_COMPILE_NOTES); // Before the Jukebox sets the first melody
+    fsm_t *p_fsm_usart = fsm_usart_new_static(USART_0_ID);
+    fsm_t *p_fsm_led0 = fsm_led_new_static(LED_0_ID);
+    fsm_t *p_fsm_led1 = fsm_led_new_static(LED_1_ID);
+    fsm_t *p_fsm_jukebox = fsm_jukebox_new_static(p_fsm_button, ON_OFF_PRESS_TIME_MS, p_fsm_usart, p_fsm_buzzer, NEXT_SONG_BUTTON_TIME_MS, p_fsm_led0, p_fsm_led1);
+    fsm_t *p_fsm_telemetry = fsm_telemetry_new_static(p_fsm_jukebox);
+    fsm_jukebox_set_telemetry(p_fsm_jukebox, p_fsm_telemetry);
+    fsm_t *p_fsm_gesture = fsm_gesture_new_static(&p_fsm_button, 1, CLICK_GAP_MS, HOLD_TIME_MS);
+    fsm_jukebox_set_gesture(p_fsm_jukebox, p_fsm_gesture);
+    fsm_led_set_visualizer(p_fsm_led0, p_fsm_buzzer, LED_MODE_PULSE);
+    fsm_led_set_visualizer(p_fsm_led1, p_fsm_buzzer, LED_MODE_PITCH);
+
+    /* Each FSM is an active object with its own event queue, in order of priority. Only the FSMs with events, or busy waiting for a time, are fired */
+    int button = fsm_active_register(p_fsm_button, fsm_button_fire, NULL, NULL, PORT_IRQ_EVENT_BUTTON_0, FSM_TRACE_ID_BUTTON); // Debounced in the port layer, it only changes on its IRQ events
+    int gesture = fsm_active_register(p_fsm_gesture, fsm_gesture_fire, fsm_gesture_on_event, fsm_gesture_check_activity, 0, FSM_TRACE_ID_GESTURE);
+    int usart = fsm_active_register(p_fsm_usart, fsm_usart_fire, NULL, NULL, PORT_IRQ_EVENT_USART_0, FSM_TRACE_ID_USART);
+    int buzzer = fsm_active_register(p_fsm_buzzer, fsm_buzzer_fire, fsm_buzzer_on_event, NULL, PORT_IRQ_EVENT_BUZZER_0, FSM_TRACE_ID_BUZZER);
+    int jukebox = fsm_active_register(p_fsm_jukebox, fsm_jukebox_fire, NULL, fsm_active_always_busy, 0, FSM_TRACE_ID_JUKEBOX); // It manages the low power mode
+    int telemetry = fsm_active_register(p_fsm_telemetry, fsm_telemetry_fire, NULL, fsm_telemetry_check_activity, 0, FSM_TRACE_ID_TELEMETRY);
+    int led0 = fsm_active_register(p_fsm_led0, fsm_led_fire, NULL, NULL, 0, FSM_TRACE_ID_LED_0);
+    int led1 = fsm_active_register(p_fsm_led1, fsm_led_fire, NULL, NULL, 0, FSM_TRACE_ID_LED_1);
+    fsm_active_listen(gesture, button);     // The gestures only run on the transitions of the buttons
+    fsm_active_listen(usart, jukebox);      // Replies to the commands
+    fsm_active_listen(usart, telemetry);    // Telemetry frames
+    fsm_active_listen(telemetry, jukebox);  // Subscription to the telemetry
+    fsm_active_listen(led0, buzzer);        // Visualizer of the notes
+    fsm_active_listen(led1, buzzer);
 
     /* Infinite loop */
     while (1)
     {   
-        fsm_fire(p_fsm_button);
-        fsm_fire(p_fsm_usart);
-        fsm_fire(p_fsm_buzzer);
-        fsm_fire(p_fsm_jukebox);
-        fsm_fire(p_fsm_led0);
-        fsm_fire(p_fsm_led1);
-
+        /* Each transition fired is recorded in the trace ring, unless FSM_TRACE_ENABLED is 0 */
+        fsm_active_dispatch();
     } // End of while(1)
-    fsm_destroy(p_fsm_button);
-    fsm_destroy(p_fsm_usart);
-    fsm_destroy(p_fsm_buzzer);
-    fsm_destroy(p_fsm_jukebox);
-    fsm_destroy(p_fsm_led0);
-    fsm_destroy(p_fsm_led1);
-    
     return 0;
 }
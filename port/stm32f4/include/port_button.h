@@ -23,12 +23,28 @@
 #define BUTTON_0_GPIO GPIOC                 /*!<Button GPIO port*/
 #define BUTTON_0_PIN 0x0D                   /*!<Button GPIO pin*/
 #define BUTTON_0_DEBOUNCE_TIME_MS 0x96      /*!<Button debounce time*/
+#define PORT_BUTTON_NONE 0xFF               /*!<Identifier returned for an EXTI line without a button*/
+#define PORT_BUTTON_EXTI_LINES 16           /*!<Number of EXTI lines of the GPIO pins*/
+#define PORT_BUTTON_EDGE_FIFO_SIZE 8        /*!<Number of edges the FIFO of a button can store. It must be a power of 2*/
+#define PORT_BUTTON_NUM_BUTTONS 1           /*!<Number of buttons of the buttons_arr[] array*/
+#define PORT_BUTTON_DEBOUNCE_TIMER TIM4     /*!<One-pulse timer of the debounce of all the buttons. It keeps running in Sleep mode, but not in STOP mode*/
+#define PORT_BUTTON_DEBOUNCE_TIMER_IRQN TIM4_IRQn   /*!<IRQ of the debounce timer*/
 
 /* La placa tiene 8 puertos A-H. Cada uno tiene 16 lineas/pines. Cada puerto tiene un registros de 32bits, esto es, 2 bits para cada pin del puerto.
 En nuestro caso, el botón de usuario, B1, usa Puerto C, pin 13.
 */
 
 /* Typedefs --------------------------------------------------------------------*/
+/**
+ * @brief Structure to define an edge of a button, timestamped in its ISR.
+ *
+ */
+typedef struct
+{
+    uint64_t timestamp_us;  /*!<Time of the edge in us, as returned by `port_system_get_micros64()`*/
+    bool pressed;           /*!<True if the button was pressed, false if it was released*/
+} port_button_edge_t;
+
 /**
  * @brief Structure to define the HW dependencies of a button.
  * 
@@ -37,7 +53,15 @@ typedef struct
 {
     GPIO_TypeDef *p_port;   /*!<GPIO where the button is connected*/
     uint8_t pin;            /*!<Pin where the button is connected*/
-    bool flag_pressed;      /*!<Flag to indicate the button has been pressed*/
+    bool flag_pressed;      /*!<Flag to indicate the button has been pressed. It only changes on debounced edges*/
+    uint32_t debounce_ms;   /*!<Debounce time in ms. The EXTI line of the button is masked during this time after every edge accepted*/
+    volatile bool debouncing;   /*!<True while the debounce timer runs for the button and its EXTI line is masked*/
+    uint32_t isr_count;     /*!<Number of interrupts raised by the button*/
+    uint32_t irq_event;     /*!<IRQ event posted by the ISR of the button, one of `PORT_IRQ_EVENT_XXX`*/
+    port_button_edge_t edges[PORT_BUTTON_EDGE_FIFO_SIZE];   /*!<FIFO of the edges not read yet. The ISR writes them and the FSM reads them, ordered with the head by memory barriers, so it needs no lock*/
+    volatile uint32_t edge_head;                            /*!<Number of edges written in the FIFO. It wraps around when it overflows*/
+    uint32_t edge_tail;                                     /*!<Number of edges read from the FIFO. It wraps around when it overflows*/
+    uint32_t edges_lost;                                    /*!<Number of edges lost because the FIFO was full*/
 } port_button_hw_t;         
 
 /* Global variables */
@@ -45,7 +69,7 @@ typedef struct
  * @brief Array of hardware buttons.
  * 
  */
-extern port_button_hw_t buttons_arr[];
+extern port_button_hw_t buttons_arr[PORT_BUTTON_NUM_BUTTONS];
 
 /* Function prototypes and explanation -------------------------------------------------*/
 /**
@@ -62,6 +86,14 @@ uint32_t port_button_get_tick ();
  */
 void port_button_init (uint32_t button_id)	;
 
+/**
+ * @brief Set the debounce time of the button. It is applied from the next edge.
+ *
+ * @param button_id	Button ID. This index is used to select the element of the buttons_arr[] array.
+ * @param debounce_ms Debounce time in ms, from 1 to 65536
+ */
+void port_button_set_debounce_time(uint32_t button_id, uint32_t debounce_ms);
+
 /**
  * @brief Return whether the button has been pressed or not.
  * 
@@ -71,4 +103,63 @@ void port_button_init (uint32_t button_id)	;
  */
 bool port_button_is_pressed	(uint32_t button_id	)	;
 
+/**
+ * @brief Return the number of interrupts raised by the button since the system started.
+ * 
+ * @param button_id	Button ID. This index is used to select the element of the buttons_arr[] array.
+ * @return uint32_t Number of interrupts. It wraps around when it overflows.
+ */
+uint32_t port_button_get_isr_count(uint32_t button_id);
+
+/**
+ * @brief Get the button connected to an EXTI line, from the table filled by `port_button_init()`. The ISRs use it to serve any button of a shared EXTI interrupt.
+ *
+ * @param pin Pin of the GPIO, i.e. EXTI line
+ * @return uint32_t Button ID. `PORT_BUTTON_NONE` if no button has been initialized on that line.
+ */
+uint32_t port_button_get_exti_button(uint8_t pin);
+
+/**
+ * @brief Store an edge of the button in its FIFO, with the current time. If the FIFO is full, the edge is lost.
+ * @warning This function must be used only by the ISR of the button in file `interr.c`.
+ *
+ * @param button_id	Button ID. This index is used to select the element of the buttons_arr[] array.
+ * @param pressed True if the button has been pressed, false if it has been released
+ */
+void port_button_push_edge(uint32_t button_id, bool pressed);
+
+/**
+ * @brief Read the oldest edge of the button from its FIFO.
+ *
+ * @param button_id	Button ID. This index is used to select the element of the buttons_arr[] array.
+ * @param p_edge Pointer to store the edge
+ * @return true if there was an edge
+ * @return false if the FIFO was empty
+ */
+bool port_button_pop_edge(uint32_t button_id, port_button_edge_t *p_edge);
+
+/**
+ * @brief Start the debounce of the button after an edge has been accepted: mask its EXTI line, so that its bounces raise no interrupt, and arm the debounce timer for the debounce time of the button.
+ * @warning This function must be used only by the ISRs of the buttons in file `interr.c`. The timer is shared by all the buttons, so the debounce of the other buttons in progress is extended too.
+ *
+ * @param button_id	Button ID. This index is used to select the element of the buttons_arr[] array.
+ */
+void port_button_start_debounce(uint32_t button_id);
+
+/**
+ * @brief End the debounce of the button: clear the edges latched by its EXTI line while it was masked and unmask it. The caller must read the level of the button afterwards, since it may have changed during the debounce.
+ * @warning This function must be used only by the ISR of the debounce timer in file `interr.c`.
+ *
+ * @param button_id	Button ID. This index is used to select the element of the buttons_arr[] array.
+ */
+void port_button_end_debounce(uint32_t button_id);
+
+/**
+ * @brief Check whether the debounce of any button is in progress. The debounce timer does not run in STOP mode and the EXTI lines of the buttons are masked meanwhile, so the system must not enter it.
+ *
+ * @return true if the debounce timer is running
+ * @return false otherwise
+ */
+bool port_button_check_debouncing(void);
+
 #endif
\ No newline at end of file
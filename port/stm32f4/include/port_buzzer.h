@@ -16,6 +16,9 @@
 /* HW dependent includes */
 #include "port_system.h"
 
+/* Other includes */
+#include "buzzer_timing.h"
+
 /* Defines and enums ----------------------------------------------------------*/
 /* Defines */
 #define BUZZER_0_ID 0x00    /*!<Buzzer Identifier*/
@@ -23,6 +26,40 @@
 #define BUZZER_0_PIN 0x06   /*!<Button GPIO pin*/
 #define BUZZER_PWM_DC 0.5   /*!<Duty cycle*/
 
+#define PORT_BUZZER_ENVELOPE_TIMER TIM1                /*!<Timer that paces the DMA transfers of the envelope to the CCR1 register of the PWM timer, one per ms*/
+#define PORT_BUZZER_ENVELOPE_DMA_STREAM DMA2_Stream5   /*!<DMA stream that copies the envelope to the CCR1 register of the PWM timer. It is requested by the update of TIM1. Only DMA2 can write the APB1 timers from an APB2 request*/
+#define PORT_BUZZER_ENVELOPE_DMA_CHANNEL 6             /*!<Channel of the DMA stream of the update request of TIM1*/
+#define PORT_BUZZER_ENVELOPE_ATTACK_MS 4               /*!<Time in ms the duty cycle of the envelope takes to rise from 0 to `BUZZER_PWM_DC`*/
+#define PORT_BUZZER_ENVELOPE_DECAY_MS 60               /*!<Time in ms the duty cycle of the envelope takes to fall from `BUZZER_PWM_DC` to the sustain level*/
+#define PORT_BUZZER_ENVELOPE_MS (PORT_BUZZER_ENVELOPE_ATTACK_MS + PORT_BUZZER_ENVELOPE_DECAY_MS) /*!<Duration in ms of the envelope. The duty cycle is kept at the sustain level until the end of the note*/
+#define PORT_BUZZER_ENVELOPE_SUSTAIN 0.3               /*!<Sustain level of the envelope, as a fraction of `BUZZER_PWM_DC`*/
+
+#define PORT_BUZZER_EFFECT_TIMER TIM7                   /*!<Timer that paces the DMA transfers of the effects to the ARR register of the PWM timer*/
+#define PORT_BUZZER_EFFECT_DMA_STREAM DMA1_Stream4      /*!<DMA stream that copies the effect to the ARR register of the PWM timer. It is requested by the update of TIM7*/
+#define PORT_BUZZER_EFFECT_DMA_CHANNEL 1                /*!<Channel of the DMA stream of the update request of TIM7*/
+#define PORT_BUZZER_GLIDE_MS 40                         /*!<Duration in ms of a glide between two notes*/
+#define PORT_BUZZER_GLIDE_MAX_SEMITONES 7               /*!<Maximum interval of a glide. Longer jumps are played without glide, because the duty cycle of the new note would reach 100 % at the start of a falling glide*/
+
+/* Enums */
+/**
+ * @brief Enumerator of the pitch effects of the notes.
+ *
+ */
+enum PORT_BUZZER_EFFECTS {
+    PORT_BUZZER_EFFECT_NONE = 0,    /*!<Constant frequency*/
+    PORT_BUZZER_EFFECT_VIBRATO,     /*!<Periodic variation of the frequency around the note*/
+    PORT_BUZZER_EFFECT_GLIDE        /*!<Glide from the previous note to the new one*/
+};
+
+/**
+ * @brief Enumerator of the outputs of the notes.
+ *
+ */
+enum PORT_BUZZER_OUTPUTS {
+    PORT_BUZZER_OUTPUT_PWM = 0,     /*!<Square wave of the PWM timer on the pin of the buzzer*/
+    PORT_BUZZER_OUTPUT_DAC          /*!<Wavetable synthesis on the DAC, see `port_dac.h`*/
+};
+
 /* Typedefs --------------------------------------------------------------------*/
 typedef struct
 {
@@ -30,6 +67,12 @@ typedef struct
     uint8_t pin;            /*!<Pin where the buzzer is connected*/
     uint8_t alt_func;       /*!<Alternate function value for PWM according to the Alternate function table of the datasheet*/
     bool note_end;          /*!<Flag to indicate that the note has ended*/
+    uint32_t isr_count;     /*!<Number of interrupts raised by the timer that controls the duration of the note*/
+    uint32_t write_cycles;  /*!<CPU cycles when the PWM timer was last reprogrammed or stopped*/
+    bool envelope;          /*!<True to shape the duty cycle of every note with the envelope*/
+    uint8_t effect;         /*!<Pitch effect of the notes, one of `PORT_BUZZER_EFFECTS`*/
+    int32_t effect_note;    /*!<Note of the effect tables of the last note played. -1 after a silence or a note out of the tables*/
+    uint8_t output;         /*!<Output of the notes, one of `PORT_BUZZER_OUTPUTS`*/
 } port_buzzer_hw_t;         
 
 /* Global variables */
@@ -49,6 +92,22 @@ extern port_buzzer_hw_t buzzers_arr[];
  */
 bool port_buzzer_get_note_timeout(uint32_t 	buzzer_id);
 
+/**
+ * @brief Return the number of interrupts raised by the timer that controls the duration of the note since the system started.
+ * 
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return uint32_t Number of interrupts. It wraps around when it overflows.
+ */
+uint32_t port_buzzer_get_isr_count(uint32_t buzzer_id);
+
+/**
+ * @brief Return the CPU cycles when the PWM timer was last reprogrammed by `port_buzzer_set_note_frequency()` or stopped by `port_buzzer_stop()`.
+ * 
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @return uint32_t Timestamp in CPU cycles, as returned by `port_system_get_cycles()`
+ */
+uint32_t port_buzzer_get_write_timestamp(uint32_t buzzer_id);
+
 /**
  * @brief Configure the HW specifications of a given buzzer melody player.
  * 
@@ -64,6 +123,14 @@ void port_buzzer_init(uint32_t buzzer_id);
  */
 void port_buzzer_set_note_duration(uint32_t buzzer_id, uint32_t duration_ms);
 
+/**
+ * @brief Rescale the note that is playing after a change of speed, in constant time and without restarting it. The ARR and the counter of the timer that controls the duration of the note are multiplied by the same ratio, so the elapsed fraction of the note is kept and its remaining time is scaled. TIM2 is a 32-bit timer, so the prescaler is kept and the ARR of a slower note fits. Nothing is done if the note has ended or the timer is stopped.
+ * 
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param ratio Ratio of the new duration to the old one, the old speed divided by the new one
+ */
+void port_buzzer_rescale_note_duration(uint32_t buzzer_id, double ratio);
+
 /**
  * @brief Set the PWM frequency of the timer that controls the frequency of the note.
  * 
@@ -72,6 +139,56 @@ void port_buzzer_set_note_duration(uint32_t buzzer_id, uint32_t duration_ms);
  */
 void port_buzzer_set_note_frequency(uint32_t buzzer_id, double frequency_hz);		
 
+/**
+ * @brief Compute the register values of a note, to play it later with `port_buzzer_play_compiled_note()`. They are the values that `port_buzzer_set_note_frequency()` and `port_buzzer_set_note_duration()` compute without effect.
+ * 
+ * @param frequency_hz Frequency of the note in Hz. 0 is a silence
+ * @param duration_ms Duration of the note in ms, already scaled by the speed of the player
+ * @param p_note Pointer to store the register values
+ */
+void port_buzzer_compile_note(double frequency_hz, uint32_t duration_ms, buzzer_timing_note_t *p_note);
+
+/**
+ * @brief Compute only the register values of the duration of a note compiled by `port_buzzer_compile_note()`.
+ * 
+ * @param duration_ms Duration of the note in ms, already scaled by the speed of the player
+ * @param p_note Pointer to the register values to update
+ */
+void port_buzzer_compile_duration(uint32_t duration_ms, buzzer_timing_note_t *p_note);
+
+/**
+ * @brief Play a note compiled by `port_buzzer_compile_note()`: its register values are written to the PWM timer and the timer of the note duration, with no floating point. Silences, notes with a pitch effect and the DAC output are played from the frequency, as `port_buzzer_set_note_frequency()` does, and only their duration is taken from the register values.
+ * 
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param frequency_hz Frequency of the note in Hz
+ * @param p_note Pointer to the register values of the note
+ */
+void port_buzzer_play_compiled_note(uint32_t buzzer_id, double frequency_hz, const buzzer_timing_note_t *p_note);
+
+/**
+ * @brief Enable or disable the envelope of the notes. With the envelope, the duty cycle of every note rises from 0 to `BUZZER_PWM_DC` in `PORT_BUZZER_ENVELOPE_ATTACK_MS` and falls to the sustain level in `PORT_BUZZER_ENVELOPE_DECAY_MS`. The DMA stream of the envelope writes a new duty cycle every ms, paced by `PORT_BUZZER_ENVELOPE_TIMER`, so the CPU only scales the `PORT_BUZZER_ENVELOPE_MS` values of the envelope to the note when it starts.
+ * 
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param enable True to shape the notes with the envelope, false to keep the duty cycle at `BUZZER_PWM_DC`
+ */
+void port_buzzer_set_envelope(uint32_t buzzer_id, bool enable);
+
+/**
+ * @brief Set the pitch effect of the notes. The ARR values of the effects are generated from the notes of `melodies.h` by `tools/buzzer_effects_codegen.py`, and the DMA stream of the effect copies them to the PWM timer, paced by `PORT_BUZZER_EFFECT_TIMER`. There is no floating point nor work of the CPU per step. The notes out of the tables, and all the notes if the system clock is not the clock of the tables, are played without effect.
+ * 
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param effect Pitch effect, one of `PORT_BUZZER_EFFECTS`. Setting it forgets the previous note, so the next note does not glide.
+ */
+void port_buzzer_set_effect(uint32_t buzzer_id, uint8_t effect);
+
+/**
+ * @brief Set the output of the notes. The DAC output is configured the first time it is selected, so the pin of the DAC is not touched while the buzzer only uses the PWM output. The envelope and the pitch effects only apply to the PWM output.
+ * 
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param output Output, one of `PORT_BUZZER_OUTPUTS`. The note that is playing is silenced, but its duration goes on, so the next note is played on the new output.
+ */
+void port_buzzer_set_output(uint32_t buzzer_id, uint8_t output);
+
 /**
  * @brief Disable the PWM output of the timer that controls the frequency of the note and the timer that controls the duration of the note.
  * 
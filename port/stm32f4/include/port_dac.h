@@ -0,0 +1,67 @@
+/**
+ * @file port_dac.h
+ * @brief Header for port_dac.c file.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+#ifndef PORT_DAC_H_
+#define PORT_DAC_H_
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C includes */
+#include <stdint.h>
+#include <stdbool.h>
+
+/* HW dependent includes */
+#include "port_system.h"
+
+/* Defines and enums ----------------------------------------------------------*/
+/* Defines */
+#define PORT_DAC_GPIO GPIOA                     /*!<GPIO port of the output of channel 1 of the DAC*/
+#define PORT_DAC_PIN 0x04                       /*!<GPIO pin of the output of channel 1 of the DAC*/
+#define PORT_DAC_TIMER TIM6                     /*!<Timer that triggers the conversions of the DAC*/
+#define PORT_DAC_DMA_STREAM DMA1_Stream5        /*!<DMA stream that copies the samples to the DAC, requested by the DAC after each conversion*/
+#define PORT_DAC_DMA_CHANNEL 7                  /*!<Channel of the DMA stream of the request of channel 1 of the DAC*/
+#define PORT_DAC_DMA_IRQN DMA1_Stream5_IRQn     /*!<Interrupt of the DMA stream, at each half of the buffer*/
+#define PORT_DAC_SAMPLE_RATE_HZ 32000           /*!<Output sample rate*/
+#define PORT_DAC_BUFFER_LENGTH 256              /*!<Samples of the double buffer. The DMA stream plays a half while the other one is filled*/
+#define PORT_DAC_HALF_LENGTH (PORT_DAC_BUFFER_LENGTH / 2) /*!<Samples of each half of the double buffer, 4 ms*/
+
+/* Function prototypes and explanation -------------------------------------------------*/
+/**
+ * @brief Configure the DAC output: the analog pin, channel 1 of the DAC triggered by the TRGO of `PORT_DAC_TIMER`, the circular DMA stream of the double buffer and the wavetable oscillator. The output is silent and stopped.
+ *
+ */
+void port_dac_init(void);
+
+/**
+ * @brief Set the frequency of the wavetable oscillator and start the output if it is stopped. The two halves of the buffer are filled before the start.
+ *
+ * @param frequency_hz Frequency in Hz. 0 is a silence.
+ */
+void port_dac_set_frequency(double frequency_hz);
+
+/**
+ * @brief Stop the trigger timer and the DMA stream of the DAC. The oscillator is silenced.
+ *
+ */
+void port_dac_stop(void);
+
+/**
+ * @brief Fill a half of the double buffer with the wavetable oscillator. It is called by the ISR of the DMA stream when the other half starts playing.
+ *
+ * @param half 0 for the first half, 1 for the second one
+ */
+void port_dac_fill_half(uint32_t half);
+
+/**
+ * @brief Check whether the DAC output is running.
+ *
+ * @return true
+ * @return false
+ */
+bool port_dac_check_running(void);
+
+#endif /* PORT_DAC_H_ */
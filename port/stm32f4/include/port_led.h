@@ -25,6 +25,13 @@
 #define LED_1_ID 0x01                    /*!<LED Identifier*/
 #define LED_1_GPIO GPIOC                 /*!<LED GPIO port*/
 #define LED_1_PIN 0x03                   /*!<LED GPIO pin*/
+#define PORT_LED_NUM_LEDS 2              /*!<Number of LEDs of the leds_arr[] array*/
+#define PORT_LED_VISUALIZER_TIMER TIM8   /*!<Timer that paces the DMA transfers of the patterns of the visualizer to the GPIO of the LEDs*/
+#define PORT_LED_VISUALIZER_SLOT_HZ 8000 /*!<Rate of the slots of the patterns. Each slot is a write of the BSRR register*/
+#define PORT_LED_VISUALIZER_MAX_LEVEL 16 /*!<Maximum brightness of the visualizer. It is also the number of slots of a PWM period, so the PWM frequency is 500 Hz*/
+#define PORT_LED_VISUALIZER_LEVEL_PERIODS 4  /*!<PWM periods of each level of the fade of a pulse. A pulse of the maximum brightness fades out in 136 ms*/
+#define PORT_LED_VISUALIZER_SEGMENT_LENGTH (PORT_LED_VISUALIZER_MAX_LEVEL * PORT_LED_VISUALIZER_LEVEL_PERIODS)                 /*!<Slots of each level of the patterns*/
+#define PORT_LED_VISUALIZER_PATTERN_LENGTH ((PORT_LED_VISUALIZER_MAX_LEVEL + 1) * PORT_LED_VISUALIZER_SEGMENT_LENGTH)         /*!<Slots of the pattern of an LED: all the levels, from the maximum down to 0*/
 #define ODR5_MASK_LED0 ( GPIO_ODR_OD0 << LED_0_PIN ) /*!< Mask for ODR register using LED_0_PIN */
 #define IDR5_MASK_LED0 ( GPIO_IDR_ID0 << LED_0_PIN ) /*!< Mask for IDR register using LED_0_PIN */
 #define ODR5_MASK_LED1 ( GPIO_ODR_OD0 << LED_1_PIN ) /*!< Mask for ODR register using LED_1_PIN */
@@ -39,8 +46,11 @@ typedef struct
 {
     GPIO_TypeDef *p_port;   /*!<GPIO where the LED is connected*/
     uint8_t pin;            /*!<Pin where the LED is connected*/
-    bool melody_start;  /*!< Flag that represents that a melody is playing*/
-    bool melody_end;    /*!< Flag that represents that a melody has finished*/
+    DMA_Stream_TypeDef *p_dma_stream;   /*!<DMA2 stream that copies the pattern of the visualizer to the BSRR register of the GPIO*/
+    uint32_t dma_channel;               /*!<Channel of the DMA stream of the request of the visualizer timer*/
+    uint32_t dma_request;               /*!<DMA request of the visualizer timer that paces the stream, as a mask of its DIER register*/
+    uint32_t dma_flags;                 /*!<Flags of the DMA stream, as a mask of the DMA2 LIFCR register*/
+    bool visualizer_on;                 /*!<True while the DMA stream of the visualizer drives the LED*/
 } port_led_hw_t;         
 
 /* Global variables */
@@ -48,7 +58,7 @@ typedef struct
  * @brief Array of hardware LEDs.
  * 
  */
-extern port_led_hw_t led_arr[];
+extern port_led_hw_t leds_arr[PORT_LED_NUM_LEDS];
 
 /**
  * @brief Initialize the given LED by configuring the provided hardware specifications.
@@ -68,35 +78,48 @@ bool port_led_get(uint32_t led_id);
 
 
 /**
- * @brief Check if a melody is playing
+ * @brief Turns on the LED. The visualizer of the LED is stopped.
  * 
  * @param led_id LED ID. This index is used to select the element of the LEDs_arr[] array.
- * @return true 
- * @return false 
  */
-bool port_check_melody_start(uint32_t led_id);
+void port_led_turn_on(uint32_t led_id);
 
 /**
- * @brief Check if the melody has ended
+ * @brief Turns off the LED. The visualizer of the LED is stopped.
  * 
  * @param led_id LED ID. This index is used to select the element of the LEDs_arr[] array.
- * @return true 
- * @return false 
  */
-bool port_check_melody_end(uint32_t led_id);
+void port_led_turn_off(uint32_t led_id);
 
 /**
- * @brief Turns on the LED.
+ * @brief Turn on and off several LEDs at once, with a single write of the GPIO. All the LEDs must be on the same port, as LED_0 and LED_1 are.
+ * 
+ * @param on_mask Mask of the LEDs to turn on. Bit `i` is the LED with ID `i`.
+ * @param off_mask Mask of the LEDs to turn off. If an LED is in both masks, it is turned on.
+ */
+void port_led_write_mask(uint32_t on_mask, uint32_t off_mask);
+
+/**
+ * @brief Light a pulse on the LED that fades out by itself. The DMA stream of the LED copies the fade to the GPIO once, paced by the visualizer timer, with no work of the CPU until the LED is off.
  * 
  * @param led_id LED ID. This index is used to select the element of the LEDs_arr[] array.
+ * @param level Brightness at the start of the pulse, from 0 to `PORT_LED_VISUALIZER_MAX_LEVEL`. 0 turns the LED off.
  */
-void port_led_turn_on(uint32_t led_id);
+void port_led_visualizer_pulse(uint32_t led_id, uint32_t level);
 
 /**
- * @brief Turns off the LED.
+ * @brief Keep the LED at a brightness with PWM. The DMA stream of the LED copies a PWM period to the GPIO in circular mode.
  * 
  * @param led_id LED ID. This index is used to select the element of the LEDs_arr[] array.
+ * @param level Brightness, from 0 to `PORT_LED_VISUALIZER_MAX_LEVEL`
  */
-void port_led_turn_off(uint32_t led_id);
+void port_led_visualizer_hold(uint32_t led_id, uint32_t level);
+
+/**
+ * @brief Stop the visualizer of the LED and turn it off. The visualizer timer is stopped when no LED uses it.
+ * 
+ * @param led_id LED ID. This index is used to select the element of the LEDs_arr[] array.
+ */
+void port_led_visualizer_stop(uint32_t led_id);
 
 #endif
\ No newline at end of file
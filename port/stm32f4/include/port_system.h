@@ -34,6 +34,11 @@
 
 /* Power */
 #define POWER_REGULATOR_VOLTAGE_SCALE3 0x01 /*!< Scale 3 mode: the maximum value of fHCLK is 120 MHz. */
+#define PORT_SYSTEM_SLEEP_FOREVER UINT32_MAX          /*!< Sleep time to wait for any interrupt, without programming a wakeup */
+#define PORT_SYSTEM_WAKEUP_TIMER TIM5                 /*!< 32-bit timer that wakes the system up and measures the time slept. The STM32F446RE has no LPTIM, and the timers keep running in Sleep mode */
+#define PORT_SYSTEM_WAKEUP_TIMER_IRQN TIM5_IRQn       /*!< IRQ of the wakeup timer */
+#define PORT_SYSTEM_WAKEUP_TICKS_PER_MS 10U           /*!< Ticks per ms of the wakeup timer. The prescaler of the timer clock fits in 16 bits */
+#define PORT_SYSTEM_SLEEP_MAX_MS (UINT32_MAX / PORT_SYSTEM_WAKEUP_TICKS_PER_MS)  /*!< Longest sleep with a wakeup programmed. Longer sleeps wait for any interrupt */
 
 /* GPIOs */
 #define HIGH true /*!< Logic 1 */
@@ -55,6 +60,11 @@
 #define TRIGGER_ENABLE_EVENT_REQ 0x04U                                 /*!< Interrupt mask to enable event requests */
 #define TRIGGER_ENABLE_INTERR_REQ 0x08U                                /*!< Interrupt mask to enable interrupt request */
 
+/* IRQ events */
+#define PORT_IRQ_EVENT_BUTTON_0 0x01U   /*!< IRQ event posted by the ISR of the user button */
+#define PORT_IRQ_EVENT_USART_0 0x02U    /*!< IRQ event posted by the ISR of the USART */
+#define PORT_IRQ_EVENT_BUZZER_0 0x04U   /*!< IRQ event posted by the ISR of the timer of the note duration */
+
 /* Function prototypes and explanation -------------------------------------------------*/
 
 /**
@@ -92,6 +102,38 @@ uint32_t port_system_get_millis(void);
 º */
 void port_system_set_millis(uint32_t ms);
 
+/**
+ * @brief Get the count of CPU cycles of the DWT cycle counter. It is used to take timestamps with a resolution finer than the System tick.
+ *
+ * @note The counter wraps around every 2^32 cycles (about 4.5 minutes at 16 MHz), so only differences between close timestamps are meaningful.
+ *
+ * @return uint32_t
+ */
+uint32_t port_system_get_cycles(void);
+
+/**
+ * @brief Get the number of CPU cycles per microsecond, to convert differences of `port_system_get_cycles()` into time.
+ *
+ * @return uint32_t
+ */
+uint32_t port_system_get_cycles_per_us(void);
+
+/**
+ * @brief Update the wraparounds of the DWT cycle counter for `port_system_get_micros64()`. The counter wraps around every 2^32 cycles, so it must be called more often than that.
+ * @warning This function must be used only by the SysTick_Handler() ISR in file `interr.c`, and by the functions that suspend the System tick.
+ *
+ */
+void port_system_update_cycles(void);
+
+/**
+ * @brief Get the time since the system started in microseconds, with a 64-bit count that does not wrap around.
+ *
+ * The time is the DWT cycle counter extended to 64 bits with its wraparounds, which the System tick counts. It is read without disabling the interrupts: if the SysTick ISR updates the wraparounds during the read, the read is repeated. The time slept by `port_system_sleep_for()` is added as measured by the wakeup timer, whether the cycle counter stops or not while the core sleeps. As `msTicks`, it does not advance in STOP mode.
+ *
+ * @return uint64_t Time in microseconds
+ */
+uint64_t port_system_get_micros64(void);
+
 /**
  * @brief Wait for some milliseconds
  *
@@ -125,6 +167,20 @@ void port_system_systick_resume();
  */
 void port_system_systick_suspend();
 
+/**
+ * @brief Post IRQ events from an ISR. The events are accumulated until `port_system_take_irq_events()` is called.
+ *
+ * @param events Mask of `PORT_IRQ_EVENT_XXX` events
+ */
+void port_system_post_irq_event(uint32_t events);
+
+/**
+ * @brief Get and clear the IRQ events posted since the last call. The interrupts are disabled while the events are read and cleared, so no event is lost.
+ *
+ * @return uint32_t Mask of `PORT_IRQ_EVENT_XXX` events
+ */
+uint32_t port_system_take_irq_events(void);
+
 /** @verbatim
       ==============================================================================
                               ##### How to use GPIOs #####
@@ -240,7 +296,7 @@ void port_system_gpio_exti_disable(uint8_t pin);
 bool port_system_gpio_read (GPIO_TypeDef *p_port, uint8_t pin);
 
 /**
- * @brief Write a digital value in a GPIO automatically.
+ * @brief Write a digital value in a GPIO automatically. It is a single store in the BSRR register, so it is safe against the ISRs that write other pins of the same port.
  *
  * @param p_port Port of the GPIO (CMSIS struct like)
  * @param pin	Pin/line of the GPIO (index from 0 to 15)
@@ -250,7 +306,17 @@ bool port_system_gpio_read (GPIO_TypeDef *p_port, uint8_t pin);
 void port_system_gpio_write	(GPIO_TypeDef *p_port, uint8_t pin, bool value);	
 
 /**
- * @brief Toggle the value of a GPIO
+ * @brief Set and clear several pins of a GPIO port at once, with a single store in the BSRR register. All the pins change in the same cycle and the other pins of the port are not touched.
+ *
+ * @param p_port Port of the GPIO (CMSIS struct like)
+ * @param set_mask Mask of the pins to set to HIGH. Bit `i` is pin `i`.
+ * @param reset_mask Mask of the pins to set to LOW. If a pin is in both masks, it is set to HIGH.
+ * @retval None
+*/
+void port_system_gpio_write_mask(GPIO_TypeDef *p_port, uint16_t set_mask, uint16_t reset_mask);
+
+/**
+ * @brief Toggle the value of a GPIO. The output latch (ODR) is read and the opposite value is written with a single store in the BSRR register, so the other pins of the port are not touched.
  *
  * @param p_port Port of the GPIO (CMSIS struct like)
  * @param pin	Pin/line of the GPIO (index from 0 to 15)
@@ -271,9 +337,50 @@ void port_system_power_sleep();
 void port_system_power_stop();
 
 /**
- * @brief Enable low power consumption in sleep mode.
+ * @brief Enter STOP mode until an EXTI line wakes the system up, and restore the Run mode.
+ *
+ * In STOP mode all the clocks are stopped, so the System tick, the timers and the USART do not run and cannot wake the system up: only the EXTI lines can, such as the user button (EXTI13). The time in STOP mode is not added to the System tick count, because no clock runs to measure it.
+ *
+ * > 1. **Disable the interrupts**, so that the ISR of the wake-up source runs in Run mode. If an ISR has posted IRQ events not taken yet by `port_system_take_irq_events()`, or the debounce of a button is in progress, return without entering STOP mode: the EXTI line of the button is masked during the debounce. \n
+ * > 2. **Suspend the System tick** and **enter STOP mode** with the low power regulator. \n
+ * > 3. On wake-up, **take a timestamp** for `port_system_get_stop_wake_cycles()` and **restore the system clock**. The hardware selects the HSI on wake-up, which is the clock of the system, so the restore does not wait for any oscillator or PLL and always takes the same time. \n
+ * > 4. **Restart the System tick** from a whole ms and restore the interrupts.
+ *
+ */
+void port_system_stop();
+
+/**
+ * @brief Get the number of times the system has woken up from STOP mode. It tells the mode transitions apart.
+ *
+ * @return uint32_t Number of wake-ups from STOP mode
+ */
+uint32_t port_system_get_stop_count(void);
+
+/**
+ * @brief Get the timestamp of the last wake-up from STOP mode, taken as soon as the core runs again.
+ *
+ * @return uint32_t Timestamp in CPU cycles, as returned by `port_system_get_cycles()`
+ */
+uint32_t port_system_get_stop_wake_cycles(void);
+
+/**
+ * @brief Enable low power consumption in sleep mode until any interrupt. It is `port_system_sleep_for()` without a deadline, so the system time is also corrected.
  * 
  */
 void port_system_sleep();
 
+/**
+ * @brief Enable low power consumption in sleep mode until a deadline or any interrupt, without System tick interrupts (tickless idle).
+ *
+ * > 1. **Disable the interrupts**, so that the ISR that wakes the system up runs after the system time has been corrected. If an ISR has posted IRQ events not taken yet by `port_system_take_irq_events()`, return without sleeping: its interrupt has already been served and would not wake the core up. \n
+ * > 2. **Suspend the System tick** interrupt and **start the wakeup timer** from 0, with its update interrupt at `max_ms` if there is a deadline. \n
+ * > 3. **Enter Sleep mode**. A pending interrupt wakes the core up even though it is masked. \n
+ * > 4. **Read the time slept** from the wakeup timer and **add it to the System tick count**. The fraction of ms is kept for the next sleep, so no time is lost. \n
+ * > 5. **Resume the System tick** and restore the interrupts, so the pending ISRs run.
+ *
+ * @param max_ms Maximum time to sleep in ms. `PORT_SYSTEM_SLEEP_FOREVER`, or more than `PORT_SYSTEM_SLEEP_MAX_MS`, to wait for any interrupt. 0 returns immediately, as an IRQ event pending.
+ * @return uint32_t Time slept in ms, already added to the System tick count
+ */
+uint32_t port_system_sleep_for(uint32_t max_ms);
+
 #endif /* PORT_SYSTEM_H_ */
\ No newline at end of file
@@ -27,7 +27,7 @@
 #define USART_0_PIN_RX 0xB                   /*!<USART GPIO pin for RX*/
 #define USART_0_AF_TX 0x7                    /*!<USART alternate function for TX*/
 #define USART_0_AF_RX 0x7                    /*!<USART alternate function for RX*/
-#define USART_INPUT_BUFFER_LENGTH 0xA        /*!<USART input message length*/
+#define USART_INPUT_BUFFER_LENGTH 0x40       /*!<USART input message length. Long enough for a batch of commands in a single line*/
 #define USART_OUTPUT_BUFFER_LENGTH 0x64      /*!<USART output message length*/
 #define EMPTY_BUFFER_CONSTANT 0x0            /*!<Empty char constant*/
 #define END_CHAR_CONSTANT 0xA                /*!<End char constant*/
@@ -51,6 +51,9 @@ typedef struct {
     char output_buffer [USART_OUTPUT_BUFFER_LENGTH];     /*!<Output buffer*/
     uint8_t o_idx;                                       /*!<Index of the output buffer*/
     bool write_complete;                                 /*!<Flag to indicate that the data has been sent*/
+    uint8_t o_length;                                    /*!<Number of bytes to send in binary mode. 0 in text mode, where the message ends with END_CHAR_CONSTANT*/
+    uint32_t isr_count;                                  /*!<Number of interrupts raised by the USART*/
+    uint32_t rx_end_cycles;                              /*!<CPU cycles when the last END_CHAR_CONSTANT was received*/
 }port_usart_hw_t;
 
 /* Global variables */
@@ -71,6 +74,40 @@ extern port_usart_hw_t usart_arr[];
  */
 void port_usart_copy_to_output_buffer(uint32_t usart_id,char *p_data, uint32_t length);	
 
+/**
+ * @brief Send the output buffer in binary mode, i.e., send exactly `length` bytes instead of stopping at END_CHAR_CONSTANT and skipping EMPTY_BUFFER_CONSTANT.
+ * 
+ * @note The binary mode lasts until the output buffer is reset with `port_usart_reset_output_buffer()`.
+ * 
+ * @param usart_id USART ID. This index is used to select the element of the usart_arr[] array
+ * @param length Number of bytes to send. It must not be greater than USART_OUTPUT_BUFFER_LENGTH
+ */
+void port_usart_set_output_length(uint32_t usart_id, uint32_t length);
+
+/**
+ * @brief Return the number of bytes stored in the input buffer that are waiting for the end of the message.
+ * 
+ * @param usart_id USART ID. This index is used to select the element of the usart_arr[] array
+ * @return uint32_t Number of bytes pending
+ */
+uint32_t port_usart_get_input_pending(uint32_t usart_id);
+
+/**
+ * @brief Return the number of interrupts raised by the USART since the system started.
+ * 
+ * @param usart_id USART ID. This index is used to select the element of the usart_arr[] array
+ * @return uint32_t Number of interrupts. It wraps around when it overflows.
+ */
+uint32_t port_usart_get_isr_count(uint32_t usart_id);
+
+/**
+ * @brief Return the CPU cycles when the last END_CHAR_CONSTANT was received, i.e. when the last message was completed in the ISR.
+ * 
+ * @param usart_id USART ID. This index is used to select the element of the usart_arr[] array
+ * @return uint32_t Timestamp in CPU cycles, as returned by `port_system_get_cycles()`
+ */
+uint32_t port_usart_get_rx_timestamp(uint32_t usart_id);
+
 /**
  * @brief Disable USART RX interrupt
  * 
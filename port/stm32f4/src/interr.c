@@ -11,6 +11,9 @@
 #include "port_button.h"
 #include "port_usart.h"
 #include "port_buzzer.h"
+#include "port_dac.h"
+
+#define EXTI15_10_LINES_MASK 0xFC00U  /*!< EXTI lines 10 to 15, served by EXTI15_10_IRQHandler() */
 
 //------------------------------------------------------
 // INTERRUPT SERVICE ROUTINES
@@ -19,33 +22,61 @@
  * @brief Interrupt service routine for the System tick timer (SysTick).
  *
  * @note This ISR is called when the SysTick timer generates an interrupt.
- * The program flow jumps to this ISR and increments the tick counter by one millisecond.
+ * The program flow jumps to this ISR and increments the tick counter by one millisecond. It also counts the wraparounds of the DWT cycle counter for `port_system_get_micros64()`.
  *
  */
 void SysTick_Handler(void){
     uint32_t tickstart = port_system_get_millis();
     port_system_set_millis(tickstart + 1);
+    port_system_update_cycles();
+}
+
+/**
+ * @brief Accept an edge of a button if its level differs from the debounced one: update its flag, store the edge with its timestamp, post its IRQ event and start the debounce, so that its bounces are ignored.
+ *
+ * @param button_id Button ID. This index is used to select the element of the buttons_arr[] array.
+ */
+static void _button_edge(uint32_t button_id){
+    bool nivel = port_system_gpio_read(buttons_arr[button_id].p_port, buttons_arr[button_id].pin);
+    bool pressed = !nivel;
+    if (pressed == buttons_arr[button_id].flag_pressed){
+        return; // A glitch that is already over
+    }
+    buttons_arr[button_id].flag_pressed = pressed;
+    port_button_push_edge(button_id, pressed);
+    port_system_post_irq_event(buttons_arr[button_id].irq_event);
+    port_button_start_debounce(button_id);
+}
+
+/**
+ * @brief Serve the interrupt of a button.
+ *
+ * @param button_id Button ID. This index is used to select the element of the buttons_arr[] array.
+ */
+static void _button_isr(uint32_t button_id){
+    buttons_arr[button_id].isr_count++;
+    _button_edge(button_id);
 }
 
 /**
  * @brief This function handles Px10-Px15 global interrupts.
- * First, this function identifies the pin which has raised the interruption. Then, perform the desired action. Before leaving it cleans the interrupt pending register.
+ * First, this function identifies the pins which have raised the interruption, and the button of each of them through the table of `port_button_get_exti_button()`. Then, perform the desired action. Before leaving it cleans the interrupt pending register.
  */
 void EXTI15_10_IRQHandler ( void ){
     port_system_systick_resume();
-    /* ISR user button */
-    if (EXTI -> PR & BIT_POS_TO_MASK (buttons_arr [BUTTON_0_ID].pin))
+    uint32_t pending = EXTI -> PR & EXTI15_10_LINES_MASK;
+    for (uint8_t pin = 10; pin <= 15; pin++)
     {
-        bool nivel = port_system_gpio_read(buttons_arr [BUTTON_0_ID].p_port, buttons_arr [BUTTON_0_ID].pin);
-        if(nivel){
-            buttons_arr[BUTTON_0_ID].flag_pressed = false;
-        }
-        else {
-            buttons_arr[BUTTON_0_ID].flag_pressed = true;
+        if (pending & BIT_POS_TO_MASK(pin))
+        {
+            uint32_t button_id = port_button_get_exti_button(pin);
+            if (button_id != PORT_BUTTON_NONE)
+            {
+                _button_isr(button_id);
+            }
         }
-
     }
-    EXTI -> PR |= BIT_POS_TO_MASK (buttons_arr[BUTTON_0_ID].pin); 
+    EXTI -> PR = pending; // Write 1 to clear only the lines served
 }
 
 /**
@@ -55,6 +86,7 @@ void EXTI15_10_IRQHandler ( void ){
  */
 void USART3_IRQHandler(void){
     port_system_systick_resume();
+    usart_arr[USART_0_ID].isr_count++;
     if (USART_0->CR1 & USART_CR1_RXNEIE){
         if (USART_0->SR & USART_SR_RXNE){
             port_usart_store_data(USART_0_ID);
@@ -66,6 +98,7 @@ void USART3_IRQHandler(void){
             port_usart_write_data(USART_0_ID);
         }
     }
+    port_system_post_irq_event(PORT_IRQ_EVENT_USART_0);
 }
 
 /**
@@ -77,6 +110,51 @@ void USART3_IRQHandler(void){
 void TIM2_IRQHandler(void){
     TIM2->SR &= ~ TIM_SR_UIF;
     buzzers_arr[BUZZER_0_ID].note_end = true;
+    buzzers_arr[BUZZER_0_ID].isr_count++;
+    port_system_post_irq_event(PORT_IRQ_EVENT_BUZZER_0);
 }	 
 
+/**
+ * @brief This function handles TIM4 global interrupt.
+ * This timer ends the debounce of the buttons. The EXTI line of every button in debounce is unmasked and its level is read again: if it has changed during the debounce, the change is accepted as a new edge, timestamped now, and a new debounce starts.
+ *
+ */
+void TIM4_IRQHandler(void){
+    port_system_systick_resume();
+    PORT_BUTTON_DEBOUNCE_TIMER->SR &= ~TIM_SR_UIF;
+    for (uint32_t button_id = 0; button_id < PORT_BUTTON_NUM_BUTTONS; button_id++)
+    {
+        if (buttons_arr[button_id].debouncing)
+        {
+            port_button_end_debounce(button_id);
+            _button_edge(button_id);
+        }
+    }
+}
+
+/**
+ * @brief This function handles TIM5 global interrupt.
+ * This timer wakes the system up from the tickless idle of `port_system_sleep_for()`, which reads and clears the flag with the interrupts disabled. The ISR only clears the flag, in case the update is served anyway.
+ * 
+ */
+void TIM5_IRQHandler(void){
+    PORT_SYSTEM_WAKEUP_TIMER->SR &= ~TIM_SR_UIF;
+}
 
+/**
+ * @brief This function handles DMA1 Stream5 global interrupt.
+ * This stream plays the double buffer of the DAC output in circular mode. At the half transfer the first half has been played and is filled again; at the transfer complete, the second one.
+ *
+ */
+void DMA1_Stream5_IRQHandler(void){
+    if (DMA1->HISR & DMA_HISR_HTIF5)
+    {
+        DMA1->HIFCR = DMA_HIFCR_CHTIF5;
+        port_dac_fill_half(0);
+    }
+    if (DMA1->HISR & DMA_HISR_TCIF5)
+    {
+        DMA1->HIFCR = DMA_HIFCR_CTCIF5;
+        port_dac_fill_half(1);
+    }
+}
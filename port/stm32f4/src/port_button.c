@@ -11,22 +11,111 @@
 #include "port_button.h"
 
 /* Global variables ------------------------------------------------------------*/
-port_button_hw_t buttons_arr[] = {
-    [BUTTON_0_ID] = {.p_port = BUTTON_0_GPIO, .pin = BUTTON_0_PIN, .flag_pressed=false},
+port_button_hw_t buttons_arr[PORT_BUTTON_NUM_BUTTONS] = {
+    [BUTTON_0_ID] = {.p_port = BUTTON_0_GPIO, .pin = BUTTON_0_PIN, .flag_pressed=false, .debounce_ms = BUTTON_0_DEBOUNCE_TIME_MS, .debouncing = false, .isr_count = 0, .irq_event = PORT_IRQ_EVENT_BUTTON_0, .edge_head = 0, .edge_tail = 0, .edges_lost = 0},
 };
 
+/**
+ * @brief Table of the buttons of each EXTI line. Each entry is the button ID plus 1, so that 0 means no button.
+ *
+ */
+static uint8_t exti_buttons[PORT_BUTTON_EXTI_LINES];
+
+/**
+ * @brief Configure the debounce timer shared by all the buttons: one pulse, 1 tick per ms. It is only started by `port_button_start_debounce()`.
+ *
+ */
+static void _timer_debounce_setup(void){
+    RCC->APB1ENR |= RCC_APB1ENR_TIM4EN;
+    PORT_BUTTON_DEBOUNCE_TIMER->CR1 = TIM_CR1_OPM;
+    PORT_BUTTON_DEBOUNCE_TIMER->PSC = (SystemCoreClock / 1000U) - 1;
+    PORT_BUTTON_DEBOUNCE_TIMER->EGR = TIM_EGR_UG; // Load the prescaler
+    PORT_BUTTON_DEBOUNCE_TIMER->SR = 0;
+    PORT_BUTTON_DEBOUNCE_TIMER->DIER = TIM_DIER_UIE;
+    NVIC_SetPriority(PORT_BUTTON_DEBOUNCE_TIMER_IRQN, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 1, 0)); // Same as the EXTI lines, so they do not preempt each other
+    NVIC_EnableIRQ(PORT_BUTTON_DEBOUNCE_TIMER_IRQN);
+}
+
 void port_button_init(uint32_t button_id){
     GPIO_TypeDef *p_port = buttons_arr[button_id].p_port;
     uint8_t pin = buttons_arr[button_id].pin;
     port_system_gpio_config(p_port, pin, GPIO_MODE_IN, GPIO_PUPDR_NOPULL);
     port_system_gpio_config_exti(p_port, pin, TRIGGER_BOTH_EDGE | TRIGGER_ENABLE_INTERR_REQ);
+    _timer_debounce_setup();
+    buttons_arr[button_id].debouncing = false;
+    buttons_arr[button_id].edge_tail = buttons_arr[button_id].edge_head; // Discard the edges of a previous use
+    exti_buttons[pin] = button_id + 1;
     port_system_gpio_exti_enable(pin, 1, 0);
 }
 
+void port_button_set_debounce_time(uint32_t button_id, uint32_t debounce_ms){
+    buttons_arr[button_id].debounce_ms = debounce_ms;
+}
+
 bool port_button_is_pressed	(uint32_t button_id	){
     return buttons_arr[button_id].flag_pressed;
 }
 
+uint32_t port_button_get_isr_count(uint32_t button_id){
+    return buttons_arr[button_id].isr_count;
+}
+
 uint32_t port_button_get_tick(){
     return port_system_get_millis();
 }
+
+uint32_t port_button_get_exti_button(uint8_t pin){
+    if ((pin >= PORT_BUTTON_EXTI_LINES) || (exti_buttons[pin] == 0)){
+        return PORT_BUTTON_NONE;
+    }
+    return exti_buttons[pin] - 1;
+}
+
+void port_button_push_edge(uint32_t button_id, bool pressed){
+    port_button_hw_t *p_button = &buttons_arr[button_id];
+    uint64_t timestamp_us = port_system_get_micros64();
+    uint32_t head = p_button->edge_head;
+    if ((head - p_button->edge_tail) >= PORT_BUTTON_EDGE_FIFO_SIZE){
+        p_button->edges_lost++;
+        return;
+    }
+    p_button->edges[head & (PORT_BUTTON_EDGE_FIFO_SIZE - 1)].timestamp_us = timestamp_us;
+    p_button->edges[head & (PORT_BUTTON_EDGE_FIFO_SIZE - 1)].pressed = pressed;
+    __DMB(); // The edge is written before it is published: the slot is not volatile, so its stores could be moved after the head
+    p_button->edge_head = head + 1;
+}
+
+bool port_button_pop_edge(uint32_t button_id, port_button_edge_t *p_edge){
+    port_button_hw_t *p_button = &buttons_arr[button_id];
+    uint32_t tail = p_button->edge_tail;
+    if (tail == p_button->edge_head){
+        return false;
+    }
+    __DMB(); // The edge is read after the head that publishes it
+    *p_edge = p_button->edges[tail & (PORT_BUTTON_EDGE_FIFO_SIZE - 1)];
+    __DMB(); // The slot is released after it has been read, so the ISR does not overwrite it first
+    p_button->edge_tail = tail + 1;
+    return true;
+}
+
+void port_button_start_debounce(uint32_t button_id){
+    port_button_hw_t *p_button = &buttons_arr[button_id];
+    EXTI->IMR &= ~BIT_POS_TO_MASK(p_button->pin);
+    p_button->debouncing = true;
+    PORT_BUTTON_DEBOUNCE_TIMER->CR1 &= ~TIM_CR1_CEN;
+    PORT_BUTTON_DEBOUNCE_TIMER->CNT = 0;
+    PORT_BUTTON_DEBOUNCE_TIMER->ARR = p_button->debounce_ms - 1;
+    PORT_BUTTON_DEBOUNCE_TIMER->SR = 0;
+    PORT_BUTTON_DEBOUNCE_TIMER->CR1 |= TIM_CR1_CEN;
+}
+
+void port_button_end_debounce(uint32_t button_id){
+    port_button_hw_t *p_button = &buttons_arr[button_id];
+    p_button->debouncing = false;
+    EXTI->PR = BIT_POS_TO_MASK(p_button->pin); // Write 1 to clear the bounces latched while masked
+    EXTI->IMR |= BIT_POS_TO_MASK(p_button->pin);
+}
+
+bool port_button_check_debouncing(void){
+    return (PORT_BUTTON_DEBOUNCE_TIMER->CR1 & TIM_CR1_CEN) != 0;
+}
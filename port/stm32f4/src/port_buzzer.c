@@ -11,6 +11,10 @@
 
 /* HW dependent libraries */
 #include "port_buzzer.h"
+#include "port_dac.h"
+
+/* Other libraries */
+#include "buzzer_timing.h"
 
 /* Global variables */
 #define ALT_FUNC2_TIM3 0x02  /*!<TIM3 alternate function 2*/
@@ -20,9 +24,30 @@
  * 
  */
 port_buzzer_hw_t buzzers_arr[]= {
-    [BUZZER_0_ID] = {.p_port = BUZZER_0_GPIO, .pin = BUZZER_0_PIN, .alt_func = ALT_FUNC2_TIM3, .note_end = false},
+    [BUZZER_0_ID] = {.p_port = BUZZER_0_GPIO, .pin = BUZZER_0_PIN, .alt_func = ALT_FUNC2_TIM3, .note_end = false, .isr_count = 0, .write_cycles = 0, .envelope = false, .effect = PORT_BUZZER_EFFECT_NONE, .effect_note = -1, .output = PORT_BUZZER_OUTPUT_PWM},
 };
 
+/**
+ * @brief Shape of the envelope, one value per ms as a fraction of `BUZZER_PWM_DC` in Q15. It is computed once in `port_buzzer_init()`.
+ *
+ */
+static uint16_t envelope_shape[PORT_BUZZER_ENVELOPE_MS];
+
+/**
+ * @brief Values of the CCR1 register of the note that is playing, one per ms. The DMA stream of the envelope copies them to the PWM timer.
+ *
+ */
+static uint16_t envelope_ccr[PORT_BUZZER_ENVELOPE_MS];
+
+/**
+ * @brief True once the DAC output has been configured by `port_buzzer_set_output()`.
+ *
+ */
+static bool dac_ready = false;
+
+/* Tables of the pitch effects, generated by tools/buzzer_effects_codegen.py */
+#include "port_buzzer_effects.inc"
+
 /* Private functions */
 
 /**
@@ -67,6 +92,251 @@ static void _timer_pwm_setup(uint32_t buzzer_id){
   }
 }	
 
+/**
+ * @brief Compute the shape of the envelope, and configure the DMA and the timer that paces it: one update per ms. The duty cycle rises linearly during the attack and falls exponentially to the sustain level during the decay.
+ *
+ */
+static void _envelope_setup(void){
+  RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+  RCC->APB2ENR |= RCC_APB2ENR_TIM1EN;
+  PORT_BUZZER_ENVELOPE_TIMER->CR1 &= ~TIM_CR1_CEN;
+  PORT_BUZZER_ENVELOPE_TIMER->PSC = (SystemCoreClock / 1000000) - 1;
+  PORT_BUZZER_ENVELOPE_TIMER->ARR = 1000 - 1;
+  for (uint32_t ms = 0; ms < PORT_BUZZER_ENVELOPE_MS; ms++)
+  {
+    double level;
+    if (ms < PORT_BUZZER_ENVELOPE_ATTACK_MS){
+      level = (double)ms / PORT_BUZZER_ENVELOPE_ATTACK_MS;
+    }
+    else{
+      double decay = (double)(ms - PORT_BUZZER_ENVELOPE_ATTACK_MS) / PORT_BUZZER_ENVELOPE_DECAY_MS;
+      level = PORT_BUZZER_ENVELOPE_SUSTAIN + (1.0 - PORT_BUZZER_ENVELOPE_SUSTAIN) * exp(-4.0 * decay);
+    }
+    envelope_shape[ms] = (uint16_t)round(level * 32768.0);
+  }
+  // The duty cycle is left at the sustain level
+  envelope_shape[PORT_BUZZER_ENVELOPE_MS - 1] = (uint16_t)round(PORT_BUZZER_ENVELOPE_SUSTAIN * 32768.0);
+}
+
+/**
+ * @brief Fill the values of CCR1 of the envelope of a note, one per ms. It costs `PORT_BUZZER_ENVELOPE_MS` integer products, whatever the frequency of the note.
+ *
+ * @param peak_ccr Value of CCR1 for a duty cycle of `BUZZER_PWM_DC`
+ */
+static void _envelope_fill(uint32_t peak_ccr){
+  for (uint32_t ms = 0; ms < PORT_BUZZER_ENVELOPE_MS; ms++)
+  {
+    envelope_ccr[ms] = (peak_ccr * envelope_shape[ms]) >> 15;
+  }
+}
+
+/**
+ * @brief Stop the timer and the DMA stream of the envelope.
+ *
+ */
+static void _envelope_stop(void){
+  PORT_BUZZER_ENVELOPE_TIMER->CR1 &= ~TIM_CR1_CEN;
+  PORT_BUZZER_ENVELOPE_TIMER->DIER &= ~TIM_DIER_UDE;
+  PORT_BUZZER_ENVELOPE_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+  while (PORT_BUZZER_ENVELOPE_DMA_STREAM->CR & DMA_SxCR_EN)
+  {
+    // Wait for the transfer in progress to end
+  }
+}
+
+/**
+ * @brief Start the DMA stream of the envelope and its timer. CCR1 already holds the first value, so the stream copies the rest, one on every update of the timer, every ms. The preload of CCR1 makes each value the duty cycle of the next PWM period. The last value is kept until the end of the note.
+ *
+ */
+static void _envelope_start(void){
+  DMA_Stream_TypeDef *p_stream = PORT_BUZZER_ENVELOPE_DMA_STREAM;
+  DMA2->HIFCR = DMA_HIFCR_CTCIF5 | DMA_HIFCR_CHTIF5 | DMA_HIFCR_CTEIF5 | DMA_HIFCR_CDMEIF5 | DMA_HIFCR_CFEIF5;
+  p_stream->PAR = (uint32_t)(uintptr_t)&TIM3->CCR1;
+  p_stream->M0AR = (uint32_t)(uintptr_t)&envelope_ccr[1];
+  p_stream->NDTR = PORT_BUZZER_ENVELOPE_MS - 1;
+  p_stream->FCR = 0; // Direct mode
+  p_stream->CR = (PORT_BUZZER_ENVELOPE_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_PL_1;
+  p_stream->CR |= DMA_SxCR_EN;
+  PORT_BUZZER_ENVELOPE_TIMER->CNT = 0;
+  PORT_BUZZER_ENVELOPE_TIMER->SR = 0;
+  PORT_BUZZER_ENVELOPE_TIMER->DIER |= TIM_DIER_UDE;
+  PORT_BUZZER_ENVELOPE_TIMER->CR1 |= TIM_CR1_CEN;
+}
+
+
+/**
+ * @brief Enable the clock of the DMA of the effects and configure the timer that paces them. It is only started by the effects.
+ *
+ */
+static void _effect_setup(void){
+  RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+  RCC->APB1ENR |= RCC_APB1ENR_TIM7EN;
+  PORT_BUZZER_EFFECT_TIMER->CR1 &= ~TIM_CR1_CEN;
+}
+
+/**
+ * @brief Find a note in the effect tables.
+ *
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param frequency_hz Frequency of the note in Hz
+ * @return int32_t Index of the note in the tables. -1 if the buzzer has no effect, the tables were generated for another system clock or the note is not in them.
+ */
+static int32_t _effect_find_note(uint32_t buzzer_id, double frequency_hz){
+  if ((buzzers_arr[buzzer_id].effect == PORT_BUZZER_EFFECT_NONE) || (SystemCoreClock != PORT_BUZZER_EFFECTS_CLOCK_HZ)){
+    return -1;
+  }
+  for (int32_t note = 0; note < PORT_BUZZER_EFFECTS_NUM_NOTES; note++)
+  {
+    if (effects_notes[note] == frequency_hz){
+      return note;
+    }
+  }
+  return -1;
+}
+
+/**
+ * @brief Get the step of the pitch grid the note starts from: the previous note if the note glides from it, or the note itself.
+ *
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param note Index of the note in the tables
+ * @return uint32_t Step of the pitch grid of the first PWM period of the note
+ */
+static uint32_t _effect_glide_origin(uint32_t buzzer_id, int32_t note){
+  uint32_t target = effects_note_grid[note];
+  int32_t previous = buzzers_arr[buzzer_id].effect_note;
+  if ((buzzers_arr[buzzer_id].effect != PORT_BUZZER_EFFECT_GLIDE) || (previous < 0)){
+    return target;
+  }
+  uint32_t origin = effects_note_grid[previous];
+  uint32_t interval = (origin > target) ? (origin - target) : (target - origin);
+  if (interval > PORT_BUZZER_GLIDE_MAX_SEMITONES * PORT_BUZZER_EFFECTS_STEPS_PER_SEMITONE){
+    return target;
+  }
+  return origin;
+}
+
+/**
+ * @brief Stop the timer and the DMA stream of the effects.
+ *
+ */
+static void _effect_stop(void){
+  PORT_BUZZER_EFFECT_TIMER->CR1 &= ~TIM_CR1_CEN;
+  PORT_BUZZER_EFFECT_TIMER->DIER &= ~TIM_DIER_UDE;
+  PORT_BUZZER_EFFECT_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+  while (PORT_BUZZER_EFFECT_DMA_STREAM->CR & DMA_SxCR_EN)
+  {
+    // Wait for the transfer in progress to end
+  }
+}
+
+/**
+ * @brief Start the effect of a note. The DMA stream copies the ARR values of the effect to the PWM timer on every update of the effect timer: a cycle of vibrato in circular mode, or the steps of the pitch grid from the previous note to the new one once. The preload of ARR makes each value the period of the next PWM period.
+ *
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param note Index of the note in the tables
+ * @param origin Step of the pitch grid of the first PWM period of the note
+ */
+static void _effect_start(uint32_t buzzer_id, int32_t note, uint32_t origin){
+  DMA_Stream_TypeDef *p_stream = PORT_BUZZER_EFFECT_DMA_STREAM;
+  uint32_t target = effects_note_grid[note];
+  const uint16_t *p_values;
+  uint32_t length;
+  uint32_t step_us;
+  bool circular = false;
+  if (buzzers_arr[buzzer_id].effect == PORT_BUZZER_EFFECT_VIBRATO){
+    p_values = effects_vibrato[note];
+    length = PORT_BUZZER_EFFECTS_VIBRATO_STEPS;
+    step_us = 1000000 / (PORT_BUZZER_EFFECTS_VIBRATO_HZ * PORT_BUZZER_EFFECTS_VIBRATO_STEPS);
+    circular = true;
+  }
+  else if (origin < target){
+    p_values = &effects_grid_up[origin + 1];
+    length = target - origin;
+    step_us = (PORT_BUZZER_GLIDE_MS * 1000) / length;
+  }
+  else if (origin > target){
+    p_values = &effects_grid_down[PORT_BUZZER_EFFECTS_GRID_LENGTH - origin];
+    length = origin - target;
+    step_us = (PORT_BUZZER_GLIDE_MS * 1000) / length;
+  }
+  else{
+    return; // No glide
+  }
+  // Effect timer: a tick per us and an update per step
+  PORT_BUZZER_EFFECT_TIMER->PSC = (SystemCoreClock / 1000000) - 1;
+  PORT_BUZZER_EFFECT_TIMER->ARR = step_us - 1;
+  PORT_BUZZER_EFFECT_TIMER->CNT = 0;
+  PORT_BUZZER_EFFECT_TIMER->EGR = TIM_EGR_UG;
+  PORT_BUZZER_EFFECT_TIMER->SR &= ~TIM_SR_UIF;
+
+  DMA1->HIFCR = DMA_HIFCR_CTCIF4 | DMA_HIFCR_CHTIF4 | DMA_HIFCR_CTEIF4 | DMA_HIFCR_CDMEIF4 | DMA_HIFCR_CFEIF4;
+  p_stream->PAR = (uint32_t)(uintptr_t)&TIM3->ARR;
+  p_stream->M0AR = (uint32_t)(uintptr_t)p_values;
+  p_stream->NDTR = length;
+  p_stream->FCR = 0; // Direct mode
+  p_stream->CR = (PORT_BUZZER_EFFECT_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_PL_1 | (circular ? DMA_SxCR_CIRC : 0);
+  p_stream->CR |= DMA_SxCR_EN;
+  PORT_BUZZER_EFFECT_TIMER->DIER |= TIM_DIER_UDE;
+  PORT_BUZZER_EFFECT_TIMER->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * @brief Start the timer that controls the duration of the note with its PSC and ARR.
+ *
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param psc Value of the PSC register
+ * @param arr Value of the ARR register
+ */
+static void _duration_start(uint32_t buzzer_id, uint32_t psc, uint32_t arr){
+  //1. Deshabilitar el timer y resetear la cuenta
+  TIM2->CR1 &= ~TIM_CR1_CEN;
+  TIM2->CNT = 0;
+  //2. Precargar ARR y PSC en los registros correspondientes
+  TIM2->ARR = arr;
+  TIM2->PSC = psc;
+  //3. Cargar ARR y PSC en los registros correspondientes
+  TIM2->EGR = TIM_EGR_UG;
+  //4. Configurar flag note_end
+  buzzers_arr[buzzer_id].note_end = false;
+  //5. Habilitar el timer
+  TIM2->CR1 |= TIM_CR1_CEN;
+}
+
+/**
+ * @brief Start the PWM timer with the PSC, ARR and CCR1 of a note, and its envelope and effect if any.
+ *
+ * @param buzzer_id	Buzzer melody player ID. This index is used to select the element of the buzzers_arr[] array
+ * @param psc Value of the PSC register
+ * @param arr Value of the ARR register of the note
+ * @param ccr Value of the CCR1 register of the note, the peak of the envelope
+ * @param note Index of the note in the effect tables, or -1 to play it without effect
+ * @param effect_origin Step of the pitch grid of the first PWM period of the effect
+ */
+static void _pwm_start(uint32_t buzzer_id, uint32_t psc, uint32_t arr, uint32_t ccr, int32_t note, uint32_t effect_origin){
+  //1. Precargar ARR y PSC en los registros correspondientes. Un glide empieza en la nota anterior
+  TIM3->ARR = (note >= 0) ? effects_grid_up[effect_origin] : arr;
+  TIM3->PSC = psc;
+
+  //2. PWM pulse width to the duty cycle of the note, or to the first value of the envelope
+  _envelope_stop();
+  if (buzzers_arr[buzzer_id].envelope){
+    _envelope_fill(ccr);
+  }
+  TIM3->CCR1 = buzzers_arr[buzzer_id].envelope ? envelope_ccr[0] : ccr;
+  //3.
+  TIM3->EGR = TIM_EGR_UG;
+  if (buzzers_arr[buzzer_id].envelope){
+    _envelope_start();
+  }
+  if (note >= 0){
+    _effect_start(buzzer_id, note, effect_origin);
+  }
+  //4.
+  TIM3->CCER |= TIM_CCER_CC1E;
+  //5.
+  TIM3->CR1 |= TIM_CR1_CEN;
+  buzzers_arr[buzzer_id].write_cycles = port_system_get_cycles();
+}
 
 /* Public functions -----------------------------------------------------------*/
 
@@ -76,6 +346,8 @@ void port_buzzer_init(uint32_t buzzer_id)
   port_system_gpio_config_alternate(buzzers_arr[buzzer_id].p_port, buzzers_arr[buzzer_id].pin, buzzers_arr[buzzer_id].alt_func);
   _timer_duration_setup(buzzer_id);
   _timer_pwm_setup(buzzer_id);
+  _envelope_setup();
+  _effect_setup();
 }
 
 bool port_buzzer_get_note_timeout(uint32_t buzzer_id){
@@ -85,70 +357,154 @@ bool port_buzzer_get_note_timeout(uint32_t buzzer_id){
   return false;
 }
 
+uint32_t port_buzzer_get_isr_count(uint32_t buzzer_id){
+  return buzzers_arr[buzzer_id].isr_count;
+}
+
+uint32_t port_buzzer_get_write_timestamp(uint32_t buzzer_id){
+  return buzzers_arr[buzzer_id].write_cycles;
+}
+
 void port_buzzer_set_note_duration(uint32_t buzzer_id, uint32_t duration_ms){
-  //1. Deshabilitar el timer y resetear la cuenta
+  //1. Calcular PSC y ARR de la duración
+  buzzer_timing_t timing;
+  buzzer_timing_get_duration(SystemCoreClock, duration_ms, &timing);
+  //2. Arrancar el timer con ellos
+  _duration_start(buzzer_id, timing.psc, timing.arr);
+}
+
+void port_buzzer_rescale_note_duration(uint32_t buzzer_id, double ratio){
+  if ((buzzer_id != BUZZER_0_ID) || buzzers_arr[buzzer_id].note_end || !(TIM2->CR1 & TIM_CR1_CEN) || (ratio <= 0)){
+    return;
+  }
+  //1. Parar el timer para que la cuenta no avance mientras se reescala
   TIM2->CR1 &= ~TIM_CR1_CEN;
-  TIM2->CNT = 0;
-  //2. Convertir a double duration_ms y SystemCoreClock 
-  double sysclk_as_double = (double)SystemCoreClock;
-  double s_as_double = (double)duration_ms/1000;
-  //3. Calcular el valor inicial de PSC
-  double ARR_max = 65535.0; 
-  double PSC_min = round(((sysclk_as_double * s_as_double) / (ARR_max + 1)) - 1);
-  //4. Recalcular ARR 
-  double ARR = round(((sysclk_as_double * s_as_double) / (PSC_min + 1)) - 1);
-  //5. Comprobar que ARR>65535.0
-  if(ARR > 65535.0){
-    PSC_min++;
-    ARR = round(((sysclk_as_double * s_as_double) / (PSC_min + 1)) - 1);
-  }
-  //6. Precargar ARR y PSC en los registros correspondientes
-  TIM2->ARR = ARR;
-  TIM2->PSC = PSC_min;
-  //7. Cargar ARR y PSC en los registros correspondientes
-  TIM2->EGR = TIM_EGR_UG;
-  //8. Configurar flag note_end
-  buzzers_arr[buzzer_id].note_end = false;
-  //9. Habilitar el timer
+  //2. Escalar ARR y la cuenta por la misma razón: se mantiene la fracción ya tocada de la nota
+  uint32_t arr = TIM2->ARR;
+  uint32_t cnt = TIM2->CNT;
+  buzzer_timing_rescale_duration(&arr, &cnt, ratio);
+  //3. Escribir ARR sin precarga, para que cuente ya en esta nota, y la cuenta
+  TIM2->CR1 &= ~TIM_CR1_ARPE;
+  TIM2->ARR = arr;
+  TIM2->CR1 |= TIM_CR1_ARPE;
+  TIM2->CNT = cnt;
+  //4. Volver a habilitar el timer
   TIM2->CR1 |= TIM_CR1_CEN;
 }
 
 void port_buzzer_set_note_frequency	(	uint32_t buzzer_id, double frequency_hz){
+  //0. Salida por el DAC: el oscilador de tabla de ondas toca la nota
+  if (buzzers_arr[buzzer_id].output == PORT_BUZZER_OUTPUT_DAC){
+    if (frequency_hz == 0){
+      port_dac_stop();
+    }
+    else{
+      port_dac_set_frequency(frequency_hz);
+    }
+    buzzers_arr[buzzer_id].write_cycles = port_system_get_cycles();
+    return;
+  }
   //1. Si la frecuencia es 0 se deshabilita el timer
   if(frequency_hz == 0){
   TIM3->CR1 &= ~TIM_CR1_CEN;
+  _envelope_stop();
+  _effect_stop();
+  buzzers_arr[buzzer_id].effect_note = -1;
+  buzzers_arr[buzzer_id].write_cycles = port_system_get_cycles();
   return;   
   }
 
-  //2.
-  double sysclk_as_double = (double)SystemCoreClock;
-  double ARR_max = 65535.0; 
-  double PSC_min = round(((sysclk_as_double * (1/frequency_hz)) / (ARR_max + 1)) - 1);
-  //Recalcular ARR 
-  double ARR = round(((sysclk_as_double * (1/frequency_hz)) / (PSC_min + 1)) - 1);
-  //Comprobar que ARR>65535.0
-  if(ARR > 65535.0){
-    PSC_min++;
-    ARR = round(((sysclk_as_double * (1/frequency_hz)) / (PSC_min + 1)) - 1);
+  //2. ARR y PSC de la nota: de las tablas de los efectos si la nota está en ellas, o calculados
+  _effect_stop();
+  int32_t note = _effect_find_note(buzzer_id, frequency_hz);
+  uint32_t effect_origin = 0;
+  buzzer_timing_t timing;
+  if (note >= 0){
+    effect_origin = _effect_glide_origin(buzzer_id, note);
+    timing.psc = PORT_BUZZER_EFFECTS_PSC;
+    timing.arr = effects_grid_up[effects_note_grid[note]];
   }
-  //Precargar ARR y PSC en los registros correspondientes
-  TIM3->ARR = ARR;
-  TIM3->PSC = PSC_min;
+  else{
+    buzzer_timing_get_pwm(SystemCoreClock, frequency_hz, &timing);
+  }
+  buzzers_arr[buzzer_id].effect_note = note;
+  //3. Arrancar el PWM con ellos, con el ciclo de trabajo BUZZER_PWM_DC
+  _pwm_start(buzzer_id, timing.psc, timing.arr, BUZZER_PWM_DC * (timing.arr + 1), note, effect_origin);
+}
 
-  //3. PWM pulse width to BUZZER_PWM_DC.
-  TIM3->CCR1 = BUZZER_PWM_DC * (ARR + 1); 
-  //4.
-  TIM3->EGR = TIM_EGR_UG;
-  //5.
-  TIM3->CCER |= TIM_CCER_CC1E;
-  //6.
-  TIM3->CR1 |= TIM_CR1_CEN;
+void port_buzzer_compile_note(double frequency_hz, uint32_t duration_ms, buzzer_timing_note_t *p_note){
+  p_note->pwm_psc = 0;
+  p_note->pwm_arr = 0;
+  p_note->pwm_ccr = 0;
+  if (frequency_hz != 0){
+    buzzer_timing_t timing;
+    buzzer_timing_get_pwm(SystemCoreClock, frequency_hz, &timing);
+    p_note->pwm_psc = timing.psc;
+    p_note->pwm_arr = timing.arr;
+    p_note->pwm_ccr = BUZZER_PWM_DC * (timing.arr + 1);
+  }
+  port_buzzer_compile_duration(duration_ms, p_note);
+}
+
+void port_buzzer_compile_duration(uint32_t duration_ms, buzzer_timing_note_t *p_note){
+  buzzer_timing_t timing;
+  buzzer_timing_get_duration(SystemCoreClock, duration_ms, &timing);
+  p_note->duration_psc = timing.psc;
+  p_note->duration_arr = timing.arr;
+}
+
+void port_buzzer_play_compiled_note(uint32_t buzzer_id, double frequency_hz, const buzzer_timing_note_t *p_note){
+  if ((p_note->pwm_arr == 0) || (buzzers_arr[buzzer_id].output != PORT_BUZZER_OUTPUT_PWM) || (buzzers_arr[buzzer_id].effect != PORT_BUZZER_EFFECT_NONE)){
+    // Silences, the DAC output and the effects take their values from the frequency
+    port_buzzer_set_note_frequency(buzzer_id, frequency_hz);
+  }
+  else{
+    _effect_stop();
+    buzzers_arr[buzzer_id].effect_note = -1;
+    _pwm_start(buzzer_id, p_note->pwm_psc, p_note->pwm_arr, p_note->pwm_ccr, -1, 0);
+  }
+  _duration_start(buzzer_id, p_note->duration_psc, p_note->duration_arr);
+}
+
+void port_buzzer_set_envelope(uint32_t buzzer_id, bool enable){
+  buzzers_arr[buzzer_id].envelope = enable;
+  if (!enable){
+    _envelope_stop();
+  }
+}
+
+void port_buzzer_set_effect(uint32_t buzzer_id, uint8_t effect){
+  buzzers_arr[buzzer_id].effect = effect;
+  buzzers_arr[buzzer_id].effect_note = -1;
+  _effect_stop();
+}
+
+void port_buzzer_set_output(uint32_t buzzer_id, uint8_t output){
+  // Only the sound is stopped: the duration of the note goes on, and the next note is played on the new output
+  TIM3->CR1 &= ~TIM_CR1_CEN;
+  _envelope_stop();
+  _effect_stop();
+  if (dac_ready){
+    port_dac_stop();
+  }
+  if ((output == PORT_BUZZER_OUTPUT_DAC) && !dac_ready){
+    port_dac_init();
+    dac_ready = true;
+  }
+  buzzers_arr[buzzer_id].output = output;
+  buzzers_arr[buzzer_id].effect_note = -1;
 }
 
 void port_buzzer_stop(uint32_t buzzer_id){
   if(buzzer_id == BUZZER_0_ID){
     TIM2-> CR1 &= ~TIM_CR1_CEN;
     TIM3-> CR1 &= ~TIM_CR1_CEN;
+    _envelope_stop();
+    _effect_stop();
+    if (dac_ready){
+      port_dac_stop();
+    }
+    buzzers_arr[buzzer_id].write_cycles = port_system_get_cycles();
   }
   return;
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+/**
+ * @file port_dac.c
+ * @brief Portable functions of the DAC output of the buzzer: a wavetable oscillator played by DMA from a double buffer.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* HW dependent libraries */
+#include "port_dac.h"
+
+/* Other libraries */
+#include "wavetable.h"
+
+/* Global variables */
+/**
+ * @brief Wavetable of the oscillator, filled once in `port_dac_init()`.
+ *
+ */
+static int16_t dac_table[WAVETABLE_LENGTH];
+
+/**
+ * @brief Double buffer of samples. The DMA stream copies it to the DAC in circular mode. It is aligned to 4 bytes so the samples are stored in pairs.
+ *
+ */
+static uint16_t dac_buffer[PORT_DAC_BUFFER_LENGTH] __attribute__((aligned(4)));
+
+/**
+ * @brief Wavetable oscillator of the DAC output.
+ *
+ */
+static wavetable_osc_t dac_osc;
+
+/**
+ * @brief Harmonics of the wavetable.
+ *
+ */
+static const double dac_harmonics[] = WAVETABLE_HARMONICS_ORGAN;
+
+/* Public functions -----------------------------------------------------------*/
+void port_dac_init(void){
+  port_system_gpio_config(PORT_DAC_GPIO, PORT_DAC_PIN, GPIO_MODE_ANALOG, GPIO_PUPDR_NOPULL);
+  wavetable_init_table(dac_table, dac_harmonics, sizeof(dac_harmonics) / sizeof(dac_harmonics[0]));
+  wavetable_osc_init(&dac_osc, dac_table, true);
+
+  // Trigger timer: an update per sample, as TRGO
+  RCC->APB1ENR |= RCC_APB1ENR_TIM6EN;
+  PORT_DAC_TIMER->CR1 &= ~TIM_CR1_CEN;
+  PORT_DAC_TIMER->PSC = 0;
+  PORT_DAC_TIMER->ARR = (SystemCoreClock / PORT_DAC_SAMPLE_RATE_HZ) - 1;
+  PORT_DAC_TIMER->CR2 = (PORT_DAC_TIMER->CR2 & ~TIM_CR2_MMS) | TIM_CR2_MMS_1;
+
+  // Channel 1 of the DAC: triggered by TIM6 (TSEL1 = 0), with a DMA request per conversion
+  RCC->APB1ENR |= RCC_APB1ENR_DACEN;
+  DAC->CR &= ~(DAC_CR_EN1 | DAC_CR_TSEL1);
+  DAC->CR |= DAC_CR_TEN1 | DAC_CR_DMAEN1;
+  DAC->DHR12R1 = WAVETABLE_OUTPUT_MIDSCALE;
+  DAC->CR |= DAC_CR_EN1;
+
+  RCC->AHB1ENR |= RCC_AHB1ENR_DMA1EN;
+  NVIC_SetPriority(PORT_DAC_DMA_IRQN, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 2, 0));
+  NVIC_EnableIRQ(PORT_DAC_DMA_IRQN);
+}
+
+void port_dac_set_frequency(double frequency_hz){
+  wavetable_osc_set_frequency(&dac_osc, frequency_hz, PORT_DAC_SAMPLE_RATE_HZ);
+  if (port_dac_check_running()){
+    return; // The new frequency is heard from the next half of the buffer
+  }
+  port_dac_fill_half(0);
+  port_dac_fill_half(1);
+
+  DMA_Stream_TypeDef *p_stream = PORT_DAC_DMA_STREAM;
+  DMA1->HIFCR = DMA_HIFCR_CTCIF5 | DMA_HIFCR_CHTIF5 | DMA_HIFCR_CTEIF5 | DMA_HIFCR_CDMEIF5 | DMA_HIFCR_CFEIF5;
+  p_stream->PAR = (uint32_t)(uintptr_t)&DAC->DHR12R1;
+  p_stream->M0AR = (uint32_t)(uintptr_t)dac_buffer;
+  p_stream->NDTR = PORT_DAC_BUFFER_LENGTH;
+  p_stream->FCR = 0; // Direct mode
+  p_stream->CR = (PORT_DAC_DMA_CHANNEL << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MSIZE_0 | DMA_SxCR_PSIZE_0 | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_PL_1 | DMA_SxCR_CIRC | DMA_SxCR_HTIE | DMA_SxCR_TCIE;
+  p_stream->CR |= DMA_SxCR_EN;
+
+  PORT_DAC_TIMER->CNT = 0;
+  PORT_DAC_TIMER->CR1 |= TIM_CR1_CEN;
+}
+
+void port_dac_stop(void){
+  PORT_DAC_TIMER->CR1 &= ~TIM_CR1_CEN;
+  PORT_DAC_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+  while (PORT_DAC_DMA_STREAM->CR & DMA_SxCR_EN)
+  {
+    // Wait for the transfer in progress to end
+  }
+  wavetable_osc_set_frequency(&dac_osc, 0, PORT_DAC_SAMPLE_RATE_HZ);
+  DAC->DHR12R1 = WAVETABLE_OUTPUT_MIDSCALE;
+}
+
+void port_dac_fill_half(uint32_t half){
+  wavetable_fill(&dac_osc, &dac_buffer[half * PORT_DAC_HALF_LENGTH], PORT_DAC_HALF_LENGTH);
+}
+
+bool port_dac_check_running(void){
+  return (PORT_DAC_TIMER->CR1 & TIM_CR1_CEN) != 0;
+}
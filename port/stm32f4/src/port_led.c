@@ -11,16 +11,106 @@
 #include "port_led.h"
 
 /* Global variables ------------------------------------------------------------*/
-port_led_hw_t leds_arr[] = {
-    [LED_0_ID] = {.p_port = LED_0_GPIO, .pin = LED_0_PIN, .melody_start = false, .melody_end = true},
-    [LED_1_ID] = {.p_port = LED_1_GPIO, .pin = LED_1_PIN, .melody_start = false, .melody_end = true},
+port_led_hw_t leds_arr[PORT_LED_NUM_LEDS] = {
+    [LED_0_ID] = {.p_port = LED_0_GPIO, .pin = LED_0_PIN, .p_dma_stream = DMA2_Stream1, .dma_channel = 7, .dma_request = TIM_DIER_UDE, .dma_flags = DMA_LIFCR_CTCIF1 | DMA_LIFCR_CHTIF1 | DMA_LIFCR_CTEIF1 | DMA_LIFCR_CDMEIF1 | DMA_LIFCR_CFEIF1, .visualizer_on = false},
+    [LED_1_ID] = {.p_port = LED_1_GPIO, .pin = LED_1_PIN, .p_dma_stream = DMA2_Stream2, .dma_channel = 7, .dma_request = TIM_DIER_CC1DE, .dma_flags = DMA_LIFCR_CTCIF2 | DMA_LIFCR_CHTIF2 | DMA_LIFCR_CTEIF2 | DMA_LIFCR_CDMEIF2 | DMA_LIFCR_CFEIF2, .visualizer_on = false},
 };
 
+/**
+ * @brief Patterns of the visualizer of each LED, as values of the BSRR register. Each pattern has a segment per level, from the maximum down to 0, of `PORT_LED_VISUALIZER_LEVEL_PERIODS` PWM periods each.
+ *
+ */
+static uint32_t visualizer_patterns[PORT_LED_NUM_LEDS][PORT_LED_VISUALIZER_PATTERN_LENGTH];
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Fill the pattern of the visualizer of the LED. In each PWM period of level `n`, the first `n` slots turn the LED on and the rest turn it off.
+ *
+ * @param led_id LED ID. This index is used to select the element of the LEDs_arr[] array.
+ */
+static void _visualizer_fill_pattern(uint32_t led_id){
+    uint32_t set = BIT_POS_TO_MASK(leds_arr[led_id].pin);
+    uint32_t reset = set << 16;
+    uint32_t *p_pattern = visualizer_patterns[led_id];
+    for (uint32_t segment = 0; segment <= PORT_LED_VISUALIZER_MAX_LEVEL; segment++)
+    {
+        uint32_t level = PORT_LED_VISUALIZER_MAX_LEVEL - segment;
+        for (uint32_t i = 0; i < PORT_LED_VISUALIZER_SEGMENT_LENGTH; i++)
+        {
+            uint32_t slot = i % PORT_LED_VISUALIZER_MAX_LEVEL;
+            *p_pattern++ = (slot < level) ? set : reset;
+        }
+    }
+}
+
+/**
+ * @brief Configure the visualizer timer, shared by all the LEDs: a DMA request every slot, the update for LED_0 and the compare of channel 1 for LED_1. It is only started by the visualizer.
+ *
+ * @param led_id LED ID. This index is used to select the element of the LEDs_arr[] array.
+ */
+static void _visualizer_timer_setup(uint32_t led_id){
+    RCC->APB2ENR |= RCC_APB2ENR_TIM8EN;
+    RCC->AHB1ENR |= RCC_AHB1ENR_DMA2EN;
+    if (!(PORT_LED_VISUALIZER_TIMER->CR1 & TIM_CR1_CEN)){
+        PORT_LED_VISUALIZER_TIMER->PSC = 0;
+        PORT_LED_VISUALIZER_TIMER->ARR = (SystemCoreClock / PORT_LED_VISUALIZER_SLOT_HZ) - 1;
+        PORT_LED_VISUALIZER_TIMER->CCR1 = 0; // A compare of channel 1 at the start of every slot
+    }
+    PORT_LED_VISUALIZER_TIMER->DIER |= leds_arr[led_id].dma_request;
+}
+
+/**
+ * @brief Disable the DMA stream of the visualizer of the LED. The visualizer timer is stopped when no LED uses it.
+ *
+ * @param led_id LED ID. This index is used to select the element of the LEDs_arr[] array.
+ */
+static void _visualizer_disable(uint32_t led_id){
+    DMA_Stream_TypeDef *p_stream = leds_arr[led_id].p_dma_stream;
+    p_stream->CR &= ~DMA_SxCR_EN;
+    while (p_stream->CR & DMA_SxCR_EN)
+    {
+        // Wait for the transfer in progress to end
+    }
+    leds_arr[led_id].visualizer_on = false;
+    for (uint32_t i = 0; i < PORT_LED_NUM_LEDS; i++)
+    {
+        if (leds_arr[i].visualizer_on){
+            return;
+        }
+    }
+    PORT_LED_VISUALIZER_TIMER->CR1 &= ~TIM_CR1_CEN;
+}
+
+/**
+ * @brief Start the DMA stream of the visualizer of the LED from a part of its pattern.
+ *
+ * @param led_id LED ID. This index is used to select the element of the LEDs_arr[] array.
+ * @param level Level of the first segment of the pattern copied
+ * @param length Number of slots copied
+ * @param circular True to copy them again and again, false to copy them once
+ */
+static void _visualizer_start(uint32_t led_id, uint32_t level, uint32_t length, bool circular){
+    port_led_hw_t *p_led = &leds_arr[led_id];
+    DMA_Stream_TypeDef *p_stream = p_led->p_dma_stream;
+    _visualizer_disable(led_id);
+    DMA2->LIFCR = p_led->dma_flags;
+    p_stream->PAR = (uint32_t)(uintptr_t)&p_led->p_port->BSRR;
+    p_stream->M0AR = (uint32_t)(uintptr_t)&visualizer_patterns[led_id][(PORT_LED_VISUALIZER_MAX_LEVEL - level) * PORT_LED_VISUALIZER_SEGMENT_LENGTH];
+    p_stream->NDTR = length;
+    p_stream->FCR = 0; // Direct mode
+    p_stream->CR = (p_led->dma_channel << DMA_SxCR_CHSEL_Pos) | DMA_SxCR_MSIZE_1 | DMA_SxCR_PSIZE_1 | DMA_SxCR_MINC | DMA_SxCR_DIR_0 | DMA_SxCR_PL_1 | (circular ? DMA_SxCR_CIRC : 0);
+    p_stream->CR |= DMA_SxCR_EN;
+    p_led->visualizer_on = true;
+    PORT_LED_VISUALIZER_TIMER->CR1 |= TIM_CR1_CEN;
+}
+
 /* Public functions -----------------------------------------------------------*/
 void port_led_init(uint32_t led_id){
     GPIO_TypeDef *p_port = leds_arr[led_id].p_port;
     uint8_t pin = leds_arr[led_id].pin;
     port_system_gpio_config(p_port, pin, GPIO_MODE_OUT, GPIO_PUPDR_NOPULL);
+    _visualizer_fill_pattern(led_id);
+    _visualizer_timer_setup(led_id);
 }
 
 bool port_led_get(uint32_t led_id) {
@@ -35,33 +125,57 @@ bool port_led_get(uint32_t led_id) {
     return current_value;
 }
 void port_led_turn_on(uint32_t led_id) {
-    // Definimos la máscara según sea el LED0 o LED1
-    uint32_t ODR_MASK;
-    if (led_id == LED_0_ID) {
-        ODR_MASK = ODR5_MASK_LED0;
-    } else if (led_id == LED_1_ID) {
-        ODR_MASK = ODR5_MASK_LED1;
+    if (leds_arr[led_id].visualizer_on) {
+        _visualizer_disable(led_id);
     }
-    // Se usa la GPIO del LED0 porque ambos para ambos es el mismo
-    LED_0_GPIO->ODR |= ODR_MASK;
+    // Una sola escritura en BSRR, sin leer y modificar el registro ODR
+    port_system_gpio_write(leds_arr[led_id].p_port, leds_arr[led_id].pin, HIGH);
 }
 
 void port_led_turn_off(uint32_t led_id) {
-    // Definimos la máscara según sea el LED0 o LED1
-    uint32_t ODR_MASK;
-    if (led_id == LED_0_ID) {
-        ODR_MASK = ODR5_MASK_LED0;
-    } else if (led_id == LED_1_ID) {
-        ODR_MASK = ODR5_MASK_LED1;
+    if (leds_arr[led_id].visualizer_on) {
+        _visualizer_disable(led_id);
     }
-    // Se usa la GPIO del LED0 porque ambos para ambos es el mismo
-    LED_0_GPIO->ODR &= ~ODR_MASK;
+    // Una sola escritura en BSRR, sin leer y modificar el registro ODR
+    port_system_gpio_write(leds_arr[led_id].p_port, leds_arr[led_id].pin, LOW);
 }
 
-bool port_check_melody_start(uint32_t led_id){
-    return leds_arr[led_id].melody_start;
+void port_led_write_mask(uint32_t on_mask, uint32_t off_mask) {
+    uint16_t set_mask = 0;
+    uint16_t reset_mask = 0;
+    for (uint32_t led_id = 0; led_id < PORT_LED_NUM_LEDS; led_id++)
+    {
+        if (on_mask & BIT_POS_TO_MASK(led_id)) {
+            set_mask |= BIT_POS_TO_MASK(leds_arr[led_id].pin);
+        }
+        if (off_mask & BIT_POS_TO_MASK(led_id)) {
+            reset_mask |= BIT_POS_TO_MASK(leds_arr[led_id].pin);
+        }
+    }
+    // Se usa la GPIO del LED0 porque para ambos es el mismo
+    port_system_gpio_write_mask(leds_arr[LED_0_ID].p_port, set_mask, reset_mask);
+}
+
+void port_led_visualizer_pulse(uint32_t led_id, uint32_t level){
+    if (level > PORT_LED_VISUALIZER_MAX_LEVEL){
+        level = PORT_LED_VISUALIZER_MAX_LEVEL;
+    }
+    if (level == 0){
+        port_led_visualizer_stop(led_id);
+        return;
+    }
+    // The segments from the level down to 0, so the LED is left off
+    _visualizer_start(led_id, level, (level + 1) * PORT_LED_VISUALIZER_SEGMENT_LENGTH, false);
 }
 
-bool port_check_melody_end(uint32_t led_id){
-    return leds_arr[led_id].melody_end;
-}
\ No newline at end of file
+void port_led_visualizer_hold(uint32_t led_id, uint32_t level){
+    if (level > PORT_LED_VISUALIZER_MAX_LEVEL){
+        level = PORT_LED_VISUALIZER_MAX_LEVEL;
+    }
+    // A single PWM period of the segment of the level
+    _visualizer_start(led_id, level, PORT_LED_VISUALIZER_MAX_LEVEL, true);
+}
+
+void port_led_visualizer_stop(uint32_t led_id){
+    port_led_turn_off(led_id);
+}
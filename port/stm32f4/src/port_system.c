@@ -7,12 +7,20 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "port_system.h"
+#include "port_button.h"
 
 /* Defines -------------------------------------------------------------------*/
 #define HSI_VALUE ((uint32_t)16000000) /*!< Value of the Internal oscillator in Hz */
 
 /* GLOBAL VARIABLES */
 static volatile uint32_t msTicks = 0; /*!< Variable to store millisecond ticks. @warning **It must be declared volatile!** Just because it is modified in an ISR. **Add it to the definition** after *static*. */
+static volatile uint32_t irq_events = 0; /*!< IRQ events posted by the ISRs and not taken yet. It is modified in the ISRs, so it must be volatile. */
+static uint32_t wakeup_remainder_ticks = 0; /*!< Ticks of the wakeup timer slept and not added to msTicks yet, because they do not make a whole ms. */
+static volatile uint32_t cycles_high = 0; /*!< Number of wraparounds of the DWT cycle counter, the high word of the 64-bit count of cycles. */
+static volatile uint32_t cycles_last = 0; /*!< Value of the DWT cycle counter when `cycles_high` was last updated. */
+static uint64_t cycles_slept = 0; /*!< Cycles slept with the System tick suspended and not counted by the DWT cycle counter. */
+static uint32_t stop_count = 0; /*!< Number of wake-ups from STOP mode. */
+static uint32_t stop_wake_cycles = 0; /*!< Timestamp in CPU cycles of the last wake-up from STOP mode. */
 
 /* These variables are declared extern in CMSIS (system_stm32f4xx.h) */
 uint32_t SystemCoreClock = HSI_VALUE;                                               /*!< Frequency of the System clock */
@@ -86,6 +94,19 @@ void system_clock_config(void)
   SysTick_Config(SystemCoreClock / (1000U / TICK_FREQ_1KHZ)); /* Set Systick to 1 ms */
 }
 
+/**
+ * @brief Restore the system clock after a wake-up from STOP mode.
+ *
+ * @note The system clock is the HSI, which the hardware selects on wake-up from STOP mode, so it only has to be selected again in case the configuration changes, without waiting for an oscillator or a PLL to lock. If a PLL is ever used, it must be enabled again here.
+ * @retval None
+ */
+static void system_clock_restore(void)
+{
+  RCC->CFGR &= ~RCC_CFGR_SW;
+  RCC->CFGR |= (RCC_CFGR_SW & (RCC_CFGR_SW_HSI << RCC_CFGR_SW_Pos));
+  SysTick->VAL = 0; // The next tick comes a whole ms after the wake-up
+}
+
 size_t port_system_init()
 {
   /* Reset of all peripherals, Initializes the Flash interface and the Systick. */
@@ -116,6 +137,21 @@ size_t port_system_init()
   /* Configure the system clock */
   system_clock_config();
 
+  /* Enable the cycle counter of the Data Watchpoint and Trace unit (DWT) to take timestamps */
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /* Configure the wakeup timer of the tickless idle: one pulse, PORT_SYSTEM_WAKEUP_TICKS_PER_MS ticks per ms. It is only started by port_system_sleep_for() */
+  RCC->APB1ENR |= RCC_APB1ENR_TIM5EN;
+  PORT_SYSTEM_WAKEUP_TIMER->CR1 = TIM_CR1_OPM;
+  PORT_SYSTEM_WAKEUP_TIMER->PSC = (SystemCoreClock / (1000U * PORT_SYSTEM_WAKEUP_TICKS_PER_MS)) - 1;
+  PORT_SYSTEM_WAKEUP_TIMER->EGR = TIM_EGR_UG; // Load the prescaler
+  PORT_SYSTEM_WAKEUP_TIMER->SR = 0;
+  PORT_SYSTEM_WAKEUP_TIMER->DIER = 0;
+  NVIC_SetPriority(PORT_SYSTEM_WAKEUP_TIMER_IRQN, NVIC_EncodePriority(NVIC_GetPriorityGrouping(), 15, 0));
+  NVIC_EnableIRQ(PORT_SYSTEM_WAKEUP_TIMER_IRQN); // Needed to wake the core up, although the ISR does not run
+
   return 0;
 }
 
@@ -132,6 +168,45 @@ void port_system_set_millis(uint32_t ms)
   msTicks = ms;
 }
 
+uint32_t port_system_get_cycles(void)
+{
+  return DWT->CYCCNT;
+}
+
+uint32_t port_system_get_cycles_per_us(void)
+{
+  return SystemCoreClock / 1000000U;
+}
+
+void port_system_update_cycles(void)
+{
+  uint32_t now = DWT->CYCCNT;
+  if (now < cycles_last)
+  {
+    cycles_high++;
+  }
+  cycles_last = now;
+}
+
+uint64_t port_system_get_micros64(void)
+{
+  uint32_t high;
+  uint32_t last;
+  uint32_t low;
+  do
+  {
+    high = cycles_high;
+    last = cycles_last;
+    low = DWT->CYCCNT;
+  } while ((high != cycles_high) || (last != cycles_last)); // Read again if the SysTick ISR has updated them meanwhile
+  if (low < last)
+  {
+    high++; // Wraparound since the last System tick
+  }
+  uint64_t cycles = ((((uint64_t)high) << 32) | low) + cycles_slept;
+  return cycles / port_system_get_cycles_per_us();
+}
+
 void port_system_delay_ms(uint32_t ms)
 {
   uint32_t tickstart = port_system_get_millis();
@@ -285,13 +360,37 @@ void port_system_gpio_write	(GPIO_TypeDef *p_port, uint8_t pin, bool value){
   }
 }
 
+void port_system_gpio_write_mask(GPIO_TypeDef *p_port, uint16_t set_mask, uint16_t reset_mask){
+  // Los 16 bits bajos de BSRR activan los pines y los 16 altos los desactivan, en una sola escritura
+  p_port -> BSRR = ((uint32_t)reset_mask << 16) | set_mask;
+}
+
 void port_system_gpio_toggle (GPIO_TypeDef *p_port, uint8_t pin){
-  // Se toma como valor el valor leido
-  bool value = port_system_gpio_read(p_port, pin);
+  // Se toma como valor el valor del registro de salida ODR, no el del pin
+  bool value = (bool)(p_port -> ODR & BIT_POS_TO_MASK(pin));
   // Se escribe el valor opuesto al leido
   port_system_gpio_write(p_port, pin, !value);
 }
 
+// ------------------------------------------------------
+// IRQ EVENTS RELATED FUNCTIONS
+// ------------------------------------------------------
+void port_system_post_irq_event(uint32_t events){
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq(); // An ISR of higher priority could post at the same time
+  irq_events |= events;
+  __set_PRIMASK(primask);
+}
+
+uint32_t port_system_take_irq_events(void){
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint32_t events = irq_events;
+  irq_events = 0;
+  __set_PRIMASK(primask);
+  return events;
+}
+
 // ------------------------------------------------------
 // POWER RELATED FUNCTIONS
 // ------------------------------------------------------
@@ -308,7 +407,86 @@ void port_system_power_stop(){
   SCB->SCR &= ~((uint32_t)SCB_SCR_SLEEPDEEP_Msk); // Reset SLEEPDEEP bit of Cortex System Control Register
 }
 
+void port_system_stop(){
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq(); // The ISR of the wake-up source runs once the clock is restored
+  if ((irq_events != 0) || port_button_check_debouncing()){
+    // An ISR has run since the dispatcher took the events, or a button edge has masked its EXTI line and started the debounce timer, which is stopped in STOP mode: nothing would wake the system up
+    __set_PRIMASK(primask);
+    return;
+  }
+  port_system_systick_suspend();
+  port_system_power_stop();
+  stop_wake_cycles = DWT->CYCCNT;
+  system_clock_restore();
+  stop_count++;
+  port_system_systick_resume();
+  __set_PRIMASK(primask);
+}
+
+uint32_t port_system_get_stop_count(void){
+  return stop_count;
+}
+
+uint32_t port_system_get_stop_wake_cycles(void){
+  return stop_wake_cycles;
+}
+
 void port_system_sleep(){
+  port_system_sleep_for(PORT_SYSTEM_SLEEP_FOREVER);
+}
+
+uint32_t port_system_sleep_for(uint32_t max_ms){
+  if (max_ms == 0){
+    return 0;
+  }
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq(); // The ISR that wakes the system up must see the corrected msTicks
+  if (irq_events != 0){
+    // An ISR has run since the dispatcher took the events: its FSM must run before sleeping
+    __set_PRIMASK(primask);
+    return 0;
+  }
+
   port_system_systick_suspend();
+  port_system_update_cycles();
+  uint32_t cycles_before = cycles_last;
+  PORT_SYSTEM_WAKEUP_TIMER->CNT = 0;
+  PORT_SYSTEM_WAKEUP_TIMER->SR = 0;
+  if (max_ms <= PORT_SYSTEM_SLEEP_MAX_MS){
+    PORT_SYSTEM_WAKEUP_TIMER->ARR = (max_ms * PORT_SYSTEM_WAKEUP_TICKS_PER_MS) - 1;
+    PORT_SYSTEM_WAKEUP_TIMER->DIER = TIM_DIER_UIE;
+  }
+  else {
+    PORT_SYSTEM_WAKEUP_TIMER->ARR = UINT32_MAX; // Only measure the time slept
+    PORT_SYSTEM_WAKEUP_TIMER->DIER = 0;
+  }
+  PORT_SYSTEM_WAKEUP_TIMER->CR1 |= TIM_CR1_CEN;
+
   port_system_power_sleep();
+
+  // In one pulse mode the counter is reset and stopped at the update event
+  PORT_SYSTEM_WAKEUP_TIMER->CR1 &= ~TIM_CR1_CEN;
+  uint32_t ticks = (PORT_SYSTEM_WAKEUP_TIMER->SR & TIM_SR_UIF) ? (PORT_SYSTEM_WAKEUP_TIMER->ARR + 1) : PORT_SYSTEM_WAKEUP_TIMER->CNT;
+  PORT_SYSTEM_WAKEUP_TIMER->DIER = 0;
+  PORT_SYSTEM_WAKEUP_TIMER->SR = 0;
+  NVIC_ClearPendingIRQ(PORT_SYSTEM_WAKEUP_TIMER_IRQN);
+
+  // Add the cycles slept that the DWT counter has not counted, if it stops while the core sleeps
+  port_system_update_cycles();
+  uint32_t cycles_counted = cycles_last - cycles_before;
+  uint64_t cycles_timed = (uint64_t)ticks * (PORT_SYSTEM_WAKEUP_TIMER->PSC + 1);
+  if (cycles_timed > cycles_counted)
+  {
+    cycles_slept += cycles_timed - cycles_counted;
+  }
+
+  ticks += wakeup_remainder_ticks;
+  uint32_t slept_ms = ticks / PORT_SYSTEM_WAKEUP_TICKS_PER_MS;
+  wakeup_remainder_ticks = ticks % PORT_SYSTEM_WAKEUP_TICKS_PER_MS;
+  msTicks += slept_ms;
+
+  port_system_systick_resume();
+  __set_PRIMASK(primask);
+  return slept_ms;
 }
\ No newline at end of file
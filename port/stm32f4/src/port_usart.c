@@ -17,7 +17,7 @@
 /* Global variables */
 
 port_usart_hw_t usart_arr[] = {
-    [USART_0_ID] = {.p_usart = USART_0, .p_port_tx = USART_0_GPIO_TX, .p_port_rx = USART_0_GPIO_RX, .pin_tx= USART_0_PIN_TX, .pin_rx= USART_0_PIN_RX, .alt_func_tx = USART_0_AF_TX, .alt_func_rx = USART_0_AF_RX, .read_complete = false, .write_complete = false, .i_idx = 0, .o_idx = 0},
+    [USART_0_ID] = {.p_usart = USART_0, .p_port_tx = USART_0_GPIO_TX, .p_port_rx = USART_0_GPIO_RX, .pin_tx= USART_0_PIN_TX, .pin_rx= USART_0_PIN_RX, .alt_func_tx = USART_0_AF_TX, .alt_func_rx = USART_0_AF_RX, .read_complete = false, .write_complete = false, .i_idx = 0, .o_idx = 0, .o_length = 0, .isr_count = 0, .rx_end_cycles = 0},
 };
 
 /* Private functions */
@@ -105,6 +105,26 @@ void port_usart_reset_input_buffer(uint32_t usart_id){
 void port_usart_reset_output_buffer(uint32_t usart_id){
     _reset_buffer(usart_arr[usart_id].output_buffer, USART_OUTPUT_BUFFER_LENGTH);
     usart_arr[usart_id].write_complete = false;
+    usart_arr[usart_id].o_length = 0;
+}
+
+void port_usart_set_output_length(uint32_t usart_id, uint32_t length){
+    if (length > USART_OUTPUT_BUFFER_LENGTH){
+        length = USART_OUTPUT_BUFFER_LENGTH;
+    }
+    usart_arr[usart_id].o_length = length;
+}
+
+uint32_t port_usart_get_input_pending(uint32_t usart_id){
+    return usart_arr[usart_id].i_idx;
+}
+
+uint32_t port_usart_get_isr_count(uint32_t usart_id){
+    return usart_arr[usart_id].isr_count;
+}
+
+uint32_t port_usart_get_rx_timestamp(uint32_t usart_id){
+    return usart_arr[usart_id].rx_end_cycles;
 }
 
 bool port_usart_rx_done(uint32_t usart_id){
@@ -126,6 +146,7 @@ void port_usart_store_data(uint32_t usart_id){
         usart_arr[usart_id].i_idx++;
     }
     else {
+        usart_arr[usart_id].rx_end_cycles = port_system_get_cycles();
         usart_arr[usart_id].read_complete = true;
         usart_arr[usart_id].i_idx = 0;
     }
@@ -133,6 +154,17 @@ void port_usart_store_data(uint32_t usart_id){
 
 void port_usart_write_data(uint32_t	usart_id){
     char data = usart_arr[usart_id].output_buffer[usart_arr[usart_id].o_idx];
+    // Binary mode: send exactly o_length bytes, whatever their value
+    if (usart_arr[usart_id].o_length > 0){
+        usart_arr[usart_id].p_usart -> DR = data;
+        usart_arr[usart_id].o_idx++;
+        if (usart_arr[usart_id].o_idx >= usart_arr[usart_id].o_length){
+            port_usart_disable_tx_interrupt(usart_id);
+            usart_arr[usart_id].o_idx = 0;
+            usart_arr[usart_id].write_complete = true;
+        }
+        return;
+    }
     if ((usart_arr[usart_id].o_idx == USART_OUTPUT_BUFFER_LENGTH -1) || (data == END_CHAR_CONSTANT)){
         usart_arr[usart_id].p_usart  -> DR = data;
         port_usart_disable_tx_interrupt(usart_id);
@@ -144,6 +144,39 @@ void test_exti_priority(void) {
     TEST_ASSERT_EQUAL(0, pSubPriority);
 }
 
+void test_debounce_timer(void)
+{
+    port_button_init(BUTTON_0_ID);
+    UNITY_TEST_ASSERT(RCC->APB1ENR & RCC_APB1ENR_TIM4EN, __LINE__, "ERROR: The clock of the debounce timer is not enabled");
+    UNITY_TEST_ASSERT(PORT_BUTTON_DEBOUNCE_TIMER->CR1 & TIM_CR1_OPM, __LINE__, "ERROR: The debounce timer must be in one pulse mode");
+    UNITY_TEST_ASSERT(PORT_BUTTON_DEBOUNCE_TIMER->DIER & TIM_DIER_UIE, __LINE__, "ERROR: The update interrupt of the debounce timer is not enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32((SystemCoreClock / 1000) - 1, PORT_BUTTON_DEBOUNCE_TIMER->PSC, __LINE__, "ERROR: The debounce timer must count ms");
+    UNITY_TEST_ASSERT(!port_button_check_debouncing(), __LINE__, "ERROR: The debounce timer must not run after the initialization");
+
+    port_button_start_debounce(BUTTON_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(BUTTON_0_DEBOUNCE_TIME_MS - 1, PORT_BUTTON_DEBOUNCE_TIMER->ARR, __LINE__, "ERROR: The debounce timer must expire after the debounce time");
+    UNITY_TEST_ASSERT(port_button_check_debouncing(), __LINE__, "ERROR: The debounce timer must run during the debounce");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, (EXTI->IMR >> BUTTON_0_PIN) & 0x1, __LINE__, "ERROR: The EXTI line of the button must be masked during the debounce");
+
+    PORT_BUTTON_DEBOUNCE_TIMER->CR1 &= ~TIM_CR1_CEN;
+    port_button_end_debounce(BUTTON_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1, (EXTI->IMR >> BUTTON_0_PIN) & 0x1, __LINE__, "ERROR: The EXTI line of the button must be unmasked after the debounce");
+    UNITY_TEST_ASSERT(!buttons_arr[BUTTON_0_ID].debouncing, __LINE__, "ERROR: The debounce must be over");
+}
+
+void test_debounce_timer_priority(void)
+{
+    uint32_t Priority = NVIC_GetPriority(PORT_BUTTON_DEBOUNCE_TIMER_IRQN);
+    uint32_t PriorityGroup = NVIC_GetPriorityGrouping();
+    uint32_t pPreemptPriority;
+    uint32_t pSubPriority;
+
+    NVIC_DecodePriority(Priority, PriorityGroup, &pPreemptPriority, &pSubPriority);
+
+    TEST_ASSERT_EQUAL(1, pPreemptPriority);
+    TEST_ASSERT_EQUAL(0, pSubPriority);
+}
+
 int main(void)
 {
     port_system_init();
@@ -153,5 +186,7 @@ int main(void)
     RUN_TEST(test_regs);
     RUN_TEST(test_exti);
     RUN_TEST(test_exti_priority);
+    RUN_TEST(test_debounce_timer);
+    RUN_TEST(test_debounce_timer_priority);
     return UNITY_END();
 }
@@ -19,6 +19,7 @@
 #include "port_button.h"
 #include "port_usart.h"
 #include "port_buzzer.h"
+#include "port_dac.h"
 #include "port_system.h"
 #include "stm32f4xx.h"
 
@@ -28,6 +29,7 @@
 /* Private defines ------------------------------------------------------------*/
 #define BUZZER_TIM_DUR TIM2 /*!< BUZZER timer for note duration */
 #define BUZZER_TIM_PWM TIM3 /*!< BUZZER timer for PWM */
+#define PORT_BUZZER_EFFECT_PSC_TEST 1 /*!< Prescaler of the PWM timer of the notes of the effect tables with the HSI clock */
 
 /* Private variables ---------------------------------------------------------*/
 static char msg[200]; /*!< Buffer for the error messages */
@@ -290,6 +292,32 @@ void test_buzzer_set_note_duration()
     UNITY_TEST_ASSERT_EQUAL_UINT32(prev_tim_note_dur_cr1_masked, curr_tim_note_dur_cr1_masked, __LINE__, "ERROR: The register CR1 of the BUZZER timer for note duration has been modified for other bits than the needed");
 }
 
+/**
+ * @brief Test the rescaling of the note that is playing after a change of speed
+ *
+ */
+void test_buzzer_rescale_note_duration(void)
+{
+    port_buzzer_set_note_duration(BUZZER_0_ID, 1000);
+    uint32_t psc = BUZZER_TIM_DUR->PSC;
+    uint32_t arr = BUZZER_TIM_DUR->ARR;
+
+    // Half the speed: the period is doubled without restarting the note
+    port_buzzer_rescale_note_duration(BUZZER_0_ID, 2.0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(psc, BUZZER_TIM_DUR->PSC, __LINE__, "ERROR: The PSC of the BUZZER timer for note duration must not change when the note is rescaled");
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, 2 * (arr + 1) - 1, BUZZER_TIM_DUR->ARR, __LINE__, "ERROR: The ARR of the BUZZER timer for note duration must be scaled by the ratio");
+    UNITY_TEST_ASSERT(BUZZER_TIM_DUR->CNT <= BUZZER_TIM_DUR->ARR, __LINE__, "ERROR: The counter of the BUZZER timer for note duration must not pass ARR");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN_Msk | TIM_CR1_ARPE_Msk, BUZZER_TIM_DUR->CR1 & (TIM_CR1_CEN_Msk | TIM_CR1_ARPE_Msk), __LINE__, "ERROR: The BUZZER timer for note duration must be enabled and keep the preload of ARR after the rescaling");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(false, buzzers_arr[BUZZER_0_ID].note_end, __LINE__, "ERROR: The rescaling must not end the note");
+
+    // An ended note is not rescaled
+    buzzers_arr[BUZZER_0_ID].note_end = true;
+    arr = BUZZER_TIM_DUR->ARR;
+    port_buzzer_rescale_note_duration(BUZZER_0_ID, 0.5);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(arr, BUZZER_TIM_DUR->ARR, __LINE__, "ERROR: The ARR of the BUZZER timer for note duration must not change when the note has ended");
+    port_buzzer_stop(BUZZER_0_ID);
+}
+
 void _test_buzzer_set_note_frequency(double hz_test)
 {
     port_buzzer_set_note_frequency(BUZZER_0_ID, hz_test);
@@ -378,6 +406,154 @@ void test_buzzer_note_timeout(void)
     UNITY_TEST_ASSERT_EQUAL_UINT32(false, note_end, __LINE__, "ERROR: BUZZER note_end flag must be false for a buzzer_id different form 0");
 }
 
+/**
+ * @brief Test the envelope of the notes: the first duty cycle, the DMA stream that copies the rest to CCR1 and the timer that requests it every ms
+ *
+ */
+void test_buzzer_envelope(void)
+{
+    port_buzzer_init(BUZZER_0_ID);
+    port_buzzer_set_envelope(BUZZER_0_ID, true);
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 1000.0);
+
+    DMA_Stream_TypeDef *p_stream = PORT_BUZZER_ENVELOPE_DMA_STREAM;
+    uint32_t peak_ccr = (uint32_t)((BUZZER_TIM_PWM->ARR + 1) * BUZZER_PWM_DC);
+    uint32_t length = PORT_BUZZER_ENVELOPE_MS;
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, BUZZER_TIM_PWM->CCR1, __LINE__, "ERROR: The envelope must start with a duty cycle of 0");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DMA_SxCR_EN, p_stream->CR & DMA_SxCR_EN, __LINE__, "ERROR: The DMA stream of the envelope must be enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(length - 1, p_stream->NDTR, __LINE__, "ERROR: The DMA stream must copy a value per ms of the envelope but the first one, whatever the frequency of the note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)&BUZZER_TIM_PWM->CCR1, p_stream->PAR, __LINE__, "ERROR: The DMA stream of the envelope must write CCR1 of the PWM timer");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stream->CR & DMA_SxCR_CIRC, __LINE__, "ERROR: The envelope must be copied once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_DIER_UDE, PORT_BUZZER_ENVELOPE_TIMER->DIER & TIM_DIER_UDE, __LINE__, "ERROR: The update of the envelope timer must request the DMA stream");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, PORT_BUZZER_ENVELOPE_TIMER->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The envelope timer must be enabled during the envelope");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(SystemCoreClock / 1000, (PORT_BUZZER_ENVELOPE_TIMER->PSC + 1) * (PORT_BUZZER_ENVELOPE_TIMER->ARR + 1), __LINE__, "ERROR: The envelope timer must overflow every ms");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, BUZZER_TIM_PWM->DIER & TIM_DIER_UDE, __LINE__, "ERROR: The PWM timer must not request DMA transfers for the envelope");
+
+    // The values copied rise to the duty cycle of BUZZER_PWM_DC and end at the sustain level
+    const uint16_t *p_values = (const uint16_t *)(uintptr_t)p_stream->M0AR;
+    uint32_t max_ccr = 0;
+    for (uint32_t i = 0; i < length - 1; i++)
+    {
+        max_ccr = (p_values[i] > max_ccr) ? p_values[i] : max_ccr;
+    }
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, peak_ccr, max_ccr, __LINE__, "ERROR: The envelope must reach the duty cycle BUZZER_PWM_DC");
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, (uint32_t)(peak_ccr * PORT_BUZZER_ENVELOPE_SUSTAIN), p_values[length - 2], __LINE__, "ERROR: The envelope must end at the sustain level");
+
+    port_buzzer_stop(BUZZER_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stream->CR & DMA_SxCR_EN, __LINE__, "ERROR: The DMA stream of the envelope must be disabled after calling stop function");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, PORT_BUZZER_ENVELOPE_TIMER->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The envelope timer must be disabled after calling stop function");
+
+    // Without envelope the duty cycle is BUZZER_PWM_DC from the start
+    port_buzzer_set_envelope(BUZZER_0_ID, false);
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 1000.0);
+    UNITY_TEST_ASSERT_UINT32_WITHIN(1, peak_ccr, BUZZER_TIM_PWM->CCR1, __LINE__, "ERROR: Without envelope the duty cycle must be BUZZER_PWM_DC");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stream->CR & DMA_SxCR_EN, __LINE__, "ERROR: The DMA stream of the envelope must be disabled without envelope");
+    port_buzzer_stop(BUZZER_0_ID);
+}
+
+/**
+ * @brief Test the pitch effects of the notes: the ARR of a note of the tables, the vibrato in circular mode and the glide from the previous note
+ *
+ */
+void test_buzzer_effects(void)
+{
+    port_buzzer_init(BUZZER_0_ID);
+    DMA_Stream_TypeDef *p_stream = PORT_BUZZER_EFFECT_DMA_STREAM;
+    uint32_t la4_arr = (uint32_t)round((double)SystemCoreClock / (PORT_BUZZER_EFFECT_PSC_TEST + 1) / 440.0 - 1);
+
+    // Vibrato: a cycle of ARR values around the note, copied again and again
+    port_buzzer_set_effect(BUZZER_0_ID, PORT_BUZZER_EFFECT_VIBRATO);
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 440.0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(la4_arr, BUZZER_TIM_PWM->ARR, __LINE__, "ERROR: The ARR of a note of the effect tables is not correct");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_BUZZER_EFFECT_PSC_TEST, BUZZER_TIM_PWM->PSC, __LINE__, "ERROR: The PSC of a note of the effect tables is not correct");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DMA_SxCR_EN | DMA_SxCR_CIRC, p_stream->CR & (DMA_SxCR_EN | DMA_SxCR_CIRC), __LINE__, "ERROR: The vibrato must be copied by the DMA stream in circular mode");
+    UNITY_TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)&BUZZER_TIM_PWM->ARR, p_stream->PAR, __LINE__, "ERROR: The DMA stream of the effects must write ARR of the PWM timer");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, PORT_BUZZER_EFFECT_TIMER->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The effect timer must be enabled");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_DIER_UDE, PORT_BUZZER_EFFECT_TIMER->DIER & TIM_DIER_UDE, __LINE__, "ERROR: The update of the effect timer must request the DMA stream");
+    const uint16_t *p_values = (const uint16_t *)(uintptr_t)p_stream->M0AR;
+    uint32_t min_arr = 0xFFFF;
+    uint32_t max_arr = 0;
+    for (uint32_t i = 0; i < p_stream->NDTR; i++)
+    {
+        min_arr = (p_values[i] < min_arr) ? p_values[i] : min_arr;
+        max_arr = (p_values[i] > max_arr) ? p_values[i] : max_arr;
+    }
+    UNITY_TEST_ASSERT((min_arr < la4_arr) && (max_arr > la4_arr), __LINE__, "ERROR: The vibrato must go above and below the note");
+
+    // A note out of the tables has no effect
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 1000.0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stream->CR & DMA_SxCR_EN, __LINE__, "ERROR: A note out of the effect tables must not have effect");
+
+    // Glide: it starts at the previous note and ends at the new one
+    port_buzzer_set_effect(BUZZER_0_ID, PORT_BUZZER_EFFECT_GLIDE);
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 440.0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stream->CR & DMA_SxCR_EN, __LINE__, "ERROR: The first note must not glide");
+    port_buzzer_stop(BUZZER_0_ID);
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 523.251);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(la4_arr, BUZZER_TIM_PWM->ARR, __LINE__, "ERROR: A glide must start at the ARR of the previous note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stream->CR & DMA_SxCR_CIRC, __LINE__, "ERROR: A glide must be copied once");
+    p_values = (const uint16_t *)(uintptr_t)p_stream->M0AR;
+    uint32_t do5_arr = (uint32_t)round((double)SystemCoreClock / (PORT_BUZZER_EFFECT_PSC_TEST + 1) / 523.251 - 1);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(do5_arr, p_values[p_stream->NDTR - 1], __LINE__, "ERROR: A glide must end at the ARR of the new note");
+    UNITY_TEST_ASSERT(p_values[0] < la4_arr, __LINE__, "ERROR: A rising glide must decrease the ARR");
+
+    // A silence breaks the glide
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stream->CR & DMA_SxCR_EN, __LINE__, "ERROR: The DMA stream of the effects must be disabled during a silence");
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 440.0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stream->CR & DMA_SxCR_EN, __LINE__, "ERROR: A note after a silence must not glide");
+
+    port_buzzer_stop(BUZZER_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, PORT_BUZZER_EFFECT_TIMER->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The effect timer must be disabled after calling stop function");
+    port_buzzer_set_effect(BUZZER_0_ID, PORT_BUZZER_EFFECT_NONE);
+}
+
+void test_buzzer_dac_output(void)
+{
+    port_buzzer_init(BUZZER_0_ID);
+    port_buzzer_set_output(BUZZER_0_ID, PORT_BUZZER_OUTPUT_DAC);
+    DMA_Stream_TypeDef *p_stream = PORT_DAC_DMA_STREAM;
+
+    // Pin of the DAC as analog
+    UNITY_TEST_ASSERT_EQUAL_UINT32(GPIO_MODE_ANALOG, (PORT_DAC_GPIO->MODER >> (PORT_DAC_PIN * 2)) & 0x03, __LINE__, "ERROR: The pin of the DAC must be analog");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DAC_CR_EN1 | DAC_CR_TEN1 | DAC_CR_DMAEN1, DAC->CR & (DAC_CR_EN1 | DAC_CR_TEN1 | DAC_CR_DMAEN1 | DAC_CR_TSEL1), __LINE__, "ERROR: The channel 1 of the DAC must be enabled, triggered by TIM6 and with DMA requests");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR2_MMS_1, PORT_DAC_TIMER->CR2 & TIM_CR2_MMS, __LINE__, "ERROR: The update of the trigger timer must be its TRGO");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(SystemCoreClock / PORT_DAC_SAMPLE_RATE_HZ - 1, PORT_DAC_TIMER->ARR, __LINE__, "ERROR: The trigger timer must overflow at the sample rate");
+
+    // A note starts the double buffer on the DAC, and not the PWM
+    BUZZER_TIM_PWM->CR1 &= ~TIM_CR1_CEN;
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 440.0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, BUZZER_TIM_PWM->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The PWM timer must be disabled with the DAC output");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, PORT_DAC_TIMER->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The trigger timer must be enabled during a note");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(DMA_SxCR_EN | DMA_SxCR_CIRC | DMA_SxCR_HTIE | DMA_SxCR_TCIE, p_stream->CR & (DMA_SxCR_EN | DMA_SxCR_CIRC | DMA_SxCR_HTIE | DMA_SxCR_TCIE), __LINE__, "ERROR: The double buffer must be copied in circular mode with interrupts at each half");
+    UNITY_TEST_ASSERT_EQUAL_UINT32((uint32_t)(uintptr_t)&DAC->DHR12R1, p_stream->PAR, __LINE__, "ERROR: The DMA stream of the DAC must write DHR12R1");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(PORT_DAC_BUFFER_LENGTH, p_stream->NDTR, __LINE__, "ERROR: The DMA stream must copy the whole double buffer");
+    const uint16_t *p_samples = (const uint16_t *)(uintptr_t)p_stream->M0AR;
+    uint32_t min_sample = 0xFFFF;
+    uint32_t max_sample = 0;
+    for (uint32_t i = 0; i < PORT_DAC_BUFFER_LENGTH; i++)
+    {
+        min_sample = (p_samples[i] < min_sample) ? p_samples[i] : min_sample;
+        max_sample = (p_samples[i] > max_sample) ? p_samples[i] : max_sample;
+    }
+    UNITY_TEST_ASSERT((min_sample < 2048) && (max_sample > 2048) && (max_sample <= 4095), __LINE__, "ERROR: The double buffer must have a 12-bit wave around the midscale");
+
+    // A silence and the stop stop the DAC output
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, PORT_DAC_TIMER->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The trigger timer must be disabled during a silence");
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 440.0);
+    port_buzzer_stop(BUZZER_0_ID);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, PORT_DAC_TIMER->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The trigger timer must be disabled after calling stop function");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_stream->CR & DMA_SxCR_EN, __LINE__, "ERROR: The DMA stream of the DAC must be disabled after calling stop function");
+
+    // Back to the PWM output
+    port_buzzer_set_output(BUZZER_0_ID, PORT_BUZZER_OUTPUT_PWM);
+    port_buzzer_set_note_frequency(BUZZER_0_ID, 440.0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(TIM_CR1_CEN, BUZZER_TIM_PWM->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The PWM timer must be enabled with the PWM output");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, PORT_DAC_TIMER->CR1 & TIM_CR1_CEN, __LINE__, "ERROR: The trigger timer must be disabled with the PWM output");
+    port_buzzer_stop(BUZZER_0_ID);
+}
+
 void test_buzzer_stop(void)
 {
     // Enable BUZZER timer for note duration and PWM
@@ -417,7 +593,11 @@ int main(void)
     RUN_TEST(test_buzzer_timer_note_isr_priority);
     RUN_TEST(test_buzzer_timer_pwm_config);
     RUN_TEST(test_buzzer_set_note_duration);
+    RUN_TEST(test_buzzer_rescale_note_duration);
     RUN_TEST(test_buzzer_set_note_frequency);
+    RUN_TEST(test_buzzer_envelope);
+    RUN_TEST(test_buzzer_effects);
+    RUN_TEST(test_buzzer_dac_output);
     RUN_TEST(test_buzzer_note_timeout);
     RUN_TEST(test_buzzer_stop);
     return UNITY_END();
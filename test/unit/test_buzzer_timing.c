@@ -0,0 +1,136 @@
+/**
+ * @file test_buzzer_timing.c
+ * @brief Unit test of the timer values of the notes of the buzzer. It checks the PSC and ARR of some durations and frequencies, and bounds the pitch and timing errors of the notes of all the melodies.
+ *
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <math.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+
+/* Other libraries */
+#include "buzzer_timing.h"
+#include "melodies.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define TEST_CLOCK_HZ 16000000      /*!<Clock of the tests, the HSI*/
+#define TEST_MAX_CENTS 0.05         /*!<Maximum pitch error of the notes of the melodies at the clock of the tests*/
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Check the PSC and ARR of the timer of the note duration, and the truncation of the duration scaled by the speed.
+ *
+ */
+void test_buzzer_timing_duration(void)
+{
+    buzzer_timing_t timing;
+    buzzer_timing_get_duration(TEST_CLOCK_HZ, 1000, &timing);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(244, timing.psc, __LINE__, "Wrong PSC of a duration of 1 s: the ARR of the smallest prescaler does not fit");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(65305, timing.arr, __LINE__, "Wrong ARR of a duration of 1 s");
+    buzzer_timing_get_duration(TEST_CLOCK_HZ, 2, &timing);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, timing.psc, __LINE__, "Wrong PSC of a duration of 2 ms");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(31999, timing.arr, __LINE__, "Wrong ARR of a duration of 2 ms");
+
+    UNITY_TEST_ASSERT_EQUAL_UINT32(1000, buzzer_timing_get_scaled_duration(1000, 1.0), __LINE__, "Wrong duration at speed 1");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(588, buzzer_timing_get_scaled_duration(1000, 1.7), __LINE__, "The duration scaled by the speed must be truncated");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(4000, buzzer_timing_get_scaled_duration(400, 0.1), __LINE__, "Wrong duration at the lowest speed");
+}
+
+/**
+ * @brief Check the PSC and ARR of the PWM timer of some notes.
+ *
+ */
+void test_buzzer_timing_pwm(void)
+{
+    buzzer_timing_t timing;
+    buzzer_timing_get_pwm(TEST_CLOCK_HZ, 440.0, &timing);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, timing.psc, __LINE__, "Wrong PSC of LA4");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(36363, timing.arr, __LINE__, "Wrong ARR of LA4");
+    buzzer_timing_get_pwm(TEST_CLOCK_HZ, 100.0, &timing);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, timing.psc, __LINE__, "Wrong PSC of 100 Hz: the ARR of the smallest prescaler does not fit");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(53332, timing.arr, __LINE__, "Wrong ARR of 100 Hz");
+}
+
+/**
+ * @brief Bound the pitch error of every note of the melodies, and the timing error of every duration to a tick of the timer.
+ *
+ */
+void test_buzzer_timing_melodies(void)
+{
+    const melody_t *melodies[] = {&scale_melody, &inverse_scale_melody, &happy_birthday_melody, &tetris_melody, &avemaria_melody, &pp_hymn_melody};
+    for (uint32_t m = 0; m < sizeof(melodies) / sizeof(melodies[0]); m++)
+    {
+        for (uint32_t note = 0; note < melodies[m]->melody_length; note++)
+        {
+            buzzer_timing_t timing;
+            double frequency_hz = melodies[m]->p_notes[note];
+            if (frequency_hz != 0)
+            {
+                buzzer_timing_get_pwm(TEST_CLOCK_HZ, frequency_hz, &timing);
+                double played_hz = (double)TEST_CLOCK_HZ / ((double)(timing.psc + 1) * (timing.arr + 1));
+                UNITY_TEST_ASSERT(fabs(1200.0 * log2(played_hz / frequency_hz)) < TEST_MAX_CENTS, __LINE__, "The pitch error of a note is too large");
+            }
+            buzzer_timing_get_duration(TEST_CLOCK_HZ, melodies[m]->p_durations[note], &timing);
+            double error_cycles = (double)(timing.psc + 1) * (timing.arr + 1) - (double)TEST_CLOCK_HZ * melodies[m]->p_durations[note] / 1000;
+            UNITY_TEST_ASSERT(fabs(error_cycles) <= timing.psc + 1, __LINE__, "The timing error of a note is larger than a tick of the timer");
+        }
+    }
+}
+
+/**
+ * @brief Check the rescaling of a note that is playing: the remaining ticks are multiplied by the ratio and the counter never passes ARR.
+ *
+ */
+void test_buzzer_timing_rescale(void)
+{
+    // 1 s note at PSC 244, a quarter played, at half the speed
+    uint32_t arr = 65305;
+    uint32_t cnt = 16326;
+    buzzer_timing_rescale_duration(&arr, &cnt, 2.0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(130611, arr, __LINE__, "Wrong ARR of a note at half the speed: the period must be doubled, it may not fit in 16 bits");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(32652, cnt, __LINE__, "Wrong counter of a note at half the speed: the elapsed fraction must be kept");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2 * (65306 - 16326), arr + 1 - cnt, __LINE__, "The remaining ticks of the note must be doubled");
+
+    // Back to the original speed
+    buzzer_timing_rescale_duration(&arr, &cnt, 0.5);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(65305, arr, __LINE__, "Rescaling back must restore the ARR");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(16326, cnt, __LINE__, "Rescaling back must restore the counter");
+
+    // A note at its last tick never leaves the counter above ARR
+    arr = 9;
+    cnt = 9;
+    buzzer_timing_rescale_duration(&arr, &cnt, 0.34);
+    UNITY_TEST_ASSERT(cnt <= arr, __LINE__, "The counter must not pass ARR after rescaling");
+}
+
+/**
+ * @brief Main test function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_buzzer_timing_duration);
+    RUN_TEST(test_buzzer_timing_pwm);
+    RUN_TEST(test_buzzer_timing_melodies);
+    RUN_TEST(test_buzzer_timing_rescale);
+    return UNITY_END();
+}
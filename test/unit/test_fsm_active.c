@@ -0,0 +1,326 @@
+/**
+ * @file test_fsm_active.c
+ * @brief Unit test of the run-to-completion dispatcher of events for the FSMs.
+ *
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+
+/* Other libraries */
+#include "fsm_active.h"
+#include "fsm_trace.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define NUM_TEST_FSMS 3         /*!<Number of FSMs of the test*/
+#define LOG_LENGTH 32           /*!<Maximum number of fires logged*/
+#define IDLE_LOG_ID 99          /*!<Identifier written in the log when the low power mode is entered*/
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Test FSM: it toggles between states 0 and 1 every time its input is set.
+ *
+ */
+typedef struct
+{
+    fsm_t f;                /*!<FSM*/
+    uint32_t id;            /*!<Identifier written in the log*/
+    bool input;             /*!<Input of the FSM, set by the events*/
+    bool busy;              /*!<Value returned by the busy function*/
+    uint32_t fires;         /*!<Number of times the FSM has been fired*/
+    uint32_t polls;         /*!<Number of poll events received*/
+    fsm_event_t last_event; /*!<Last event received other than a poll*/
+} test_fsm_t;
+
+/* Global variables */
+static test_fsm_t fsms[NUM_TEST_FSMS];
+static uint32_t log_ids[LOG_LENGTH];    /*!<Identifiers of the FSMs in the order they have been fired*/
+static uint32_t log_length;
+
+/* Guards, outputs and callbacks of the test FSMs */
+static bool check_input(fsm_t *p_this) { return ((test_fsm_t *)p_this)->input; }
+static void do_consume(fsm_t *p_this) { ((test_fsm_t *)p_this)->input = false; }
+
+/**
+ * @brief Transitions of the test FSMs.
+ *
+ */
+static fsm_trans_t fsm_trans_test[] = {
+    { 0, check_input, 1, do_consume },
+    { 1, check_input, 0, do_consume },
+    { -1, NULL, -1, NULL }
+};
+
+/**
+ * @brief Fire a test FSM with the library and return the row fired, as a generated dispatch does.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @return int Position of the row fired. -1 if no guard is true.
+ */
+static int _test_fire(fsm_t *p_fsm)
+{
+    test_fsm_t *p_test = (test_fsm_t *)p_fsm;
+    int state = fsm_get_state(p_fsm);
+    p_test->fires++;
+    if (log_length < LOG_LENGTH)
+    {
+        log_ids[log_length++] = p_test->id;
+    }
+    for (int row = 0; fsm_trans_test[row].orig_state >= 0; row++)
+    {
+        if ((fsm_trans_test[row].orig_state == state) && fsm_trans_test[row].in(p_fsm))
+        {
+            fsm_set_state(p_fsm, fsm_trans_test[row].dest_state);
+            if (fsm_trans_test[row].out)
+            {
+                fsm_trans_test[row].out(p_fsm);
+            }
+            return row;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Event function of the test FSMs: any event other than a poll sets the input.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @param event Event received
+ */
+static void _test_on_event(fsm_t *p_fsm, fsm_event_t event)
+{
+    test_fsm_t *p_test = (test_fsm_t *)p_fsm;
+    if (event.signal == FSM_EVENT_POLL)
+    {
+        p_test->polls++;
+        return;
+    }
+    p_test->last_event = event;
+    p_test->input = true;
+}
+
+/**
+ * @brief Low power function of the test: it writes `IDLE_LOG_ID` in the log.
+ *
+ * @param p_fsm Pointer to the FSM that has requested the low power mode
+ */
+static void _test_idle(fsm_t *p_fsm)
+{
+    if (log_length < LOG_LENGTH)
+    {
+        log_ids[log_length++] = IDLE_LOG_ID;
+    }
+}
+
+/**
+ * @brief Busy function of the test FSMs.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @return true if the test sets the FSM busy
+ * @return false otherwise
+ */
+static bool _test_check_busy(fsm_t *p_fsm)
+{
+    return ((test_fsm_t *)p_fsm)->busy;
+}
+
+/**
+ * @brief Set the Up object. It is called before a test function is called.
+ *
+ * Three test FSMs are registered, in order of priority, and the fires of the registration are discarded.
+ */
+void setUp(void)
+{
+    fsm_active_reset();
+    port_system_take_irq_events();
+    memset(fsms, 0, sizeof(fsms));
+    for (uint32_t i = 0; i < NUM_TEST_FSMS; i++)
+    {
+        fsm_init(&fsms[i].f, fsm_trans_test);
+        fsms[i].id = i;
+        fsm_active_register(&fsms[i].f, _test_fire, _test_on_event, _test_check_busy, BIT_POS_TO_MASK(i), FSM_TRACE_ID_BUTTON + i);
+    }
+    fsm_active_dispatch();
+    for (uint32_t i = 0; i < NUM_TEST_FSMS; i++)
+    {
+        fsms[i].fires = 0;
+        fsms[i].polls = 0;
+    }
+    log_length = 0;
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+    fsm_active_reset();
+}
+
+/**
+ * @brief Test that an FSM without events and not busy is not fired, and that a busy FSM is fired on every dispatch.
+ *
+ */
+void test_active_idle_and_busy(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsm_active_dispatch(), __LINE__, "No event should be processed without events");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsms[0].fires + fsms[1].fires + fsms[2].fires, __LINE__, "An idle FSM should not be fired");
+
+    fsms[1].busy = true;
+    fsm_active_dispatch();
+    fsm_active_dispatch();
+    UNITY_TEST_ASSERT_EQUAL_INT(2, fsms[1].fires, __LINE__, "A busy FSM should be fired on every dispatch");
+    UNITY_TEST_ASSERT_EQUAL_INT(2, fsms[1].polls, __LINE__, "A busy FSM should receive poll events");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsms[0].fires + fsms[2].fires, __LINE__, "The other FSMs should not be fired");
+}
+
+/**
+ * @brief Test that the IRQ events are delivered to the FSMs of the peripheral, and that a change of state is followed by a second fire.
+ *
+ */
+void test_active_irq(void)
+{
+    port_system_post_irq_event(BIT_POS_TO_MASK(2));
+    UNITY_TEST_ASSERT_EQUAL_INT(2, fsm_active_dispatch(), __LINE__, "The IRQ event and the poll after the change of state should be processed");
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_EVENT_IRQ, fsms[2].last_event.signal, __LINE__, "The FSM of the peripheral should receive the IRQ event");
+    UNITY_TEST_ASSERT_EQUAL_INT(1, fsm_get_state(&fsms[2].f), __LINE__, "The FSM should have changed state");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsms[0].fires + fsms[1].fires, __LINE__, "The other FSMs should not be fired");
+}
+
+/**
+ * @brief Test that the events are processed in order of priority, also when an event is posted to an FSM of higher priority while a lower one runs.
+ *
+ */
+void test_active_priority(void)
+{
+    fsm_event_t event = {.signal = FSM_EVENT_CHANGED, .param = 7, .p_data = &fsms[0]};
+
+    fsm_active_listen(0, 2);
+    fsm_active_post(&fsms[2].f, event);
+    fsm_active_post(&fsms[1].f, event);
+    fsm_active_dispatch();
+
+    // 1 and its poll, then 2, then 0 (posted by 2) before the poll of 2
+    uint32_t expected[] = {1, 1, 2, 0, 0, 2};
+    UNITY_TEST_ASSERT_EQUAL_INT(6, log_length, __LINE__, "The number of fires is not correct");
+    for (uint32_t i = 0; i < 6; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_INT(expected[i], log_ids[i], __LINE__, "The FSMs have not been fired in order of priority");
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(7, fsms[1].last_event.param, __LINE__, "The parameter of the event is not correct");
+    UNITY_TEST_ASSERT_EQUAL_PTR(&fsms[0], fsms[1].last_event.p_data, __LINE__, "The pointer parameter of the event is not correct");
+}
+
+/**
+ * @brief Test that a full queue rejects the events and that a dispatch processes a bounded number of events.
+ *
+ */
+void test_active_bounds(void)
+{
+    fsm_event_t event = {.signal = FSM_EVENT_CHANGED, .param = 0};
+    uint32_t accepted = 0;
+
+    for (uint32_t i = 0; i < FSM_ACTIVE_QUEUE_SIZE + 2; i++)
+    {
+        accepted += fsm_active_post(&fsms[0].f, event);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_ACTIVE_QUEUE_SIZE, accepted, __LINE__, "A full queue should reject the events");
+
+    fsm_t unknown;
+    UNITY_TEST_ASSERT(!fsm_active_post(&unknown, event), __LINE__, "An event to an FSM not registered should be rejected");
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, fsm_active_get_priority(&unknown), __LINE__, "An FSM not registered should have no priority");
+    UNITY_TEST_ASSERT_EQUAL_INT(2, fsm_active_get_priority(&fsms[2].f), __LINE__, "The priority of an FSM should be its order of registration");
+
+    fsm_active_listen(1, 0);
+    fsm_active_listen(2, 0);
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_ACTIVE_MAX_EVENTS, fsm_active_dispatch(), __LINE__, "A dispatch should process at most FSM_ACTIVE_MAX_EVENTS events");
+    UNITY_TEST_ASSERT(fsm_active_dispatch() > 0, __LINE__, "The events left should be processed in the next dispatch");
+}
+
+/**
+ * @brief Test that the epoch of the inputs changes on every dispatch and after every event delivered or transition fired, but not while an FSM only reads its inputs.
+ *
+ */
+void test_active_epoch(void)
+{
+    uint32_t epoch = fsm_active_get_epoch();
+    UNITY_TEST_ASSERT_EQUAL_INT(epoch, fsm_active_get_epoch(), __LINE__, "The epoch should not change between dispatches");
+    fsm_active_dispatch();
+    UNITY_TEST_ASSERT_EQUAL_INT(epoch + 1, fsm_active_get_epoch(), __LINE__, "A dispatch without events should start a single epoch");
+
+    epoch = fsm_active_get_epoch();
+    fsm_active_post(&fsms[0].f, (fsm_event_t){.signal = FSM_EVENT_CHANGED, .param = 0});
+    fsm_active_dispatch();
+    // Start of the dispatch, the event and the transition, and the poll after the change of state
+    UNITY_TEST_ASSERT_EQUAL_INT(epoch + 4, fsm_active_get_epoch(), __LINE__, "The event and the transition should start new epochs");
+}
+
+/**
+ * @brief Test that the low power mode requested by an FSM is only entered at the end of the dispatch, once the FSMs of lower priority have processed their events.
+ *
+ */
+void test_active_idle_request(void)
+{
+    fsm_active_request_idle(&fsms[0].f, _test_idle);
+    fsm_active_post(&fsms[2].f, (fsm_event_t){.signal = FSM_EVENT_CHANGED});
+    fsm_active_dispatch();
+    // 2 and its poll after the change of state, then the low power mode
+    uint32_t expected[] = {2, 2, IDLE_LOG_ID};
+    UNITY_TEST_ASSERT_EQUAL_INT(3, log_length, __LINE__, "The number of fires and low power modes is not correct");
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_INT(expected[i], log_ids[i], __LINE__, "The low power mode should be entered after all the events");
+    }
+
+    log_length = 0;
+    fsm_active_dispatch();
+    UNITY_TEST_ASSERT_EQUAL_INT(0, log_length, __LINE__, "A request should only be served once");
+
+    // The dispatch ends with events pending
+    fsm_active_listen(1, 0);
+    for (uint32_t i = 0; i < FSM_ACTIVE_QUEUE_SIZE; i++)
+    {
+        fsm_active_post(&fsms[0].f, (fsm_event_t){.signal = FSM_EVENT_CHANGED});
+    }
+    fsm_active_request_idle(&fsms[0].f, _test_idle);
+    fsm_active_dispatch();
+    for (uint32_t i = 0; i < log_length; i++)
+    {
+        UNITY_TEST_ASSERT(log_ids[i] != IDLE_LOG_ID, __LINE__, "The low power mode should not be entered while events are pending");
+    }
+
+    fsm_t unknown;
+    log_length = 0;
+    fsm_active_request_idle(&unknown, _test_idle);
+    UNITY_TEST_ASSERT_EQUAL_INT(1, log_length, __LINE__, "The low power mode of an FSM not registered should be entered at once");
+}
+
+/**
+ * @brief Main test function. Read the terminal for instructions or notes.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_active_idle_and_busy);
+    RUN_TEST(test_active_irq);
+    RUN_TEST(test_active_priority);
+    RUN_TEST(test_active_bounds);
+    RUN_TEST(test_active_epoch);
+    RUN_TEST(test_active_idle_request);
+    return UNITY_END();
+}
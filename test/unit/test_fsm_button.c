@@ -23,8 +23,8 @@ void test_initial_config(void)
 
     UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, fsm_get_state(p_fsm), __LINE__, "The initial state of the FSM is not BUTTON_RELEASED");
 
-    // It assumes there are 4 transitions in the table plus the null transition
-    fsm_trans_t *last_transition = &p_inner_fsm->p_tt[4];
+    // It assumes there are 2 transitions in the table plus the null transition
+    fsm_trans_t *last_transition = &p_inner_fsm->p_tt[2];
 
     UNITY_TEST_ASSERT_EQUAL_INT(-1, last_transition->orig_state, __LINE__, "The origin state of the last transition of the FSM should be -1");
     UNITY_TEST_ASSERT_EQUAL_INT(NULL, last_transition->in, __LINE__, "The input condition function of the last transition of the FSM should be NULL");
@@ -37,29 +37,62 @@ void _test_button_press(uint32_t press_time)
     // First transition
     buttons_arr[BUTTON_0_ID].flag_pressed = true;
     fsm_fire(p_fsm);
-    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED_WAIT, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to BUTTON_PRESSED_WAIT after pressing the button");
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to BUTTON_PRESSED after pressing the button");
 
-    // Second transition
+    // No transition while the button is pressed
     port_system_delay_ms(press_time);
     fsm_fire(p_fsm);
-    if (press_time < BUTTON_0_DEBOUNCE_TIME_MS)
-    {
-        UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED_WAIT, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to BUTTON_RELEASED_WAIT after pressing the button for a short time");
-    }
-    else
-    {
-        UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to BUTTON_PRESSED after pressing the button for a long time");
-
-        // Third transition
-        buttons_arr[BUTTON_0_ID].flag_pressed = false;
-        fsm_fire(p_fsm);
-        UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED_WAIT, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to BUTTON_RELEASED_WAIT after releasing the button");
-
-        // Fourth transition
-        port_system_delay_ms(BUTTON_0_DEBOUNCE_TIME_MS+1);
-        fsm_fire(p_fsm);
-        UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to BUTTON_RELEASED after releasing the button");
-    }
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED, fsm_get_state(p_fsm), __LINE__, "The FSM did not stay in BUTTON_PRESSED while the button is pressed");
+
+    // Second transition
+    buttons_arr[BUTTON_0_ID].flag_pressed = false;
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to BUTTON_RELEASED after releasing the button");
+    UNITY_TEST_ASSERT_UINT32_WITHIN(2, press_time, fsm_button_get_duration(p_fsm), __LINE__, "The duration of the press is not correct");
+}
+
+void test_debounce_config(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_0_DEBOUNCE_TIME_MS, buttons_arr[BUTTON_0_ID].debounce_ms, __LINE__, "The debounce time of the FSM should be passed to the port layer");
+    UNITY_TEST_ASSERT(!buttons_arr[BUTTON_0_ID].debouncing, __LINE__, "The debounce should not be in progress after the initialization");
+    UNITY_TEST_ASSERT(!fsm_button_check_activity(p_fsm), __LINE__, "The FSM should be inactive in BUTTON_RELEASED");
+}
+
+void _push_edge(bool pressed, uint64_t timestamp_us)
+{
+    port_button_push_edge(BUTTON_0_ID, pressed);
+    buttons_arr[BUTTON_0_ID].edges[(buttons_arr[BUTTON_0_ID].edge_head - 1) & (PORT_BUTTON_EDGE_FIFO_SIZE - 1)].timestamp_us = timestamp_us;
+    buttons_arr[BUTTON_0_ID].flag_pressed = pressed;
+}
+
+void test_edge_timestamps(void)
+{
+    _push_edge(false, 500000);
+    _push_edge(true, 1000000); // The bounces are not stored, the port layer ignores them
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(1000000, ((fsm_button_t *)p_fsm)->time_pressed_us, __LINE__, "The press time should be the one of the press edge");
+    UNITY_TEST_ASSERT_EQUAL_INT(BUTTON_PRESSED, fsm_get_state(p_fsm), __LINE__, "The FSM did not change to BUTTON_PRESSED after pressing the button");
+
+    _push_edge(false, 2234567);
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(1234, fsm_button_get_duration(p_fsm), __LINE__, "The duration should be measured between the timestamps of the edges");
+}
+
+void test_held_duration(void)
+{
+    fsm_button_t *p_button = (fsm_button_t *)p_fsm;
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsm_button_get_held_duration(p_fsm), __LINE__, "The held duration should be 0 while the button is released");
+
+    buttons_arr[BUTTON_0_ID].flag_pressed = true;
+    fsm_fire(p_fsm);
+    p_button->time_pressed_us -= 1500000;
+    UNITY_TEST_ASSERT_EQUAL_INT(1500, fsm_button_get_held_duration(p_fsm), __LINE__, "The held duration should grow while the button is pressed");
+
+    fsm_button_reset_duration(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsm_button_get_held_duration(p_fsm), __LINE__, "A press already handled should not be held any more");
+    buttons_arr[BUTTON_0_ID].flag_pressed = false;
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsm_button_get_duration(p_fsm), __LINE__, "A press already handled should not report its duration on release");
 }
 
 void test_short_button_press(void)
@@ -78,6 +111,9 @@ int main(void)
     UNITY_BEGIN();
 
     RUN_TEST(test_initial_config);
+    RUN_TEST(test_debounce_config);
+    RUN_TEST(test_edge_timestamps);
+    RUN_TEST(test_held_duration);
     RUN_TEST(test_short_button_press);
     RUN_TEST(test_long_button_press);
 
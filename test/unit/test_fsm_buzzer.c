@@ -419,6 +419,88 @@ void test_auxiliary_functions(void)
     UNITY_TEST_ASSERT_EQUAL_INT(2, (uint32_t)(((fsm_buzzer_t *)p_fsm)->player_speed), __LINE__, "The speed has not been set correctly in the function fsm_buzzer_set_speed()");
 }
 
+/**
+ * @brief Test that the events of the dispatcher apply the changes of the player as the setters do, in the order they are received.
+ *
+ */
+void test_on_event(void)
+{
+    fsm_buzzer_t *p_buzzer = (fsm_buzzer_t *)p_fsm;
+
+    fsm_buzzer_on_event(p_fsm, (fsm_event_t){.signal = FSM_EVENT_MELODY, .p_data = &scale_melody});
+    UNITY_TEST_ASSERT_EQUAL_PTR(&scale_melody, p_buzzer->p_melody, __LINE__, "The melody has not been set by FSM_EVENT_MELODY");
+
+    fsm_buzzer_on_event(p_fsm, (fsm_event_t){.signal = FSM_EVENT_SPEED, .value = 1.5f});
+    UNITY_TEST_ASSERT_EQUAL_INT(150, (uint32_t)(p_buzzer->player_speed * 100), __LINE__, "The speed has not been set by FSM_EVENT_SPEED");
+
+    fsm_buzzer_on_event(p_fsm, (fsm_event_t){.signal = FSM_EVENT_ACTION, .param = PLAY});
+    p_buzzer->note_index = 3;
+    fsm_buzzer_on_event(p_fsm, (fsm_event_t){.signal = FSM_EVENT_ACTION, .param = STOP});
+    UNITY_TEST_ASSERT_EQUAL_INT(STOP, p_buzzer->user_action, __LINE__, "The last action received should be the action of the player");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, p_buzzer->note_index, __LINE__, "FSM_EVENT_ACTION with STOP should reset the note index as fsm_buzzer_set_action()");
+
+    fsm_buzzer_on_event(p_fsm, (fsm_event_t){.signal = FSM_EVENT_EFFECT, .param = PORT_BUZZER_EFFECT_VIBRATO});
+    UNITY_TEST_ASSERT_EQUAL_INT(PORT_BUZZER_EFFECT_VIBRATO, p_buzzer->effect, __LINE__, "The effect has not been set by FSM_EVENT_EFFECT");
+    fsm_buzzer_on_event(p_fsm, (fsm_event_t){.signal = FSM_EVENT_EFFECT, .param = PORT_BUZZER_EFFECT_NONE});
+
+    fsm_buzzer_on_event(p_fsm, (fsm_event_t){.signal = FSM_EVENT_IRQ});
+    UNITY_TEST_ASSERT_EQUAL_INT(STOP, p_buzzer->user_action, __LINE__, "An IRQ event should not change the player");
+}
+
+/**
+ * @brief Test the compiled melodies: the registers of a compiled note are those of the same note played from its frequency and duration, and a change of speed only rebuilds a few durations at each note.
+ *
+ */
+void test_compiled_melody(void)
+{
+    static buzzer_timing_note_t compiled[16];
+    fsm_buzzer_t *p_buzzer = (fsm_buzzer_t *)p_fsm;
+
+    // A melody longer than the buffer is not compiled
+    fsm_buzzer_set_compile_buffer(p_fsm, compiled, 4);
+    fsm_buzzer_set_melody(p_fsm, &scale_melody);
+    UNITY_TEST_ASSERT(!p_buzzer->compiled, __LINE__, "A melody longer than the scratch buffer must not be compiled");
+
+    // Registers of the second note played from its frequency and duration
+    fsm_buzzer_set_compile_buffer(p_fsm, NULL, 0);
+    fsm_buzzer_set_melody(p_fsm, &scale_melody);
+    fsm_set_state(p_fsm, PLAY_NOTE);
+    p_buzzer->note_index = 1;
+    p_buzzer->user_action = PLAY;
+    fsm_fire(p_fsm);
+    uint32_t pwm_arr = BUZZER_TIM_PWM->ARR;
+    uint32_t pwm_psc = BUZZER_TIM_PWM->PSC;
+    uint32_t pwm_ccr = BUZZER_TIM_PWM->CCR1;
+    uint32_t dur_arr = BUZZER_TIM_DUR->ARR;
+    uint32_t dur_psc = BUZZER_TIM_DUR->PSC;
+
+    // The same note from the compiled melody
+    fsm_buzzer_set_compile_buffer(p_fsm, compiled, 16);
+    fsm_buzzer_set_melody(p_fsm, &scale_melody);
+    UNITY_TEST_ASSERT(p_buzzer->compiled, __LINE__, "The melody must be compiled in the scratch buffer");
+    fsm_set_state(p_fsm, PLAY_NOTE);
+    p_buzzer->note_index = 1;
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(pwm_arr, BUZZER_TIM_PWM->ARR, __LINE__, "The ARR of the PWM timer of a compiled note is not the same");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(pwm_psc, BUZZER_TIM_PWM->PSC, __LINE__, "The PSC of the PWM timer of a compiled note is not the same");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(pwm_ccr, BUZZER_TIM_PWM->CCR1, __LINE__, "The CCR1 of the PWM timer of a compiled note is not the same");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(dur_arr, BUZZER_TIM_DUR->ARR, __LINE__, "The ARR of the duration timer of a compiled note is not the same");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(dur_psc, BUZZER_TIM_DUR->PSC, __LINE__, "The PSC of the duration timer of a compiled note is not the same");
+
+    // A change of speed rebuilds the durations from the next note, a few at each note
+    fsm_buzzer_set_speed(p_fsm, 2.0);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(0, p_buzzer->rebuild_count, __LINE__, "A change of speed must not rebuild the durations at once");
+    UNITY_TEST_ASSERT_EQUAL_UINT32(2, p_buzzer->rebuild_start, __LINE__, "The durations must be rebuilt from the next note");
+    uint16_t pwm_arr_next = compiled[2].pwm_arr;
+    fsm_set_state(p_fsm, PLAY_NOTE);
+    fsm_fire(p_fsm);
+    UNITY_TEST_ASSERT_EQUAL_UINT32(FSM_BUZZER_REBUILD_NOTES, p_buzzer->rebuild_count, __LINE__, "Each note must rebuild FSM_BUZZER_REBUILD_NOTES durations");
+    UNITY_TEST_ASSERT_EQUAL_UINT16(pwm_arr_next, compiled[2].pwm_arr, __LINE__, "A change of speed must not rebuild the pitch of the notes");
+    uint32_t tim_note_dur_ms = round((((double)(BUZZER_TIM_DUR->ARR) + 1.0) / ((double)SystemCoreClock / 1000.0)) * ((double)(BUZZER_TIM_DUR->PSC) + 1));
+    UNITY_TEST_ASSERT_INT_WITHIN(1, scale_melody.p_durations[2] / 2, tim_note_dur_ms, __LINE__, "The duration of the note after a change of speed is not correct");
+    fsm_buzzer_set_compile_buffer(p_fsm, NULL, 0);
+}
+
 /**
  * @brief Main test function. Read the terminal for instructions or notes.
  *
@@ -445,5 +527,7 @@ int main(void)
     RUN_TEST(test_resume_melody);
     RUN_TEST(test_restart_melody);
     RUN_TEST(test_auxiliary_functions);
+    RUN_TEST(test_on_event);
+    RUN_TEST(test_compiled_melody);
     return UNITY_END();
 }
@@ -0,0 +1,477 @@
+/**
+ * @file test_fsm_dispatch.c
+ * @brief Differential test of the switch-based dispatch generated by `tools/fsm_codegen.py`. Each FSM is fired on a random trace of events, and at every step the result of `fsm_fire()` on the transitions table (`fsm_hsm_fire()` for the hierarchical FSMs) is compared with the result of `fsm_xxx_fire()`. The CPU cycles of both engines are also measured per state of the Jukebox FSM.
+ *
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_button.h"
+#include "port_usart.h"
+#include "port_buzzer.h"
+#include "port_led.h"
+
+/* Other libraries */
+#include "fsm_button.h"
+#include "fsm_usart.h"
+#include "fsm_buzzer.h"
+#include "fsm_led.h"
+#include "fsm_jukebox.h"
+#include "fsm_telemetry.h"
+#include "fsm_gesture.h"
+#include "fsm_hsm.h"
+#include "melodies.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define NUM_STEPS 500               /*!<Number of steps of each random trace*/
+#define SNAPSHOT_SIZE 2048          /*!<Size in bytes of a snapshot of the FSMs and the port layer*/
+#define MAX_REGIONS 10              /*!<Maximum number of memory regions of a snapshot*/
+#define ON_OFF_PRESS_TIME_MS 1000   /*!<Button press time to turn the Jukebox ON or OFF, as in main.c*/
+#define NEXT_SONG_BUTTON_TIME_MS 500 /*!<Button press time to change to the next song, as in main.c*/
+#define CLICK_GAP_MS 300            /*!<Maximum time between clicks, as in main.c*/
+#define HOLD_TIME_MS 2000           /*!<Time to hold the button, as in main.c*/
+#define NUM_BENCHMARK_FIRES 1000    /*!<Number of fires per state to measure the CPU cycles*/
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Memory region that is saved and restored between the two engines.
+ *
+ */
+typedef struct
+{
+    void *p_data;   /*!<Start of the region*/
+    size_t size;    /*!<Size of the region in bytes*/
+    bool compared;  /*!<True if the region must be equal after both engines. The port layer is only restored, because the ISRs may update it at any time*/
+} region_t;
+
+/* External variables */
+extern fsm_trans_t fsm_trans_jukebox[];
+extern fsm_hsm_state_t fsm_states_jukebox[];
+
+/* Global variables */
+static fsm_t *p_fsm_button;
+static fsm_t *p_fsm_usart;
+static fsm_t *p_fsm_buzzer;
+static fsm_t *p_fsm_led0;
+static fsm_t *p_fsm_led1;
+static fsm_t *p_fsm_jukebox;
+static fsm_t *p_fsm_telemetry;
+static fsm_t *p_fsm_gesture;
+static uint32_t seed;
+static uint8_t snapshot_before[SNAPSHOT_SIZE];
+static uint8_t snapshot_linear[SNAPSHOT_SIZE];
+static uint8_t snapshot_dispatch[SNAPSHOT_SIZE];
+
+/* Private functions */
+/**
+ * @brief Get a pseudo-random number. The same seed gives the same trace on every run.
+ *
+ * @param max Upper bound (not included)
+ * @return uint32_t Random number lower than `max`
+ */
+static uint32_t _random(uint32_t max)
+{
+    seed = seed * 1103515245 + 12345;
+    return ((seed >> 16) & 0x7FFF) % max;
+}
+
+/**
+ * @brief Copy the regions into a snapshot.
+ *
+ * @param p_regions Array of regions
+ * @param num_regions Number of regions
+ * @param p_snapshot Pointer to the snapshot
+ */
+static void _save(const region_t *p_regions, uint32_t num_regions, uint8_t *p_snapshot)
+{
+    size_t offset = 0;
+    for (uint32_t i = 0; i < num_regions; i++)
+    {
+        memcpy(&p_snapshot[offset], p_regions[i].p_data, p_regions[i].size);
+        offset += p_regions[i].size;
+    }
+}
+
+/**
+ * @brief Copy a snapshot back into the regions.
+ *
+ * @param p_regions Array of regions
+ * @param num_regions Number of regions
+ * @param p_snapshot Pointer to the snapshot
+ */
+static void _restore(const region_t *p_regions, uint32_t num_regions, const uint8_t *p_snapshot)
+{
+    size_t offset = 0;
+    for (uint32_t i = 0; i < num_regions; i++)
+    {
+        memcpy(p_regions[i].p_data, &p_snapshot[offset], p_regions[i].size);
+        offset += p_regions[i].size;
+    }
+}
+
+/**
+ * @brief Reference engine of the Jukebox FSM, which is hierarchical.
+ *
+ * @param p_fsm Pointer to the FSM
+ */
+static void _fsm_hsm_fire_jukebox(fsm_t *p_fsm)
+{
+    fsm_hsm_fire(p_fsm, fsm_trans_jukebox, fsm_states_jukebox);
+}
+
+/**
+ * @brief Fire an FSM with both engines from the same snapshot and compare the results. The FSM is left as `fsm_xxx_fire()` left it.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @param p_reference Reference engine: `fsm_fire()`, or `fsm_hsm_fire()` for a hierarchical FSM
+ * @param p_fire Dispatch function of the FSM
+ * @param p_regions Array of regions with the state of the FSM and its environment
+ * @param num_regions Number of regions
+ * @param step Step of the trace, to report a failure
+ */
+static void _compare_engines(fsm_t *p_fsm, void (*p_reference)(fsm_t *), int (*p_fire)(fsm_t *), const region_t *p_regions, uint32_t num_regions, uint32_t step)
+{
+    char msg[80];
+    size_t size = 0;
+    for (uint32_t i = 0; i < num_regions; i++)
+    {
+        size += p_regions[i].size;
+    }
+    UNITY_TEST_ASSERT(size <= SNAPSHOT_SIZE, __LINE__, "The regions do not fit in a snapshot");
+
+    _save(p_regions, num_regions, snapshot_before);
+    p_reference(p_fsm);
+    _save(p_regions, num_regions, snapshot_linear);
+
+    _restore(p_regions, num_regions, snapshot_before);
+    int row = p_fire(p_fsm);
+    _save(p_regions, num_regions, snapshot_dispatch);
+
+    if ((row >= 0) && (p_fsm->p_tt[row].dest_state != FSM_HSM_INTERNAL))
+    {
+        sprintf(msg, "Step %lu: the row returned by the dispatch is not the row fired", (unsigned long)step);
+        UNITY_TEST_ASSERT_EQUAL_INT(p_fsm->p_tt[row].dest_state, fsm_get_state(p_fsm), __LINE__, msg);
+    }
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < num_regions; i++)
+    {
+        if (p_regions[i].compared)
+        {
+            sprintf(msg, "Step %lu: region %lu differs between the reference engine and the dispatch", (unsigned long)step, (unsigned long)i);
+            UNITY_TEST_ASSERT_EQUAL_MEMORY(&snapshot_linear[offset], &snapshot_dispatch[offset], p_regions[i].size, __LINE__, msg);
+        }
+        offset += p_regions[i].size;
+    }
+}
+
+/**
+ * @brief Set the Up object. It is called before a test function is called.
+ *
+ * The System tick is suspended so that time only advances when the trace says so.
+ */
+void setUp(void)
+{
+    seed = 2024;
+    p_fsm_button = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    p_fsm_usart = fsm_usart_new(USART_0_ID);
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    p_fsm_led0 = fsm_led_new(LED_0_ID);
+    p_fsm_led1 = fsm_led_new(LED_1_ID);
+    p_fsm_jukebox = fsm_jukebox_new(p_fsm_button, ON_OFF_PRESS_TIME_MS, p_fsm_usart, p_fsm_buzzer, NEXT_SONG_BUTTON_TIME_MS, p_fsm_led0, p_fsm_led1);
+    p_fsm_telemetry = fsm_telemetry_new(p_fsm_jukebox);
+    fsm_jukebox_set_telemetry(p_fsm_jukebox, p_fsm_telemetry);
+    p_fsm_gesture = fsm_gesture_new(&p_fsm_button, 1, CLICK_GAP_MS, HOLD_TIME_MS);
+    fsm_jukebox_set_gesture(p_fsm_jukebox, p_fsm_gesture);
+    port_system_systick_suspend();
+    port_system_set_millis(0);
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+    port_buzzer_stop(BUZZER_0_ID);
+    port_usart_disable_tx_interrupt(USART_0_ID);
+    port_system_systick_resume();
+    fsm_destroy(p_fsm_gesture);
+    fsm_destroy(p_fsm_telemetry);
+    fsm_destroy(p_fsm_jukebox);
+    fsm_destroy(p_fsm_led1);
+    fsm_destroy(p_fsm_led0);
+    fsm_destroy(p_fsm_buzzer);
+    fsm_destroy(p_fsm_usart);
+    fsm_destroy(p_fsm_button);
+}
+
+/**
+ * @brief Differential test of the button FSM: random presses, releases and time steps.
+ *
+ */
+void test_dispatch_button(void)
+{
+    region_t regions[] = {
+        {p_fsm_button, sizeof(fsm_button_t), true},
+        {&buttons_arr[BUTTON_0_ID], sizeof(port_button_hw_t), false},
+    };
+
+    for (uint32_t step = 0; step < NUM_STEPS; step++)
+    {
+        buttons_arr[BUTTON_0_ID].flag_pressed = _random(2);
+        port_system_set_millis(port_system_get_millis() + _random(2 * BUTTON_0_DEBOUNCE_TIME_MS));
+        _compare_engines(p_fsm_button, fsm_fire, fsm_button_fire, regions, 2, step);
+    }
+}
+
+/**
+ * @brief Differential test of the USART FSM: random receptions, messages to send and ends of transmission.
+ *
+ */
+void test_dispatch_usart(void)
+{
+    region_t regions[] = {
+        {p_fsm_usart, sizeof(fsm_usart_t), true},
+        {&usart_arr[USART_0_ID], sizeof(port_usart_hw_t), false},
+    };
+
+    for (uint32_t step = 0; step < NUM_STEPS; step++)
+    {
+        if (_random(4) == 0)
+        {
+            strcpy(usart_arr[USART_0_ID].input_buffer, "play");
+            usart_arr[USART_0_ID].read_complete = true;
+        }
+        if (_random(4) == 0)
+        {
+            // A single end char, so that the TX interrupt has nothing left to send
+            fsm_usart_set_out_data(p_fsm_usart, "\n");
+        }
+        usart_arr[USART_0_ID].write_complete = _random(2);
+        _compare_engines(p_fsm_usart, fsm_fire, fsm_usart_fire, regions, 2, step);
+        port_usart_disable_tx_interrupt(USART_0_ID);
+    }
+}
+
+/**
+ * @brief Differential test of the buzzer FSM: random user actions and ends of notes.
+ *
+ */
+void test_dispatch_buzzer(void)
+{
+    const uint8_t actions[] = {PLAY, PAUSE, STOP};
+    region_t regions[] = {
+        {p_fsm_buzzer, sizeof(fsm_buzzer_t), true},
+        {&buzzers_arr[BUZZER_0_ID], sizeof(port_buzzer_hw_t), false},
+    };
+
+    fsm_buzzer_set_melody(p_fsm_buzzer, &scale_melody);
+    for (uint32_t step = 0; step < NUM_STEPS; step++)
+    {
+        if (_random(8) == 0)
+        {
+            fsm_buzzer_set_action(p_fsm_buzzer, actions[_random(3)]);
+        }
+        buzzers_arr[BUZZER_0_ID].note_end = _random(2);
+        _compare_engines(p_fsm_buzzer, fsm_fire, fsm_buzzer_fire, regions, 2, step);
+        port_buzzer_stop(BUZZER_0_ID);
+    }
+}
+
+/**
+ * @brief Differential test of the LED FSM: random actions of the player and notes of the buzzer, in both modes of the visualizer.
+ *
+ */
+void test_dispatch_led(void)
+{
+    const double notes[] = {SILENCE, 100.0, LA3, LA4, LA5, 5000.0};
+    fsm_buzzer_t *p_buzzer = (fsm_buzzer_t *)p_fsm_buzzer;
+    region_t regions[] = {
+        {p_fsm_led0, sizeof(fsm_led_t), true},
+        {&leds_arr[LED_0_ID], sizeof(port_led_hw_t), true},
+    };
+
+    for (uint32_t step = 0; step < NUM_STEPS; step++)
+    {
+        if (_random(16) == 0)
+        {
+            fsm_led_set_visualizer(p_fsm_led0, _random(4) ? p_fsm_buzzer : NULL, _random(2) ? LED_MODE_PITCH : LED_MODE_PULSE);
+        }
+        p_buzzer->user_action = _random(4) ? PLAY : _random(2) ? PAUSE : STOP;
+        if (_random(2) == 0)
+        {
+            p_buzzer->note_count++;
+            p_buzzer->note_freq = notes[_random(6)];
+        }
+        _compare_engines(p_fsm_led0, fsm_fire, fsm_led_fire, regions, 2, step);
+    }
+    fsm_led_set_visualizer(p_fsm_led0, NULL, LED_MODE_PULSE);
+    p_buzzer->user_action = STOP;
+}
+
+/**
+ * @brief Differential test of the Jukebox FSM: random button presses, commands and melody endings.
+ *
+ * The button FSM is released from time to time, so that the internal row of LOW_POWER is also fired when no element is active.
+ */
+void test_dispatch_jukebox(void)
+{
+    const char *commands[] = {"play", "stop", "pause", "next", "info", "speed 2", "select 1", "select 3"};
+    const uint32_t durations[] = {0, NEXT_SONG_BUTTON_TIME_MS + 100, ON_OFF_PRESS_TIME_MS + 100};
+    fsm_usart_t *p_usart = (fsm_usart_t *)p_fsm_usart;
+    fsm_buzzer_t *p_buzzer = (fsm_buzzer_t *)p_fsm_buzzer;
+    region_t regions[] = {
+        {p_fsm_jukebox, sizeof(fsm_jukebox_t), true},
+        {p_fsm_button, sizeof(fsm_button_t), true},
+        {p_fsm_usart, sizeof(fsm_usart_t), true},
+        {p_fsm_buzzer, sizeof(fsm_buzzer_t), true},
+        {p_fsm_led0, sizeof(fsm_led_t), true},
+        {p_fsm_led1, sizeof(fsm_led_t), true},
+        {p_fsm_telemetry, sizeof(fsm_telemetry_t), true},
+        {p_fsm_gesture, sizeof(fsm_gesture_t), true},
+    };
+
+    for (uint32_t step = 0; step < NUM_STEPS; step++)
+    {
+        fsm_set_state(p_fsm_button, _random(4) ? BUTTON_PRESSED : BUTTON_RELEASED);
+        ((fsm_gesture_t *)p_fsm_gesture)->gesture = _random(4) ? GESTURE_NONE : GESTURE_DOUBLE_CLICK;
+        ((fsm_button_t *)p_fsm_button)->duration = durations[_random(3)];
+        if (_random(3) == 0)
+        {
+            strcpy(p_usart->in_data, commands[_random(8)]);
+            p_usart->data_received = true;
+        }
+        if (_random(4) == 0)
+        {
+            fsm_set_state(p_fsm_buzzer, _random(2) ? WAIT_START : WAIT_NOTE);
+            p_buzzer->user_action = _random(2) ? STOP : PLAY;
+        }
+        // The inputs have been changed outside the dispatcher
+        fsm_jukebox_invalidate_inputs(p_fsm_jukebox);
+        _compare_engines(p_fsm_jukebox, _fsm_hsm_fire_jukebox, fsm_jukebox_fire, regions, 8, step);
+        port_buzzer_stop(BUZZER_0_ID);
+    }
+}
+
+/**
+ * @brief Differential test of the telemetry FSM: random subscriptions, time steps and busy USART.
+ *
+ */
+void test_dispatch_telemetry(void)
+{
+    fsm_usart_t *p_usart = (fsm_usart_t *)p_fsm_usart;
+    region_t regions[] = {
+        {p_fsm_telemetry, sizeof(fsm_telemetry_t), true},
+        {p_fsm_usart, sizeof(fsm_usart_t), true},
+    };
+
+    for (uint32_t step = 0; step < NUM_STEPS; step++)
+    {
+        if (_random(16) == 0)
+        {
+            fsm_telemetry_set_period(p_fsm_telemetry, _random(2) * TELEMETRY_MIN_PERIOD_MS);
+        }
+        if (_random(2) == 0)
+        {
+            // The frame has been sent
+            memset(p_usart->out_data, EMPTY_BUFFER_CONSTANT, USART_OUTPUT_BUFFER_LENGTH);
+        }
+        port_system_set_millis(port_system_get_millis() + _random(TELEMETRY_MIN_PERIOD_MS));
+        _compare_engines(p_fsm_telemetry, fsm_fire, fsm_telemetry_fire, regions, 2, step);
+    }
+}
+
+/**
+ * @brief Differential test of the gesture FSM: random presses and releases of the button and time steps.
+ *
+ */
+void test_dispatch_gesture(void)
+{
+    region_t regions[] = {
+        {p_fsm_gesture, sizeof(fsm_gesture_t), true},
+    };
+
+    for (uint32_t step = 0; step < NUM_STEPS; step++)
+    {
+        fsm_set_state(p_fsm_button, _random(2) ? BUTTON_PRESSED : BUTTON_RELEASED);
+        port_system_set_millis(port_system_get_millis() + _random(2 * CLICK_GAP_MS));
+        _compare_engines(p_fsm_gesture, fsm_fire, fsm_gesture_fire, regions, 1, step);
+    }
+}
+
+/**
+ * @brief Benchmark of `fsm_hsm_fire()` against the generated `fsm_jukebox_fire()` per state of the Jukebox FSM. The results are printed in the terminal.
+ *
+ * The elements are left active and without input, so no guard is true: every fire checks all the rows of the state and its superstates, which is the common case in the main loop. The snapshot of the inputs is taken again on each fire, as in each pass of the dispatcher.
+ */
+void test_dispatch_benchmark(void)
+{
+    fsm_buzzer_t *p_buzzer = (fsm_buzzer_t *)p_fsm_buzzer;
+    const int states[] = {OFF, START_UP, WAIT_COMMAND, SHUT_DOWN};
+    uint32_t total_reference = 0;
+    uint32_t total_dispatch = 0;
+
+    // The buzzer is playing, so the Jukebox does not sleep
+    fsm_set_state(p_fsm_buzzer, PLAY_NOTE);
+    p_buzzer->user_action = PLAY;
+
+    printf("State | fsm_hsm_fire() cycles | fsm_jukebox_fire() cycles\n");
+    for (uint32_t i = 0; i < sizeof(states) / sizeof(states[0]); i++)
+    {
+        fsm_set_state(p_fsm_jukebox, states[i]);
+        uint32_t start = port_system_get_cycles();
+        for (uint32_t j = 0; j < NUM_BENCHMARK_FIRES; j++)
+        {
+            fsm_jukebox_invalidate_inputs(p_fsm_jukebox);
+            _fsm_hsm_fire_jukebox(p_fsm_jukebox);
+        }
+        uint32_t cycles_reference = (port_system_get_cycles() - start) / NUM_BENCHMARK_FIRES;
+        UNITY_TEST_ASSERT_EQUAL_INT(states[i], fsm_get_state(p_fsm_jukebox), __LINE__, "The benchmark FSM left its state with fsm_hsm_fire()");
+
+        start = port_system_get_cycles();
+        for (uint32_t j = 0; j < NUM_BENCHMARK_FIRES; j++)
+        {
+            fsm_jukebox_invalidate_inputs(p_fsm_jukebox);
+            fsm_jukebox_fire(p_fsm_jukebox);
+        }
+        uint32_t cycles_dispatch = (port_system_get_cycles() - start) / NUM_BENCHMARK_FIRES;
+        UNITY_TEST_ASSERT_EQUAL_INT(states[i], fsm_get_state(p_fsm_jukebox), __LINE__, "The benchmark FSM left its state with the dispatch");
+
+        printf("%5d | %21lu | %25lu\n", states[i], (unsigned long)cycles_reference, (unsigned long)cycles_dispatch);
+        total_reference += cycles_reference;
+        total_dispatch += cycles_dispatch;
+    }
+    UNITY_TEST_ASSERT(total_dispatch <= total_reference, __LINE__, "The generated dispatch should not need more cycles than fsm_hsm_fire()");
+}
+
+/**
+ * @brief Main test function. Read the terminal for instructions or notes.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_dispatch_button);
+    RUN_TEST(test_dispatch_usart);
+    RUN_TEST(test_dispatch_buzzer);
+    RUN_TEST(test_dispatch_led);
+    RUN_TEST(test_dispatch_jukebox);
+    RUN_TEST(test_dispatch_telemetry);
+    RUN_TEST(test_dispatch_gesture);
+    RUN_TEST(test_dispatch_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,184 @@
+/**
+ * @file test_fsm_gesture.c
+ * @brief Unit test of the gesture FSM: multi-clicks, press-and-hold and chords of several buttons.
+ *
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_button.h"
+
+/* Other libraries */
+#include "fsm_button.h"
+#include "fsm_gesture.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define NUM_TEST_BUTTONS 2      /*!<Number of buttons of the test*/
+#define CLICK_GAP_MS 300        /*!<Maximum time between clicks*/
+#define HOLD_TIME_MS 2000       /*!<Time to hold a button*/
+
+/* Global variables */
+static fsm_t *p_fsm_buttons[NUM_TEST_BUTTONS];
+static fsm_t *p_fsm_gesture;
+
+/**
+ * @brief Set the buttons pressed, advance the time and fire the gesture FSM. The states of the button FSMs are set directly: their presses are tested in `test_fsm_button.c`.
+ *
+ * @param mask Mask of the buttons pressed
+ * @param ms Time in ms to advance before the fire
+ */
+static void _step(uint32_t mask, uint32_t ms)
+{
+    for (uint32_t i = 0; i < NUM_TEST_BUTTONS; i++)
+    {
+        fsm_set_state(p_fsm_buttons[i], (mask & BIT_POS_TO_MASK(i)) ? BUTTON_PRESSED : BUTTON_RELEASED);
+    }
+    port_system_set_millis(port_system_get_millis() + ms);
+    fsm_gesture_on_event(p_fsm_gesture, (fsm_event_t){.signal = FSM_EVENT_CHANGED, .param = 0});
+    fsm_gesture_fire(p_fsm_gesture);
+}
+
+/**
+ * @brief Set the Up object. It is called before a test function is called.
+ *
+ * The System tick is suspended so that time only advances when the test says so.
+ */
+void setUp(void)
+{
+    for (uint32_t i = 0; i < NUM_TEST_BUTTONS; i++)
+    {
+        p_fsm_buttons[i] = fsm_button_new(BUTTON_0_DEBOUNCE_TIME_MS, BUTTON_0_ID);
+    }
+    p_fsm_gesture = fsm_gesture_new(p_fsm_buttons, NUM_TEST_BUTTONS, CLICK_GAP_MS, HOLD_TIME_MS);
+    port_system_gpio_exti_disable(BUTTON_0_PIN); // Disable EXTI to avoid unwanted interrupts
+    port_system_systick_suspend();
+    port_system_set_millis(0);
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+    port_system_systick_resume();
+    fsm_destroy(p_fsm_gesture);
+    for (uint32_t i = 0; i < NUM_TEST_BUTTONS; i++)
+    {
+        fsm_destroy(p_fsm_buttons[i]);
+    }
+}
+
+/**
+ * @brief Test that a single click is reported after the click gap, a double click after its gap, and a triple click as soon as it ends.
+ *
+ */
+void test_gesture_clicks(void)
+{
+    uint32_t buttons;
+    _step(0x1, 0);
+    _step(0x0, 100);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_NONE, fsm_gesture_get(p_fsm_gesture, NULL), __LINE__, "A click should not be reported before the click gap");
+    _step(0x0, CLICK_GAP_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_SINGLE_CLICK, fsm_gesture_get(p_fsm_gesture, &buttons), __LINE__, "A single click should be reported after the click gap");
+    UNITY_TEST_ASSERT_EQUAL_INT(0x1, buttons, __LINE__, "The buttons of the gesture are not correct");
+
+    fsm_gesture_clear(p_fsm_gesture);
+    _step(0x2, 0);
+    _step(0x0, 100);
+    _step(0x2, 100);
+    _step(0x0, 100);
+    _step(0x0, CLICK_GAP_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_DOUBLE_CLICK, fsm_gesture_get(p_fsm_gesture, &buttons), __LINE__, "A double click should be reported after the click gap");
+    UNITY_TEST_ASSERT_EQUAL_INT(0x2, buttons, __LINE__, "The buttons of the gesture are not correct");
+
+    fsm_gesture_clear(p_fsm_gesture);
+    for (uint32_t i = 0; i < FSM_GESTURE_MAX_CLICKS; i++)
+    {
+        _step(0x1, 100);
+        _step(0x0, 100);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_TRIPLE_CLICK, fsm_gesture_get(p_fsm_gesture, NULL), __LINE__, "A triple click should be reported as soon as it ends");
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_IDLE, fsm_get_state(p_fsm_gesture), __LINE__, "The FSM should be idle after a triple click");
+}
+
+/**
+ * @brief Test that a click of other buttons ends the multi-click in progress.
+ *
+ */
+void test_gesture_other_buttons(void)
+{
+    _step(0x1, 0);
+    _step(0x0, 100);
+    _step(0x2, 100);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_SINGLE_CLICK, fsm_gesture_get(p_fsm_gesture, NULL), __LINE__, "The click of the first button should be reported");
+    _step(0x0, 100);
+    _step(0x0, CLICK_GAP_MS);
+    uint32_t buttons;
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_SINGLE_CLICK, fsm_gesture_get(p_fsm_gesture, &buttons), __LINE__, "The click of the second button should be reported");
+    UNITY_TEST_ASSERT_EQUAL_INT(0x2, buttons, __LINE__, "The buttons of the gesture are not correct");
+}
+
+/**
+ * @brief Test that a press-and-hold is reported while the button is held, and nothing else on its release.
+ *
+ */
+void test_gesture_hold(void)
+{
+    uint32_t deadline_ms;
+    _step(0x1, 0);
+    UNITY_TEST_ASSERT(fsm_gesture_get_deadline(p_fsm_gesture, &deadline_ms), __LINE__, "The FSM should have a deadline while a button is pressed");
+    UNITY_TEST_ASSERT_EQUAL_INT(HOLD_TIME_MS, deadline_ms, __LINE__, "The deadline should be the end of the hold time");
+    _step(0x1, HOLD_TIME_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_HOLD, fsm_gesture_get(p_fsm_gesture, NULL), __LINE__, "A press-and-hold should be reported before the release");
+    UNITY_TEST_ASSERT(!fsm_gesture_get_deadline(p_fsm_gesture, &deadline_ms), __LINE__, "The FSM should not have a deadline after a press-and-hold");
+
+    fsm_gesture_clear(p_fsm_gesture);
+    _step(0x0, 100);
+    _step(0x0, CLICK_GAP_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_NONE, fsm_gesture_get(p_fsm_gesture, NULL), __LINE__, "The release of a press-and-hold should not be reported");
+    UNITY_TEST_ASSERT(!fsm_gesture_check_activity(p_fsm_gesture), __LINE__, "The FSM should be inactive after the gesture");
+}
+
+/**
+ * @brief Test that the buttons pressed at the same time are reported as a chord, also when they are not pressed in the same fire, and that a chord is never a press-and-hold.
+ *
+ */
+void test_gesture_chord(void)
+{
+    uint32_t buttons;
+    _step(0x1, 0);
+    _step(0x3, 50);
+    _step(0x3, HOLD_TIME_MS);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_NONE, fsm_gesture_get(p_fsm_gesture, NULL), __LINE__, "A chord should not be a press-and-hold");
+    _step(0x2, 50);
+    _step(0x0, 50);
+    UNITY_TEST_ASSERT_EQUAL_INT(GESTURE_CHORD, fsm_gesture_get(p_fsm_gesture, &buttons), __LINE__, "A chord should be reported when all its buttons are released");
+    UNITY_TEST_ASSERT_EQUAL_INT(0x3, buttons, __LINE__, "The buttons of the chord are not correct");
+}
+
+/**
+ * @brief Main test function. Read the terminal for instructions or notes.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_gesture_clicks);
+    RUN_TEST(test_gesture_other_buttons);
+    RUN_TEST(test_gesture_hold);
+    RUN_TEST(test_gesture_chord);
+    return UNITY_END();
+}
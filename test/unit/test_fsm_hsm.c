@@ -0,0 +1,209 @@
+/**
+ * @file test_fsm_hsm.c
+ * @brief Unit test of the hierarchical state machines: order of the exit, output and entry actions, and rows inherited from the superstates.
+ *
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* Other libraries */
+#include "fsm_hsm.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define LOG_LENGTH 32   /*!<Maximum length of the log of actions*/
+
+/* Enums */
+/**
+ * @brief States of the test FSM. S1 and S are superstates:
+ *
+ * > S = { S1 = { S11, S12 }, S2 }, T
+ */
+enum TEST_HSM_STATES {
+    S11 = 0,    /*!<Leaf state of S1*/
+    S12,        /*!<Leaf state of S1*/
+    S2,         /*!<Leaf state of S*/
+    T,          /*!<Top-level leaf state*/
+    S1,         /*!<Superstate of S11 and S12*/
+    S           /*!<Top-level superstate of S1 and S2*/
+};
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Test FSM with one input per kind of event.
+ *
+ */
+typedef struct
+{
+    fsm_t f;            /*!<FSM*/
+    bool a;             /*!<Input a*/
+    bool b;             /*!<Input b*/
+    bool c;             /*!<Input c*/
+    bool d;             /*!<Input d*/
+} test_hsm_t;
+
+/* Global variables */
+static test_hsm_t hsm;
+static char log_actions[LOG_LENGTH];    /*!<Actions in the order they have been called: '-' and '+' followed by the state for exit and entry actions, 'o' for the outputs*/
+
+/* Guards, outputs, entry and exit actions of the test FSM */
+static bool check_a(fsm_t *p_this) { return ((test_hsm_t *)p_this)->a; }
+static bool check_b(fsm_t *p_this) { return ((test_hsm_t *)p_this)->b; }
+static bool check_c(fsm_t *p_this) { return ((test_hsm_t *)p_this)->c; }
+static bool check_d(fsm_t *p_this) { return ((test_hsm_t *)p_this)->d; }
+static void do_out(fsm_t *p_this) { strcat(log_actions, "o"); }
+static void entry_s11(fsm_t *p_this) { strcat(log_actions, "+a"); }
+static void exit_s11(fsm_t *p_this) { strcat(log_actions, "-a"); }
+static void entry_s12(fsm_t *p_this) { strcat(log_actions, "+b"); }
+static void exit_s12(fsm_t *p_this) { strcat(log_actions, "-b"); }
+static void entry_s2(fsm_t *p_this) { strcat(log_actions, "+c"); }
+static void exit_s2(fsm_t *p_this) { strcat(log_actions, "-c"); }
+static void entry_t(fsm_t *p_this) { strcat(log_actions, "+t"); }
+static void exit_t(fsm_t *p_this) { strcat(log_actions, "-t"); }
+static void entry_s1(fsm_t *p_this) { strcat(log_actions, "+1"); }
+static void exit_s1(fsm_t *p_this) { strcat(log_actions, "-1"); }
+static void entry_s(fsm_t *p_this) { strcat(log_actions, "+s"); }
+static void exit_s(fsm_t *p_this) { strcat(log_actions, "-s"); }
+
+/**
+ * @brief Hierarchy of states of the test FSM.
+ *
+ */
+static fsm_hsm_state_t fsm_states_test[] = {
+    { S11, S1, entry_s11, exit_s11 },
+    { S12, S1, entry_s12, exit_s12 },
+    { S2, S, entry_s2, exit_s2 },
+    { T, FSM_HSM_NO_PARENT, entry_t, exit_t },
+    { S1, S, entry_s1, exit_s1 },
+    { S, FSM_HSM_NO_PARENT, entry_s, exit_s },
+    { -1, -1, NULL, NULL }
+};
+
+/**
+ * @brief Transitions of the test FSM.
+ *
+ */
+static fsm_trans_t fsm_trans_test[] = {
+    { S11, check_a, S12, do_out },
+    { S11, check_d, S11, do_out },
+    { S12, check_a, S2, do_out },
+    { S1, check_b, T, do_out },
+    { S, check_c, FSM_HSM_INTERNAL, do_out },
+    { T, check_a, S11, do_out },
+    { -1, NULL, -1, NULL }
+};
+
+/**
+ * @brief Set the inputs of the test FSM and fire it.
+ *
+ * @param a Input a
+ * @param b Input b
+ * @param c Input c
+ * @param d Input d
+ * @return int Row fired
+ */
+static int _fire(bool a, bool b, bool c, bool d)
+{
+    hsm.a = a;
+    hsm.b = b;
+    hsm.c = c;
+    hsm.d = d;
+    log_actions[0] = '\0';
+    return fsm_hsm_fire(&hsm.f, fsm_trans_test, fsm_states_test);
+}
+
+/**
+ * @brief Set the Up object. It is called before a test function is called.
+ *
+ */
+void setUp(void)
+{
+    memset(&hsm, 0, sizeof(hsm));
+    fsm_init(&hsm.f, fsm_trans_test);
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Test that the exit actions are called up to the common ancestor, then the output, then the entry actions down to the destination.
+ *
+ */
+void test_hsm_transition_order(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_INT(0, _fire(true, false, false, false), __LINE__, "The row of the current state should be fired");
+    UNITY_TEST_ASSERT_EQUAL_STRING("-ao+b", log_actions, __LINE__, "A transition inside S1 should not leave or enter S1");
+    UNITY_TEST_ASSERT_EQUAL_INT(S12, fsm_get_state(&hsm.f), __LINE__, "The state should be S12");
+
+    UNITY_TEST_ASSERT_EQUAL_INT(2, _fire(true, false, false, false), __LINE__, "The row of the current state should be fired");
+    UNITY_TEST_ASSERT_EQUAL_STRING("-b-1o+c", log_actions, __LINE__, "A transition from S1 to S2 should leave S1 but not S");
+
+    fsm_set_state(&hsm.f, T);
+    UNITY_TEST_ASSERT_EQUAL_INT(5, _fire(true, false, false, false), __LINE__, "The row of the current state should be fired");
+    UNITY_TEST_ASSERT_EQUAL_STRING("-to+s+1+a", log_actions, __LINE__, "The superstates should be entered from the outermost");
+}
+
+/**
+ * @brief Test that the rows of the superstates are checked after the rows of the current state, and that a self transition runs no exit or entry action.
+ *
+ */
+void test_hsm_parent_rows(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_INT(3, _fire(false, true, false, false), __LINE__, "The row of the superstate S1 should be fired");
+    UNITY_TEST_ASSERT_EQUAL_STRING("-a-1-so+t", log_actions, __LINE__, "All the states of the branch should be left");
+    UNITY_TEST_ASSERT_EQUAL_INT(T, fsm_get_state(&hsm.f), __LINE__, "The state should be T");
+
+    fsm_set_state(&hsm.f, S11);
+    UNITY_TEST_ASSERT_EQUAL_INT(0, _fire(true, true, true, false), __LINE__, "The rows of the current state should be checked before the rows of its superstates");
+
+    fsm_set_state(&hsm.f, S11);
+    UNITY_TEST_ASSERT_EQUAL_INT(1, _fire(false, false, false, true), __LINE__, "The self transition should be fired");
+    UNITY_TEST_ASSERT_EQUAL_STRING("o", log_actions, __LINE__, "A self transition should only call the output");
+}
+
+/**
+ * @brief Test the internal transitions of a superstate, and that the rows of a superstate do not apply to the states outside it.
+ *
+ */
+void test_hsm_internal(void)
+{
+    fsm_set_state(&hsm.f, S12);
+    UNITY_TEST_ASSERT_EQUAL_INT(4, _fire(false, false, true, false), __LINE__, "The internal row of the superstate S should be fired");
+    UNITY_TEST_ASSERT_EQUAL_STRING("o", log_actions, __LINE__, "An internal transition should only call the output");
+    UNITY_TEST_ASSERT_EQUAL_INT(S12, fsm_get_state(&hsm.f), __LINE__, "An internal transition should not change the state");
+
+    fsm_set_state(&hsm.f, T);
+    UNITY_TEST_ASSERT_EQUAL_INT(-1, _fire(false, true, true, true), __LINE__, "The rows of S should not apply to T");
+    UNITY_TEST_ASSERT_EQUAL_STRING("", log_actions, __LINE__, "No action should be called");
+
+    UNITY_TEST_ASSERT(fsm_hsm_is_in(fsm_states_test, S12, S), __LINE__, "S12 should be in S");
+    UNITY_TEST_ASSERT(!fsm_hsm_is_in(fsm_states_test, T, S), __LINE__, "T should not be in S");
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_HSM_NO_PARENT, fsm_hsm_get_parent(fsm_states_test, 42), __LINE__, "A state not listed should be a top-level state");
+}
+
+/**
+ * @brief Main test function. Read the terminal for instructions or notes.
+ *
+ * @return int
+ */
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_hsm_transition_order);
+    RUN_TEST(test_hsm_parent_rows);
+    RUN_TEST(test_hsm_internal);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+/**
+ * @file test_fsm_led.c
+ * @brief Unit test of the LED FSM as a visualizer of the notes of the buzzer FSM.
+ *
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+#include "port_led.h"
+#include "port_buzzer.h"
+
+/* Other libraries */
+#include "fsm_led.h"
+#include "fsm_buzzer.h"
+#include "melodies.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Global variables */
+static fsm_t *p_fsm_led;
+static fsm_t *p_fsm_buzzer;
+
+/**
+ * @brief Start a note in the buzzer FSM, as its outputs do, and fire the LED FSM.
+ *
+ * @param freq Frequency of the note
+ */
+static void _start_note(double freq)
+{
+    fsm_buzzer_t *p_buzzer = (fsm_buzzer_t *)p_fsm_buzzer;
+    p_buzzer->note_freq = freq;
+    p_buzzer->note_count++;
+    fsm_led_fire(p_fsm_led);
+}
+
+/**
+ * @brief Count the slots of a PWM period of the visualizer that turn the LED on, from the memory address of the DMA stream of the LED.
+ *
+ * @return uint32_t Brightness of the period
+ */
+static uint32_t _get_period_level(void)
+{
+    const uint32_t *p_period = (const uint32_t *)(uintptr_t)leds_arr[LED_1_ID].p_dma_stream->M0AR;
+    uint32_t level = 0;
+    for (uint32_t i = 0; i < PORT_LED_VISUALIZER_MAX_LEVEL; i++)
+    {
+        if (p_period[i] == BIT_POS_TO_MASK(LED_1_PIN))
+        {
+            level++;
+        }
+    }
+    return level;
+}
+
+/**
+ * @brief Set the Up object. It is called before a test function is called.
+ *
+ */
+void setUp(void)
+{
+    p_fsm_buzzer = fsm_buzzer_new(BUZZER_0_ID);
+    p_fsm_led = fsm_led_new(LED_1_ID);
+    fsm_buzzer_set_action(p_fsm_buzzer, PLAY);
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+    port_led_visualizer_stop(LED_1_ID);
+    fsm_destroy(p_fsm_led);
+    fsm_destroy(p_fsm_buzzer);
+}
+
+/**
+ * @brief Test that the LED is off without a visualizer, and that the visualizer follows the player.
+ *
+ */
+void test_led_player(void)
+{
+    fsm_led_fire(p_fsm_led);
+    UNITY_TEST_ASSERT_EQUAL_INT(LED_OFF, fsm_get_state(p_fsm_led), __LINE__, "The LED should be off without a visualizer");
+
+    fsm_led_set_visualizer(p_fsm_led, p_fsm_buzzer, LED_MODE_PULSE);
+    fsm_led_fire(p_fsm_led);
+    UNITY_TEST_ASSERT_EQUAL_INT(LED_ON, fsm_get_state(p_fsm_led), __LINE__, "The LED should be on while the player plays");
+
+    fsm_buzzer_set_action(p_fsm_buzzer, PAUSE);
+    fsm_led_fire(p_fsm_led);
+    UNITY_TEST_ASSERT_EQUAL_INT(LED_OFF, fsm_get_state(p_fsm_led), __LINE__, "The LED should be off when the player is paused");
+    UNITY_TEST_ASSERT(!leds_arr[LED_1_ID].visualizer_on, __LINE__, "The DMA stream should be stopped with the LED off");
+    UNITY_TEST_ASSERT(!(PORT_LED_VISUALIZER_TIMER->CR1 & TIM_CR1_CEN), __LINE__, "The visualizer timer should be stopped when no LED uses it");
+}
+
+/**
+ * @brief Test that every note starts a pulse that fades out, played once by the DMA stream, and that a silence gives no pulse.
+ *
+ */
+void test_led_pulse(void)
+{
+    fsm_led_set_visualizer(p_fsm_led, p_fsm_buzzer, LED_MODE_PULSE);
+    fsm_led_fire(p_fsm_led);
+    _start_note(LA4);
+    UNITY_TEST_ASSERT(leds_arr[LED_1_ID].visualizer_on, __LINE__, "A note should start a pulse");
+    UNITY_TEST_ASSERT(!(leds_arr[LED_1_ID].p_dma_stream->CR & DMA_SxCR_CIRC), __LINE__, "A pulse should be played once");
+    UNITY_TEST_ASSERT_EQUAL_INT(PORT_LED_VISUALIZER_MAX_LEVEL, _get_period_level(), __LINE__, "A pulse should start at the maximum brightness");
+    UNITY_TEST_ASSERT(PORT_LED_VISUALIZER_TIMER->CR1 & TIM_CR1_CEN, __LINE__, "The visualizer timer should run");
+
+    _start_note(SILENCE);
+    UNITY_TEST_ASSERT(!leds_arr[LED_1_ID].visualizer_on, __LINE__, "A silence should not give a pulse");
+    UNITY_TEST_ASSERT_EQUAL_INT(LED_ON, fsm_get_state(p_fsm_led), __LINE__, "The LED FSM should stay on during a silence");
+}
+
+/**
+ * @brief Test that the brightness of the pitch mode grows with the pitch of the notes.
+ *
+ */
+void test_led_pitch(void)
+{
+    fsm_led_set_visualizer(p_fsm_led, p_fsm_buzzer, LED_MODE_PITCH);
+    fsm_led_fire(p_fsm_led);
+    _start_note(FSM_LED_PITCH_MIN_HZ);
+    UNITY_TEST_ASSERT(leds_arr[LED_1_ID].p_dma_stream->CR & DMA_SxCR_CIRC, __LINE__, "A brightness should be kept by a circular DMA stream");
+    UNITY_TEST_ASSERT_EQUAL_INT(1, _get_period_level(), __LINE__, "The lowest note should be the dimmest");
+
+    _start_note(LA4);
+    uint32_t level = _get_period_level();
+    UNITY_TEST_ASSERT((level > 1) && (level < PORT_LED_VISUALIZER_MAX_LEVEL), __LINE__, "A middle note should have a middle brightness");
+
+    _start_note(FSM_LED_PITCH_MIN_HZ * 16);
+    UNITY_TEST_ASSERT_EQUAL_INT(PORT_LED_VISUALIZER_MAX_LEVEL, _get_period_level(), __LINE__, "The highest note should be the brightest");
+
+    _start_note(SILENCE);
+    UNITY_TEST_ASSERT_EQUAL_INT(0, _get_period_level(), __LINE__, "A silence should turn the LED off");
+}
+
+/**
+ * @brief Main test function. Read the terminal for instructions or notes.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_led_player);
+    RUN_TEST(test_led_pulse);
+    RUN_TEST(test_led_pitch);
+    return UNITY_END();
+}
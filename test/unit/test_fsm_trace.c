@@ -0,0 +1,201 @@
+/**
+ * @file test_fsm_trace.c
+ * @brief Unit test of the ring buffer of FSM transitions.
+ *
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <stdio.h>
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+
+/* Other libraries */
+#include "fsm_trace.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Global variables */
+static bool input;      /*!<Value of the guard of the test table*/
+
+/* Guards and outputs of the test table */
+static bool check_input(fsm_t *p_this) { return input; }
+static bool check_true(fsm_t *p_this) { return true; }
+
+/**
+ * @brief Table with a transition between two states and a self-transition that fires on every call.
+ *
+ */
+static fsm_trans_t fsm_trans_test[] = {
+    { 0, check_input, 1, NULL },
+    { 1, check_input, 0, NULL },
+    { 1, check_true, 1, NULL },
+    { -1, NULL, -1, NULL }
+};
+
+/**
+ * @brief Fire the test FSM with the linear scan of the library and return the row fired, as a generated dispatch does.
+ *
+ * @param p_fsm Pointer to the FSM
+ * @return int Position of the row fired. -1 if no guard is true.
+ */
+static int _test_fire(fsm_t *p_fsm)
+{
+    int state = fsm_get_state(p_fsm);
+    for (int row = 0; fsm_trans_test[row].orig_state >= 0; row++)
+    {
+        if ((fsm_trans_test[row].orig_state == state) && fsm_trans_test[row].in(p_fsm))
+        {
+            fsm_set_state(p_fsm, fsm_trans_test[row].dest_state);
+            return row;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Fire the test FSM and record the transition fired, if any, as the dispatcher of `fsm_active` does.
+ *
+ * @param p_fsm Pointer to the FSM
+ */
+static void _fire_and_record(fsm_t *p_fsm)
+{
+    int from = fsm_get_state(p_fsm);
+    int row = _test_fire(p_fsm);
+    if (row >= 0)
+    {
+        fsm_trace_record(FSM_TRACE_ID_JUKEBOX, from, fsm_get_state(p_fsm), row);
+    }
+}
+
+/**
+ * @brief Set the Up object. It is called before a test function is called.
+ *
+ */
+void setUp(void)
+{
+    input = false;
+    fsm_trace_reset();
+}
+
+/**
+ * @brief Tear down the test. It is called after a test function is called.
+ *
+ */
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Test that the transitions are recorded in order with their states and rows, and that the repeated self-transitions are recorded once.
+ *
+ */
+void test_trace_record(void)
+{
+    fsm_t fsm;
+    fsm_trace_entry_t entry;
+
+    fsm_init(&fsm, fsm_trans_test);
+    _fire_and_record(&fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(0, fsm_trace_get_head(), __LINE__, "A fire without transition should not be recorded");
+
+    input = true;
+    _fire_and_record(&fsm);
+    input = false;
+    for (int i = 0; i < 10; i++)
+    {
+        _fire_and_record(&fsm);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(2, fsm_trace_get_head(), __LINE__, "A repeated self-transition should be recorded once");
+
+    UNITY_TEST_ASSERT(fsm_trace_get_entry(0, &entry), __LINE__, "The first transition should be in the ring");
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_TRACE_ID_JUKEBOX, entry.fsm_id, __LINE__, "The FSM of the transition is not correct");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, entry.from, __LINE__, "The origin state of the transition is not correct");
+    UNITY_TEST_ASSERT_EQUAL_INT(1, entry.to, __LINE__, "The destination state of the transition is not correct");
+    UNITY_TEST_ASSERT_EQUAL_INT(0, entry.row, __LINE__, "The row of the transition is not correct");
+
+    UNITY_TEST_ASSERT(fsm_trace_get_entry(1, &entry), __LINE__, "The second transition should be in the ring");
+    UNITY_TEST_ASSERT_EQUAL_INT(2, entry.row, __LINE__, "The row of the self-transition is not correct");
+    UNITY_TEST_ASSERT(!fsm_trace_get_entry(2, &entry), __LINE__, "A transition not recorded yet should not be in the ring");
+
+    // Another FSM does not hide the self-transition of this one
+    fsm_trace_record(FSM_TRACE_ID_BUTTON, 0, 1, 0);
+    _fire_and_record(&fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(3, fsm_trace_get_head(), __LINE__, "The self-transition of an FSM should only be compared with the last transition of the same FSM");
+    input = true;
+    _fire_and_record(&fsm);
+    input = false;
+    _fire_and_record(&fsm);
+    UNITY_TEST_ASSERT_EQUAL_INT(4, fsm_trace_get_head(), __LINE__, "A transition to another state should always be recorded");
+}
+
+/**
+ * @brief Test that the oldest transitions are overwritten when the ring is full.
+ *
+ */
+void test_trace_wrap(void)
+{
+    fsm_trace_entry_t entry;
+
+    for (int i = 0; i < FSM_TRACE_SIZE + 5; i++)
+    {
+        fsm_trace_record(FSM_TRACE_ID_BUTTON, i % 2, (i + 1) % 2, i % 4);
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_TRACE_SIZE + 5, fsm_trace_get_head(), __LINE__, "The head should count all the transitions recorded");
+    UNITY_TEST_ASSERT(!fsm_trace_get_entry(4, &entry), __LINE__, "An overwritten transition should not be in the ring");
+    UNITY_TEST_ASSERT(fsm_trace_get_entry(5, &entry), __LINE__, "The oldest transition should be in the ring");
+    UNITY_TEST_ASSERT_EQUAL_INT(5 % 4, entry.row, __LINE__, "The oldest transition is not correct");
+    UNITY_TEST_ASSERT(fsm_trace_get_entry(FSM_TRACE_SIZE + 4, &entry), __LINE__, "The newest transition should be in the ring");
+    UNITY_TEST_ASSERT_EQUAL_INT((FSM_TRACE_SIZE + 4) % 4, entry.row, __LINE__, "The newest transition is not correct");
+}
+
+/**
+ * @brief Test the text of a dump, including a dump of overwritten transitions.
+ *
+ */
+void test_trace_dump(void)
+{
+    char text[FSM_TRACE_DUMP_LENGTH];
+    char expected[FSM_TRACE_DUMP_LENGTH];
+
+    port_system_systick_suspend();
+    port_system_set_millis(0x1234);
+    fsm_trace_record(FSM_TRACE_ID_TELEMETRY, 0, 1, 0);
+    fsm_trace_record(FSM_TRACE_ID_LED_1, 1, 0, 1);
+    port_system_systick_resume();
+
+    fsm_trace_dump(0, text);
+    UNITY_TEST_ASSERT_EQUAL_STRING("TRC00000000 00000002 00001234060001000000123405010001", text, __LINE__, "The dump is not correct");
+    fsm_trace_dump(2, text);
+    UNITY_TEST_ASSERT_EQUAL_STRING("TRC00000002 00000002 ", text, __LINE__, "The dump with no transitions is not correct");
+
+    for (int i = 0; i < FSM_TRACE_SIZE; i++)
+    {
+        fsm_trace_record(FSM_TRACE_ID_BUTTON, 0, 1, 0);
+    }
+    fsm_trace_dump(0, text);
+    UNITY_TEST_ASSERT_EQUAL_INT(FSM_TRACE_DUMP_LENGTH - 1, strlen(text), __LINE__, "A full dump should fill its length");
+    sprintf(expected, "TRC%08X %08X ", 2, FSM_TRACE_SIZE + 2);
+    UNITY_TEST_ASSERT(strncmp(expected, text, strlen(expected)) == 0, __LINE__, "A dump of overwritten transitions should start at the oldest one");
+}
+
+/**
+ * @brief Main test function. Read the terminal for instructions or notes.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_trace_record);
+    RUN_TEST(test_trace_wrap);
+    RUN_TEST(test_trace_dump);
+    return UNITY_END();
+}
@@ -0,0 +1,204 @@
+/**
+ * @file test_wavetable.c
+ * @brief Unit test of the wavetable oscillator of the DAC output. It checks the wavetable, the frequency and the interpolation of the oscillator, and bounds the CPU cycles of the fill.
+ *
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#include <string.h>
+
+/* HW dependent libraries */
+#include "port_system.h"
+
+/* Other libraries */
+#include "wavetable.h"
+
+/* Test dependencies */
+#include <unity.h>
+
+/* Defines ------------------------------------------------------------------*/
+#define TEST_SAMPLE_RATE_HZ 32000   /*!<Sample rate of the tests, as the DAC output*/
+#define TEST_BLOCK_LENGTH 128       /*!<Samples of a block, as half the buffer of the DAC output*/
+#define TEST_ODD_BLOCK_LENGTH 125   /*!<Samples of a block of odd length*/
+#define TEST_FREQUENCY_HZ 1000.0    /*!<Frequency of the tests of the period*/
+#define TEST_MAX_CPU_FRACTION 4     /*!<The fill of the DAC output may take at most 1/4 of the CPU*/
+
+/* Global variables */
+static int16_t table_sine[WAVETABLE_LENGTH];                                /*!<Wavetable of a sine*/
+static int16_t table_organ[WAVETABLE_LENGTH];                               /*!<Wavetable of the organ-like wave*/
+static uint16_t samples[TEST_SAMPLE_RATE_HZ] __attribute__((aligned(4)));  /*!<A second of samples*/
+
+/**
+ * @brief Fill the wavetables of the tests.
+ *
+ */
+void setUp(void)
+{
+    static const double harmonics_sine[] = WAVETABLE_HARMONICS_SINE;
+    static const double harmonics_organ[] = WAVETABLE_HARMONICS_ORGAN;
+    wavetable_init_table(table_sine, harmonics_sine, sizeof(harmonics_sine) / sizeof(harmonics_sine[0]));
+    wavetable_init_table(table_organ, harmonics_organ, sizeof(harmonics_organ) / sizeof(harmonics_organ[0]));
+}
+
+void tearDown(void)
+{
+}
+
+/**
+ * @brief Check that the wavetable of a sine starts at 0, is antisymmetric and peaks at `WAVETABLE_AMPLITUDE`, and that the organ-like wave is normalized to the same peak.
+ *
+ */
+void test_wavetable_table(void)
+{
+    UNITY_TEST_ASSERT_EQUAL_INT16(0, table_sine[0], __LINE__, "The wavetable does not start at 0");
+    UNITY_TEST_ASSERT_EQUAL_INT16(WAVETABLE_AMPLITUDE, table_sine[WAVETABLE_LENGTH / 4], __LINE__, "The sine does not peak at a quarter of the period");
+    for (uint32_t i = 1; i < WAVETABLE_LENGTH; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_INT16(-table_sine[i], table_sine[WAVETABLE_LENGTH - i], __LINE__, "The sine is not antisymmetric");
+    }
+    int16_t peak = 0;
+    for (uint32_t i = 0; i < WAVETABLE_LENGTH; i++)
+    {
+        int16_t magnitude = (table_organ[i] < 0) ? -table_organ[i] : table_organ[i];
+        peak = (magnitude > peak) ? magnitude : peak;
+    }
+    UNITY_TEST_ASSERT_EQUAL_INT16(WAVETABLE_AMPLITUDE, peak, __LINE__, "The organ-like wave is not normalized");
+}
+
+/**
+ * @brief Check that a silent oscillator outputs `WAVETABLE_OUTPUT_MIDSCALE`, also after a note, and that the samples of a note stay within 12 bits and reach both ends of the range.
+ *
+ */
+void test_wavetable_silence_and_range(void)
+{
+    wavetable_osc_t osc;
+    wavetable_osc_init(&osc, table_sine, true);
+    wavetable_fill(&osc, samples, TEST_BLOCK_LENGTH);
+    for (uint32_t i = 0; i < TEST_BLOCK_LENGTH; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT16(WAVETABLE_OUTPUT_MIDSCALE, samples[i], __LINE__, "A new oscillator is not silent");
+    }
+
+    wavetable_osc_set_frequency(&osc, TEST_FREQUENCY_HZ, TEST_SAMPLE_RATE_HZ);
+    wavetable_fill(&osc, samples, TEST_SAMPLE_RATE_HZ);
+    uint16_t min = 0xFFFF;
+    uint16_t max = 0;
+    for (uint32_t i = 0; i < TEST_SAMPLE_RATE_HZ; i++)
+    {
+        min = (samples[i] < min) ? samples[i] : min;
+        max = (samples[i] > max) ? samples[i] : max;
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT16(0, min, __LINE__, "The samples do not reach the bottom of the 12-bit range");
+    UNITY_TEST_ASSERT_EQUAL_UINT16(4095, max, __LINE__, "The samples do not reach the top of the 12-bit range");
+
+    wavetable_osc_set_frequency(&osc, 0, TEST_SAMPLE_RATE_HZ);
+    wavetable_fill(&osc, samples, TEST_BLOCK_LENGTH);
+    for (uint32_t i = 0; i < TEST_BLOCK_LENGTH; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT16(WAVETABLE_OUTPUT_MIDSCALE, samples[i], __LINE__, "A frequency of 0 is not silent");
+    }
+}
+
+/**
+ * @brief Check the frequency of the output: a second of samples has as many rising crossings of the midscale as Hz, also when it is filled in blocks of odd length.
+ *
+ */
+void test_wavetable_frequency(void)
+{
+    wavetable_osc_t osc;
+    wavetable_osc_init(&osc, table_sine, true);
+    wavetable_osc_set_frequency(&osc, TEST_FREQUENCY_HZ, TEST_SAMPLE_RATE_HZ);
+    for (uint32_t i = 0; i < TEST_SAMPLE_RATE_HZ; i += TEST_BLOCK_LENGTH)
+    {
+        wavetable_fill(&osc, &samples[i], TEST_BLOCK_LENGTH);
+    }
+    uint32_t crossings = 0;
+    for (uint32_t i = 1; i < TEST_SAMPLE_RATE_HZ; i++)
+    {
+        crossings += (samples[i - 1] < WAVETABLE_OUTPUT_MIDSCALE) && (samples[i] >= WAVETABLE_OUTPUT_MIDSCALE);
+    }
+    // The first period starts at the midscale, so its rising crossing is sample 0
+    UNITY_TEST_ASSERT_EQUAL_UINT32((uint32_t)TEST_FREQUENCY_HZ - 1, crossings, __LINE__, "Wrong frequency of the output");
+
+    // Odd blocks use the portable code for their last sample: the output must not change
+    static uint16_t samples_odd[TEST_SAMPLE_RATE_HZ];
+    static uint16_t block[TEST_BLOCK_LENGTH] __attribute__((aligned(4)));
+    wavetable_osc_init(&osc, table_sine, true);
+    wavetable_osc_set_frequency(&osc, TEST_FREQUENCY_HZ, TEST_SAMPLE_RATE_HZ);
+    for (uint32_t i = 0; i < TEST_SAMPLE_RATE_HZ; i += TEST_ODD_BLOCK_LENGTH)
+    {
+        uint32_t count = (TEST_SAMPLE_RATE_HZ - i < TEST_ODD_BLOCK_LENGTH) ? TEST_SAMPLE_RATE_HZ - i : TEST_ODD_BLOCK_LENGTH;
+        wavetable_fill(&osc, block, count);
+        memcpy(&samples_odd[i], block, count * sizeof(block[0]));
+    }
+    UNITY_TEST_ASSERT_EQUAL_UINT16_ARRAY(samples, samples_odd, TEST_SAMPLE_RATE_HZ, __LINE__, "The output depends on the length of the blocks");
+}
+
+/**
+ * @brief Check the linear interpolation: halfway between two samples of the wavetable the output is their mean, and without interpolation it is the sample below.
+ *
+ */
+void test_wavetable_interpolation(void)
+{
+    wavetable_osc_t osc;
+    wavetable_osc_init(&osc, table_sine, true);
+    // Half a sample of the wavetable per output sample
+    osc.phase_inc = 1U << (31 - WAVETABLE_BITS);
+    wavetable_fill(&osc, samples, 4);
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        int32_t a = table_sine[i];
+        int32_t b = table_sine[i + 1];
+        int32_t expected = ((a * 32767 + b * 0) >> WAVETABLE_FRACTION_BITS) >> 3;
+        UNITY_TEST_ASSERT_EQUAL_UINT16(expected + WAVETABLE_OUTPUT_MIDSCALE, samples[2 * i], __LINE__, "Wrong sample on a sample of the wavetable");
+        expected = ((a * 16383 + b * 16384) >> WAVETABLE_FRACTION_BITS) >> 3;
+        UNITY_TEST_ASSERT_EQUAL_UINT16(expected + WAVETABLE_OUTPUT_MIDSCALE, samples[2 * i + 1], __LINE__, "Wrong interpolated sample");
+    }
+
+    wavetable_osc_init(&osc, table_sine, false);
+    osc.phase_inc = 1U << (31 - WAVETABLE_BITS);
+    wavetable_fill(&osc, samples, 4);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        UNITY_TEST_ASSERT_EQUAL_UINT16((table_sine[i / 2] >> 3) + WAVETABLE_OUTPUT_MIDSCALE, samples[i], __LINE__, "Wrong sample without interpolation");
+    }
+}
+
+/**
+ * @brief Check that the fill of the DAC output, with interpolation, takes at most `TEST_MAX_CPU_FRACTION` of the CPU at the sample rate, in blocks of half the buffer of the DAC output.
+ *
+ */
+void test_wavetable_cpu_budget(void)
+{
+    wavetable_osc_t osc;
+    wavetable_osc_init(&osc, table_organ, true);
+    wavetable_osc_set_frequency(&osc, TEST_FREQUENCY_HZ, TEST_SAMPLE_RATE_HZ);
+    uint32_t start = port_system_get_cycles();
+    for (uint32_t i = 0; i < TEST_SAMPLE_RATE_HZ; i += TEST_BLOCK_LENGTH)
+    {
+        wavetable_fill(&osc, &samples[i], TEST_BLOCK_LENGTH);
+    }
+    uint32_t cycles = port_system_get_cycles() - start;
+    UNITY_TEST_ASSERT(cycles <= SystemCoreClock / TEST_MAX_CPU_FRACTION, __LINE__, "The fill of a second of samples takes too much CPU");
+}
+
+/**
+ * @brief Main test function.
+ *
+ * @return int
+ */
+int main(void)
+{
+    port_system_init();
+    UNITY_BEGIN();
+    RUN_TEST(test_wavetable_table);
+    RUN_TEST(test_wavetable_silence_and_range);
+    RUN_TEST(test_wavetable_frequency);
+    RUN_TEST(test_wavetable_interpolation);
+    RUN_TEST(test_wavetable_cpu_budget);
+    return UNITY_END();
+}
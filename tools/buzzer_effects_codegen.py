@@ -0,0 +1,174 @@
+#!/usr/bin/env python3
+"""
+@file buzzer_effects_codegen.py
+@brief Generator of the tables of the pitch effects of the buzzer from the notes of `melodies.h`.
+@author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+@author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+@date 19/10/2026
+
+This script reads the frequencies of the notes defined in
+`common/include/melodies.h` and writes `port/stm32f4/src/port_buzzer_effects.inc`
+with the values of the ARR register of the PWM timer (TIM3) of the effects, for
+a common prescaler and the system clock given:
+
+- A pitch grid of `STEPS_PER_SEMITONE` steps per semitone from the lowest note
+  to the highest one, in rising (`effects_grid_up`) and falling
+  (`effects_grid_down`) order. A glide between two notes is a slice of it, so
+  the DMA copies it with increasing addresses in both directions. The points of
+  the grid on a note have exactly the ARR of the note.
+- A cycle of vibrato of `VIBRATO_STEPS` values for every note
+  (`effects_vibrato`), a sine of `VIBRATO_CENTS` cents around the note.
+
+All the floating point is done here, so the port layer only copies values. The
+generated file is committed, so the build does not need Python. Run this script
+(or the `buzzer-effects-codegen` CMake target) after changing the notes of
+`melodies.h`.
+
+Usage:
+    buzzer_effects_codegen.py [--clock HZ]            Regenerate the tables
+    buzzer_effects_codegen.py --check [--clock HZ]    Fail if the tables are out of date
+"""
+
+import argparse
+import math
+import os
+import re
+import sys
+
+NOTE_RE = re.compile(r"^#define\s+(\w+)\s+([0-9]+\.[0-9]+)\b", re.M)
+STEPS_PER_SEMITONE = 8      # Resolution of the pitch grid of the glides
+VIBRATO_STEPS = 32          # Values of a cycle of vibrato
+VIBRATO_HZ = 6              # Cycles of vibrato per second
+VIBRATO_CENTS = 25          # Depth of the vibrato, in cents above and below the note
+ARR_MAX = 65535
+
+
+def parse_notes(header):
+    """Return the notes of melodies.h as (name, literal) sorted by frequency. The literal is kept as written, so the C table compares equal to the defines."""
+    notes = [(name, literal) for name, literal in NOTE_RE.findall(header)]
+    return sorted(notes, key=lambda note: float(note[1]))
+
+
+def get_arr(clock_hz, psc, frequency_hz):
+    """Return the ARR of a frequency, rounded as `port_buzzer_set_note_frequency()` does."""
+    return int(round(clock_hz / (psc + 1) / frequency_hz - 1))
+
+
+def generate(notes, clock_hz):
+    """Return the text of port_buzzer_effects.inc."""
+    frequencies = [float(literal) for _, literal in notes]
+    low_hz = frequencies[0] * 2 ** (-VIBRATO_CENTS / 1200.0)
+    psc = 0
+    while get_arr(clock_hz, psc, low_hz) > ARR_MAX:
+        psc += 1
+
+    note_grid = [int(round(12 * STEPS_PER_SEMITONE * math.log2(f / frequencies[0]))) for f in frequencies]
+    grid = [get_arr(clock_hz, psc, frequencies[0] * 2 ** (k / (12.0 * STEPS_PER_SEMITONE))) for k in range(note_grid[-1] + 1)]
+    for index, frequency in zip(note_grid, frequencies):
+        grid[index] = get_arr(clock_hz, psc, frequency)
+
+    vibrato = []
+    for frequency in frequencies:
+        cycle = [get_arr(clock_hz, psc, frequency * 2 ** (VIBRATO_CENTS * math.sin(2 * math.pi * i / VIBRATO_STEPS) / 1200.0)) for i in range(VIBRATO_STEPS)]
+        vibrato.append(cycle)
+
+    def rows(values, per_line=12, indent="    "):
+        lines = []
+        for i in range(0, len(values), per_line):
+            lines.append(indent + ", ".join(str(value) for value in values[i:i + per_line]) + ",")
+        return "\n".join(lines)
+
+    out = []
+    out.append("/**")
+    out.append(" * @file port_buzzer_effects.inc")
+    out.append(" * @brief Tables of the pitch effects of the buzzer, generated by `tools/buzzer_effects_codegen.py` from melodies.h for a system clock of %d Hz. Do not edit." % clock_hz)
+    out.append(" */")
+    out.append("")
+    defines = [
+        ("PORT_BUZZER_EFFECTS_CLOCK_HZ", "%dU" % clock_hz, "System clock of the tables. The effects are disabled with another clock"),
+        ("PORT_BUZZER_EFFECTS_PSC", psc, "Prescaler of the PWM timer of all the notes of the tables"),
+        ("PORT_BUZZER_EFFECTS_NUM_NOTES", len(notes), "Number of notes of the tables"),
+        ("PORT_BUZZER_EFFECTS_STEPS_PER_SEMITONE", STEPS_PER_SEMITONE, "Steps of the pitch grid per semitone"),
+        ("PORT_BUZZER_EFFECTS_GRID_LENGTH", len(grid), "Number of steps of the pitch grid"),
+        ("PORT_BUZZER_EFFECTS_VIBRATO_STEPS", VIBRATO_STEPS, "Values of a cycle of vibrato"),
+        ("PORT_BUZZER_EFFECTS_VIBRATO_HZ", VIBRATO_HZ, "Cycles of vibrato per second"),
+    ]
+    for name, value, brief in defines:
+        out.append(("#define %s %s" % (name, value)).ljust(52) + "/*!<%s*/" % brief)
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Frequencies of the notes of the tables, as written in melodies.h, from the lowest to the highest.")
+    out.append(" *")
+    out.append(" */")
+    out.append("static const double effects_notes[PORT_BUZZER_EFFECTS_NUM_NOTES] = {")
+    out.append(rows([literal for _, literal in notes], per_line=6))
+    out.append("};")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief Step of the pitch grid of each note.")
+    out.append(" *")
+    out.append(" */")
+    out.append("static const uint16_t effects_note_grid[PORT_BUZZER_EFFECTS_NUM_NOTES] = {")
+    out.append(rows(note_grid))
+    out.append("};")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief ARR of the steps of the pitch grid, from the lowest note to the highest.")
+    out.append(" *")
+    out.append(" */")
+    out.append("static const uint16_t effects_grid_up[PORT_BUZZER_EFFECTS_GRID_LENGTH] = {")
+    out.append(rows(grid))
+    out.append("};")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief ARR of the steps of the pitch grid, from the highest note to the lowest.")
+    out.append(" *")
+    out.append(" */")
+    out.append("static const uint16_t effects_grid_down[PORT_BUZZER_EFFECTS_GRID_LENGTH] = {")
+    out.append(rows(grid[::-1]))
+    out.append("};")
+    out.append("")
+    out.append("/**")
+    out.append(" * @brief ARR of a cycle of vibrato of each note. The first value is the ARR of the note.")
+    out.append(" *")
+    out.append(" */")
+    out.append("static const uint16_t effects_vibrato[PORT_BUZZER_EFFECTS_NUM_NOTES][PORT_BUZZER_EFFECTS_VIBRATO_STEPS] = {")
+    for index, ((name, _), cycle) in enumerate(zip(notes, vibrato)):
+        out.append("    [%d] = { // %s" % (index, name))
+        out.append(rows(cycle, indent="        "))
+        out.append("    },")
+    out.append("};")
+    out.append("")
+    return "\n".join(out)
+
+
+def main():
+    root_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+    parser = argparse.ArgumentParser(description="Generate the tables of the pitch effects of the buzzer from the notes of melodies.h.")
+    parser.add_argument("--header", default=os.path.join(root_dir, "common", "include", "melodies.h"), help="header with the notes (default: common/include/melodies.h)")
+    parser.add_argument("--output", default=os.path.join(root_dir, "port", "stm32f4", "src", "port_buzzer_effects.inc"), help="generated file (default: port/stm32f4/src/port_buzzer_effects.inc)")
+    parser.add_argument("--clock", type=int, default=16000000, help="system clock in Hz (default: 16000000, the HSI)")
+    parser.add_argument("--check", action="store_true", help="only check that the generated file is up to date")
+    args = parser.parse_args()
+
+    with open(args.header, encoding="utf-8") as header_file:
+        notes = parse_notes(header_file.read())
+    if not notes:
+        sys.exit("No notes found in %s" % args.header)
+    text = generate(notes, args.clock)
+
+    current = None
+    if os.path.exists(args.output):
+        with open(args.output, encoding="utf-8") as output_file:
+            current = output_file.read()
+    if current == text:
+        return
+    if args.check:
+        sys.exit("Out of date, run tools/buzzer_effects_codegen.py: " + args.output)
+    with open(args.output, "w", encoding="utf-8") as output_file:
+        output_file.write(text)
+    print("Generated %s (%d notes)" % (args.output, len(notes)))
+
+
+if __name__ == "__main__":
+    main()
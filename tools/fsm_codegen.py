@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+@file fsm_codegen.py
+@brief Compiler of the FSM transition tables into switch-based dispatch functions.
+@author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+@author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+@date 19/10/2026
+
+For each `fsm_trans_<name>[]` table found in `common/src/fsm_<name>.c`, this
+script writes `common/src/fsm_<name>_dispatch.inc` with a function
+`fsm_<name>_dispatch()` that fires the FSM with a `switch` over the origin
+states. The guards and outputs are called directly instead of through the
+function pointers of the table, so the compiler can inline them. The rows of
+each state are checked in table order and the state is updated before the
+output is called, exactly as `fsm_fire()` does.
+
+If the source file also has a `fsm_states_<name>[]` table of
+`fsm_hsm_state_t`, the FSM is hierarchical: each leaf state also checks the
+rows of its superstates after its own, and the exit and entry actions of the
+states left and entered are called in place, exactly as `fsm_hsm_fire()` does.
+A row of a superstate whose guard is already checked by a row of the leaf, or
+of a lower superstate, is left out of the case of the leaf: the guards have no
+side effects, so it could never fire, and it would evaluate the guard twice.
+
+The generated files are committed, so the build does not need Python. Run this
+script (or the `fsm-codegen` CMake target) after changing a transition table.
+
+Usage:
+    fsm_codegen.py [SRC_DIR]            Regenerate the dispatch files
+    fsm_codegen.py --check [SRC_DIR]    Fail if any dispatch file is out of date
+"""
+
+import argparse
+import os
+import re
+import sys
+
+TABLE_RE = re.compile(r"fsm_trans_t\s+fsm_trans_(\w+)\s*\[\s*\]\s*=\s*\{(.*?)\n\s*\};", re.S)
+STATES_RE = re.compile(r"fsm_hsm_state_t\s+fsm_states_(\w+)\s*\[\s*\]\s*=\s*\{(.*?)\n\s*\};", re.S)
+ROW_RE = re.compile(r"\{([^{}]*)\}")
+INTERNAL = "FSM_HSM_INTERNAL"
+NO_PARENT = ("-1", "FSM_HSM_NO_PARENT")
+
+
+def parse_table(source):
+    """Return (name, rows) of the transition table of a source file, or None. Each row is (orig, in, dest, out)."""
+    match = TABLE_RE.search(source)
+    if match is None:
+        return None
+    rows = []
+    for row in ROW_RE.findall(match.group(2)):
+        fields = [field.strip() for field in row.split(",")]
+        if len(fields) != 4:
+            raise ValueError("Malformed row in fsm_trans_%s: {%s}" % (match.group(1), row))
+        if fields[0] == "-1":
+            break
+        rows.append(tuple(fields))
+    return match.group(1), rows
+
+
+def parse_states(source):
+    """Return the states of the hierarchy table of a source file, or None. Each state is (state, parent, entry, exit)."""
+    match = STATES_RE.search(source)
+    if match is None:
+        return None
+    states = []
+    for row in ROW_RE.findall(match.group(2)):
+        fields = [field.strip() for field in row.split(",")]
+        if len(fields) != 4:
+            raise ValueError("Malformed state in fsm_states_%s: {%s}" % (match.group(1), row))
+        if fields[0] == "-1":
+            break
+        states.append(tuple(fields))
+    return states
+
+
+def _ancestors(state, parents):
+    """Return the state and its superstates, from the state up to the top level."""
+    chain = [state]
+    while parents.get(chain[-1], "-1") not in NO_PARENT:
+        chain.append(parents[chain[-1]])
+    return chain
+
+
+def _transition_actions(leaf, dest, parents, entries, exits):
+    """Return (exit actions, entry actions) of a transition from a leaf state, in the order they are called."""
+    if dest == leaf:
+        return [], []
+    up = _ancestors(leaf, parents)
+    down = _ancestors(dest, parents)
+    common = next((state for state in up if state in down), None)
+    left = up[:up.index(common)] if common else up
+    entered = down[:down.index(common)] if common else down
+    exit_actions = [exits[state] for state in left if exits.get(state, "NULL") != "NULL"]
+    entry_actions = [entries[state] for state in reversed(entered) if entries.get(state, "NULL") != "NULL"]
+    return exit_actions, entry_actions
+
+
+def generate(name, rows, source_name, hierarchy=None):
+    """Return the text of the dispatch file of a table. `hierarchy` is the list of states of `fsm_states_<name>`, if any."""
+    hierarchy = hierarchy or []
+    parents = {state: parent for state, parent, _, _ in hierarchy}
+    entries = {state: entry for state, _, entry, _ in hierarchy}
+    exits = {state: exit_action for state, _, _, exit_action in hierarchy}
+    superstates = set(parent for parent in parents.values() if parent not in NO_PARENT)
+
+    # The FSM is always in a leaf state: only they get a case, with their own rows and then the rows of their superstates
+    states = []
+    candidates = [orig for orig, _, _, _ in rows] + [dest for _, _, dest, _ in rows] + list(parents)
+    for state in candidates:
+        if (state not in states) and (state not in superstates) and (state != INTERNAL):
+            chain = _ancestors(state, parents)
+            if any(orig in chain for orig, _, _, _ in rows):
+                states.append(state)
+    equivalent = "`fsm_hsm_fire()` with `fsm_states_%s`" % name if hierarchy else "`fsm_fire()`"
+
+    lines = [
+        "/**",
+        " * @file fsm_%s_dispatch.inc" % name,
+        " * @brief Switch-based dispatch of `fsm_trans_%s`, generated by `tools/fsm_codegen.py` from %s. Do not edit." % (name, source_name),
+        " */",
+        "",
+        "/**",
+        " * @brief Fire the FSM with the transitions of `fsm_trans_%s` compiled into a switch. It is equivalent to %s." % (name, equivalent),
+        " *",
+        " * @param p_this Pointer to the FSM",
+        " * @return int Position in `fsm_trans_%s` of the row fired. -1 if no guard is true." % name,
+        " */",
+        "static inline int fsm_%s_dispatch(fsm_t *p_this)" % name,
+        "{",
+        "    switch (p_this->current_state)",
+        "    {",
+    ]
+    for state in states:
+        lines.append("    case %s:" % state)
+        checked = set()
+        for level in _ancestors(state, parents):
+            for index, (orig, guard, dest, out) in enumerate(rows):
+                if (orig != level) or (guard in checked):
+                    continue
+                checked.add(guard)
+                lines.append("        if (%s(p_this))" % guard)
+                lines.append("        {")
+                exit_actions, entry_actions = [], []
+                if dest != INTERNAL:
+                    exit_actions, entry_actions = _transition_actions(state, dest, parents, entries, exits)
+                    lines += ["            %s(p_this);" % action for action in exit_actions]
+                    lines.append("            p_this->current_state = %s;" % dest)
+                if out != "NULL":
+                    lines.append("            %s(p_this);" % out)
+                lines += ["            %s(p_this);" % action for action in entry_actions]
+                lines.append("            return %d;" % index)
+                lines.append("        }")
+        lines.append("        break;")
+    lines += [
+        "    default:",
+        "        break;",
+        "    }",
+        "    return -1;",
+        "}",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def main():
+    default_dir = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "common", "src")
+    parser = argparse.ArgumentParser(description="Compile the FSM transition tables into switch-based dispatch functions.")
+    parser.add_argument("src_dir", nargs="?", default=default_dir, help="directory with the fsm_*.c files (default: common/src)")
+    parser.add_argument("--check", action="store_true", help="only check that the dispatch files are up to date")
+    args = parser.parse_args()
+
+    out_of_date = []
+    for file_name in sorted(os.listdir(args.src_dir)):
+        if not (file_name.startswith("fsm_") and file_name.endswith(".c")):
+            continue
+        with open(os.path.join(args.src_dir, file_name), encoding="utf-8") as source_file:
+            source = source_file.read()
+        table = parse_table(source)
+        if table is None:
+            continue
+        name, rows = table
+        text = generate(name, rows, file_name, parse_states(source))
+        path = os.path.join(args.src_dir, "fsm_%s_dispatch.inc" % name)
+        current = None
+        if os.path.exists(path):
+            with open(path, encoding="utf-8") as dispatch_file:
+                current = dispatch_file.read()
+        if current == text:
+            continue
+        if args.check:
+            out_of_date.append(path)
+        else:
+            with open(path, "w", encoding="utf-8") as dispatch_file:
+                dispatch_file.write(text)
+            print("Generated %s (%d rows)" % (path, len(rows)))
+
+    if out_of_date:
+        sys.exit("Out of date, run tools/fsm_codegen.py: " + ", ".join(out_of_date))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+"""
+@file fsm_trace_timeline.py
+@brief Timeline of the transitions fired by the FSMs of the Jukebox.
+@author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+@author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+@date 19/10/2026
+
+The Jukebox answers the command `trace <seq>` with a line such as
+`TRC00000000 00000011 000004D20300010000...`, see `fsm_trace_dump()` in
+`common/include/fsm_trace.h`. This script decodes those lines and prints the
+transitions in order, with the names of the states and of the guard and output
+of each row, taken from the headers and transition tables of `common/`.
+
+Usage:
+    fsm_trace_timeline.py --port /dev/ttyACM0     Ask the Jukebox for the whole ring (needs pyserial)
+    fsm_trace_timeline.py capture.txt             Decode the TRC lines of a capture of the terminal
+    fsm_trace_timeline.py < capture.txt
+"""
+
+import argparse
+import os
+import re
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from fsm_codegen import parse_table  # noqa: E402
+
+ENTRY_LENGTH = 16
+# Same order as enum FSM_TRACE_ID: (name shown, module)
+FSMS = [
+    ("BUTTON", "button"),
+    ("USART", "usart"),
+    ("BUZZER", "buzzer"),
+    ("JUKEBOX", "jukebox"),
+    ("LED_0", "led"),
+    ("LED_1", "led"),
+    ("TELEMETRY", "telemetry"),
+    ("GESTURE", "gesture"),
+]
+LINE_RE = re.compile(r"TRC([0-9A-F]{8}) ([0-9A-F]{8}) ((?:[0-9A-F]{%d})*)" % ENTRY_LENGTH)
+ENUM_RE = re.compile(r"enum\s+FSM_\w+\s*\{(.*?)\}", re.S)
+COMMON_DIR = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "common")
+
+
+def load_names(common_dir):
+    """Return, for each module, (states, rows): the names of the states by value and the (guard, output) of each row."""
+    names = {}
+    for _, module in FSMS:
+        states = {}
+        rows = []
+        try:
+            with open(os.path.join(common_dir, "include", "fsm_%s.h" % module), encoding="utf-8") as header:
+                match = ENUM_RE.search(header.read())
+            if match:
+                body = re.sub(r"/\*.*?\*/", "", match.group(1), flags=re.S)
+                value = 0
+                for item in body.split(","):
+                    item = item.strip()
+                    if not item:
+                        continue
+                    if "=" in item:
+                        item, number = [part.strip() for part in item.split("=")]
+                        value = int(number, 0)
+                    states[value] = item
+                    value += 1
+            with open(os.path.join(common_dir, "src", "fsm_%s.c" % module), encoding="utf-8") as source:
+                table = parse_table(source.read())
+            if table:
+                rows = [(guard, out) for _, guard, _, out in table[1]]
+        except OSError:
+            pass
+        names[module] = (states, rows)
+    return names
+
+
+def parse_line(line):
+    """Return (first, head, entries) for each TRC dump found in a line. Each entry is (seq, millis, fsm_id, from, to, row)."""
+    dumps = []
+    for match in LINE_RE.finditer(line):
+        first = int(match.group(1), 16)
+        text = match.group(3)
+        entries = []
+        for i in range(0, len(text), ENTRY_LENGTH):
+            chunk = text[i:i + ENTRY_LENGTH]
+            entries.append((first + i // ENTRY_LENGTH, int(chunk[0:8], 16), int(chunk[8:10], 16),
+                            int(chunk[10:12], 16), int(chunk[12:14], 16), int(chunk[14:16], 16)))
+        dumps.append((first, int(match.group(2), 16), entries))
+    return dumps
+
+
+def print_timeline(dumps, names):
+    """Print the transitions in order of sequence number, without duplicates."""
+    entries = {}
+    for _, _, dump_entries in dumps:
+        for entry in dump_entries:
+            entries[entry[0]] = entry
+
+    print("%8s %10s %8s  %-10s %-40s %s" % ("seq", "time ms", "+ms", "FSM", "transition", "row"))
+    previous_millis = None
+    previous_seq = None
+    for seq in sorted(entries):
+        _, millis, fsm_id, state_from, state_to, row = entries[seq]
+        if previous_seq is not None and seq != previous_seq + 1:
+            print("%8s %d transitions lost" % ("...", seq - previous_seq - 1))
+        name, module = FSMS[fsm_id] if fsm_id < len(FSMS) else ("FSM %d" % fsm_id, None)
+        states, rows = names.get(module, ({}, []))
+        transition = "%s -> %s" % (states.get(state_from, str(state_from)), states.get(state_to, str(state_to)))
+        row_text = "%d" % row
+        if row < len(rows):
+            guard, out = rows[row]
+            row_text += " %s / %s" % (guard, out if out != "NULL" else "-")
+        delta = "" if previous_millis is None else "+%d" % (millis - previous_millis)
+        print("%8d %10d %8s  %-10s %-40s %s" % (seq, millis, delta, name, transition, row_text))
+        previous_millis = millis
+        previous_seq = seq
+
+
+def read_from_port(port, baudrate):
+    """Ask the Jukebox for the transitions in the ring and return the lines received. New transitions recorded while reading are not asked for."""
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial is needed to read from the Jukebox: pip install pyserial")
+
+    lines = []
+    seq = 0
+    end = None
+    with serial.Serial(port, baudrate, timeout=1) as link:
+        while end is None or seq < end:
+            link.write(("trace %d\n" % seq).encode("ascii"))
+            line = link.readline().decode("ascii", errors="replace")
+            lines.append(line)
+            dumps = parse_line(line)
+            if not dumps or not dumps[0][2]:
+                break
+            first, head, entries = dumps[0]
+            if end is None:
+                end = head
+            seq = first + len(entries)
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Timeline of the transitions fired by the FSMs of the Jukebox.")
+    parser.add_argument("capture", nargs="?", help="text file with the TRC lines (default: standard input)")
+    parser.add_argument("--port", help="serial port of the Jukebox")
+    parser.add_argument("--baudrate", type=int, default=9600, help="baud rate of the serial port (default: 9600)")
+    parser.add_argument("--common", default=COMMON_DIR, help="directory with the include and src folders of the FSMs (default: common)")
+    args = parser.parse_args()
+
+    if args.port:
+        lines = read_from_port(args.port, args.baudrate)
+    elif args.capture:
+        with open(args.capture, encoding="ascii", errors="replace") as capture:
+            lines = capture.readlines()
+    else:
+        lines = sys.stdin.readlines()
+
+    dumps = [dump for line in lines for dump in parse_line(line)]
+    if not any(entries for _, _, entries in dumps):
+        sys.exit("No transitions found")
+    print_timeline(dumps, load_names(args.common))
+
+
+if __name__ == "__main__":
+    main()
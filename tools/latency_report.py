@@ -0,0 +1,126 @@
+#!/usr/bin/env python3
+"""
+@file latency_report.py
+@brief Report of the command latency histograms of the Jukebox.
+@author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+@author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+@date 19/10/2026
+
+The Jukebox answers the command `latency <segment>` with a line such as
+`LAT0 0012 000004D2 0000000000030009...`, see `latency_trace_dump()` in
+`common/include/latency_trace.h`. This script decodes those lines and prints
+one histogram per segment.
+
+Usage:
+    latency_report.py --port /dev/ttyACM0     Ask the Jukebox for all the segments (needs pyserial)
+    latency_report.py capture.txt             Decode the LAT lines of a capture of the terminal
+    latency_report.py < capture.txt
+"""
+
+import argparse
+import re
+import sys
+
+BUCKETS = 16
+SEGMENTS = [
+    "Total (USART ISR -> register write)",
+    "USART ISR -> do_get_data_rx",
+    "do_get_data_rx -> do_read_command",
+    "do_read_command -> _execute_command",
+    "_execute_command -> register write",
+    "Wake-up from STOP -> first FSM fire",
+]
+LINE_RE = re.compile(r"LAT(\d+) ([0-9A-F]{4}) ([0-9A-F]{8}) ([0-9A-F]{%d})" % (4 * BUCKETS))
+BAR_WIDTH = 40
+
+
+def parse_line(line):
+    """Return (segment, count, max_us, buckets) for each LAT dump found in a line."""
+    dumps = []
+    for match in LINE_RE.finditer(line):
+        hex_buckets = match.group(4)
+        buckets = [int(hex_buckets[i:i + 4], 16) for i in range(0, 4 * BUCKETS, 4)]
+        dumps.append((int(match.group(1)), int(match.group(2), 16), int(match.group(3), 16), buckets))
+    return dumps
+
+
+def bucket_range(index):
+    """Return the text of the range of latencies of a bucket in us."""
+    low = 0 if index == 0 else 1 << index
+    if index == BUCKETS - 1:
+        return ">= %d" % low
+    return "%d-%d" % (low, (1 << (index + 1)) - 1)
+
+
+def percentile(buckets, fraction):
+    """Return the upper bound in us of the bucket that holds a percentile."""
+    total = sum(buckets)
+    if total == 0:
+        return 0
+    accumulated = 0
+    for index, count in enumerate(buckets):
+        accumulated += count
+        if accumulated >= fraction * total:
+            return (1 << (index + 1)) - 1
+    return (1 << BUCKETS) - 1
+
+
+def print_report(dumps):
+    """Print a histogram for each segment, the last dump of each segment wins."""
+    by_segment = {}
+    for segment, count, max_us, buckets in dumps:
+        by_segment[segment] = (count, max_us, buckets)
+
+    for segment in sorted(by_segment):
+        count, max_us, buckets = by_segment[segment]
+        name = SEGMENTS[segment] if segment < len(SEGMENTS) else "Segment %d" % segment
+        print("%s" % name)
+        print("  traces: %d  max: %d us  p50 <= %d us  p99 <= %d us" % (
+            count, max_us, percentile(buckets, 0.5), percentile(buckets, 0.99)))
+        peak = max(buckets) or 1
+        for index, value in enumerate(buckets):
+            if value == 0:
+                continue
+            bar = "#" * max(1, value * BAR_WIDTH // peak)
+            print("  %14s us %6d %s" % (bucket_range(index), value, bar))
+        print()
+
+
+def read_from_port(port, baudrate):
+    """Ask the Jukebox for every segment and return the lines received."""
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial is needed to read from the Jukebox: pip install pyserial")
+
+    lines = []
+    with serial.Serial(port, baudrate, timeout=1) as link:
+        for segment in range(len(SEGMENTS)):
+            link.write(("latency %d\n" % segment).encode("ascii"))
+            lines.append(link.readline().decode("ascii", errors="replace"))
+    return lines
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Report of the command latency histograms of the Jukebox.")
+    parser.add_argument("capture", nargs="?", help="text file with the LAT lines (default: standard input)")
+    parser.add_argument("--port", help="serial port of the Jukebox")
+    parser.add_argument("--baudrate", type=int, default=9600, help="baud rate of the serial port (default: 9600)")
+    args = parser.parse_args()
+
+    if args.port:
+        lines = read_from_port(args.port, args.baudrate)
+    elif args.capture:
+        with open(args.capture, encoding="ascii", errors="replace") as capture:
+            lines = capture.readlines()
+    else:
+        lines = sys.stdin.readlines()
+
+    dumps = [dump for line in lines for dump in parse_line(line)]
+    if not dumps:
+        sys.exit("No latency dumps found")
+    print_report(dumps)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,309 @@
+/**
+ * @file melody_wav.c
+ * @brief Host tool that renders the melodies of `melodies.c` to WAV files with the timer values of the firmware, and reports the pitch and timing errors they cause.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ *
+ * It links the same `buzzer_timing.c` and `melodies.c` as the firmware. Each note is played as the buzzer FSM and the port layer do: the duration is scaled by the speed of the player as in `_start_note()` and quantized to the PSC and ARR of TIM2, and the frequency to the PSC and ARR of TIM3. The square wave of TIM3 (PWM mode 1, duty cycle `BUZZER_PWM_DC`) is sampled from its counter, so the WAV file has the real periods and durations, and the notes follow one another with no gap. The envelope and the pitch effects are not rendered: the notes are those of `PORT_BUZZER_EFFECT_NONE`.
+ *
+ * For every note it prints the PSC and ARR of both timers, the pitch error in cents and the cumulative timing error. The pitch error is the one of the PWM frequency; the timing error does not include the latency of the ISR and the FSM between two notes.
+ *
+ * Build and run on Linux, from the root of the repository:
+ *
+ *     cc -O2 -std=c11 -Icommon/include tools/melody_wav.c common/src/buzzer_timing.c common/src/melodies.c -lm -o melody_wav
+ *     ./melody_wav [-m melody|all] [-s speed] [-c clock] [-r rate] [-o dir] [-q]
+ *
+ * Options:
+ *   -m  Melody: scale, inverse_scale, happy_birthday, tetris, avemaria, pp_hymn or all (default: all)
+ *   -s  Speed of the player (default: 1.0)
+ *   -c  System clock in Hz (default: 16000000, the HSI)
+ *   -r  Sample rate of the WAV files in Hz (default: 48000)
+ *   -o  Directory of the WAV files, named after the melodies. Without it, the errors are only reported
+ *   -q  Only print the summary of each melody
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#define _POSIX_C_SOURCE 200809L
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Other libraries */
+#include "buzzer_timing.h"
+#include "melodies.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define MELODY_WAV_PWM_DC 0.5           /*!<Duty cycle of the PWM, as `BUZZER_PWM_DC` in port_buzzer.h*/
+#define MELODY_WAV_AMPLITUDE 8000       /*!<Amplitude of the square wave in the WAV file*/
+#define MELODY_WAV_PATH_LENGTH 512      /*!<Maximum length of the path of a WAV file*/
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Melody that can be rendered, by name.
+ *
+ */
+typedef struct
+{
+    const char *p_name;         /*!<Name of the option `-m` and of the WAV file*/
+    const melody_t *p_melody;   /*!<Melody of melodies.c*/
+} wav_melody_t;
+
+/**
+ * @brief Options of the renderer.
+ *
+ */
+typedef struct
+{
+    double speed;               /*!<Speed of the player*/
+    uint32_t clock_hz;          /*!<System clock*/
+    uint32_t sample_rate_hz;    /*!<Sample rate of the WAV files*/
+    const char *p_dir;          /*!<Directory of the WAV files, or NULL*/
+    bool quiet;                 /*!<True to print only the summaries*/
+} wav_options_t;
+
+/* Global variables */
+/**
+ * @brief Melodies that can be rendered.
+ *
+ */
+static const wav_melody_t wav_melodies[] = {
+    {"scale", &scale_melody},
+    {"inverse_scale", &inverse_scale_melody},
+    {"happy_birthday", &happy_birthday_melody},
+    {"tetris", &tetris_melody},
+    {"avemaria", &avemaria_melody},
+    {"pp_hymn", &pp_hymn_melody},
+};
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Write a little-endian value of 2 or 4 bytes.
+ *
+ * @param p_file File
+ * @param value Value
+ * @param bytes Number of bytes
+ */
+static void _write_le(FILE *p_file, uint32_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++)
+    {
+        fputc((value >> (8 * i)) & 0xFF, p_file);
+    }
+}
+
+/**
+ * @brief Write the header of a mono 16-bit PCM WAV file.
+ *
+ * @param p_file File
+ * @param sample_rate_hz Sample rate
+ * @param num_samples Number of samples of the file
+ */
+static void _write_header(FILE *p_file, uint32_t sample_rate_hz, uint32_t num_samples)
+{
+    uint32_t data_bytes = num_samples * 2;
+    fwrite("RIFF", 1, 4, p_file);
+    _write_le(p_file, 36 + data_bytes, 4);
+    fwrite("WAVEfmt ", 1, 8, p_file);
+    _write_le(p_file, 16, 4);                   // Size of the fmt chunk
+    _write_le(p_file, 1, 2);                    // PCM
+    _write_le(p_file, 1, 2);                    // Mono
+    _write_le(p_file, sample_rate_hz, 4);
+    _write_le(p_file, sample_rate_hz * 2, 4);   // Bytes per second
+    _write_le(p_file, 2, 2);                    // Bytes per sample
+    _write_le(p_file, 16, 2);                   // Bits per sample
+    fwrite("data", 1, 4, p_file);
+    _write_le(p_file, data_bytes, 4);
+}
+
+/**
+ * @brief Return the time of the monotonic clock in ns.
+ *
+ * @return uint64_t Time in ns
+ */
+static uint64_t _get_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Return the clock cycles of a note, from the PSC and ARR of the timer of the note duration at a speed.
+ *
+ * @param p_melody Melody
+ * @param note Index of the note
+ * @param p_options Options of the renderer
+ * @return uint64_t Clock cycles of the note
+ */
+static uint64_t _get_note_cycles(const melody_t *p_melody, uint32_t note, const wav_options_t *p_options)
+{
+    buzzer_timing_t duration;
+    buzzer_timing_get_duration(p_options->clock_hz, buzzer_timing_get_scaled_duration(p_melody->p_durations[note], p_options->speed), &duration);
+    return (uint64_t)(duration.psc + 1) * (duration.arr + 1);
+}
+
+/**
+ * @brief Check a melody, print its errors and render it to a WAV file if a directory is given.
+ *
+ * @param p_wav_melody Melody
+ * @param p_options Options of the renderer
+ * @return int 0 on success, -1 if the WAV file cannot be written
+ */
+static int _render_melody(const wav_melody_t *p_wav_melody, const wav_options_t *p_options)
+{
+    const melody_t *p_melody = p_wav_melody->p_melody;
+    double clock_hz = p_options->clock_hz;
+    double nominal_ms = 0;
+    uint64_t total_cycles = 0;
+    double max_cents = 0;
+
+    if (!p_options->quiet)
+    {
+        printf("\n%s\n", p_wav_melody->p_name);
+        printf(" Note | Frequency (Hz) | TIM3 PSC |   ARR | Played (Hz) |  Error (cents) | Duration (ms) | TIM2 PSC |   ARR | Played (ms) | Cumulative error (ms)\n");
+    }
+    for (uint32_t note = 0; note < p_melody->melody_length; note++)
+    {
+        double frequency_hz = p_melody->p_notes[note];
+        buzzer_timing_t pwm = {0, 0};
+        double played_hz = 0;
+        double cents = 0;
+        if (frequency_hz != 0)
+        {
+            buzzer_timing_get_pwm(p_options->clock_hz, frequency_hz, &pwm);
+            played_hz = clock_hz / ((double)(pwm.psc + 1) * (pwm.arr + 1));
+            cents = 1200.0 * log2(played_hz / frequency_hz);
+            max_cents = fmax(max_cents, fabs(cents));
+        }
+        buzzer_timing_t duration;
+        buzzer_timing_get_duration(p_options->clock_hz, buzzer_timing_get_scaled_duration(p_melody->p_durations[note], p_options->speed), &duration);
+        uint64_t cycles = (uint64_t)(duration.psc + 1) * (duration.arr + 1);
+        nominal_ms += p_melody->p_durations[note] / p_options->speed;
+        total_cycles += cycles;
+        if (!p_options->quiet)
+        {
+            printf("%5u | %14.3f | %8u | %5u | %11.3f | %14.3f | %13.3f | %8u | %5u | %11.3f | %21.3f\n", (unsigned)note, frequency_hz, (unsigned)pwm.psc, (unsigned)pwm.arr, played_hz, cents,
+                   p_melody->p_durations[note] / p_options->speed, (unsigned)duration.psc, (unsigned)duration.arr, 1000.0 * cycles / clock_hz, 1000.0 * total_cycles / clock_hz - nominal_ms);
+        }
+    }
+    printf("%-15s %3u notes, %9.1f ms, max pitch error %6.3f cents, timing error %+8.3f ms\n", p_wav_melody->p_name, (unsigned)p_melody->melody_length, 1000.0 * total_cycles / clock_hz, max_cents, 1000.0 * total_cycles / clock_hz - nominal_ms);
+
+    if (p_options->p_dir == NULL)
+    {
+        return 0;
+    }
+    char path[MELODY_WAV_PATH_LENGTH];
+    snprintf(path, sizeof(path), "%s/%s.wav", p_options->p_dir, p_wav_melody->p_name);
+    FILE *p_file = fopen(path, "wb");
+    if (p_file == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    uint32_t num_samples = (uint32_t)(total_cycles * p_options->sample_rate_hz / p_options->clock_hz);
+    _write_header(p_file, p_options->sample_rate_hz, num_samples);
+
+    // Every sample reads the counter of TIM3 at its clock cycle. The notes start where the previous one ends
+    uint32_t note = 0;
+    uint64_t note_start = 0;
+    uint64_t note_end = _get_note_cycles(p_melody, 0, p_options);
+    buzzer_timing_t pwm = {0, 0};
+    uint32_t ccr = 0;
+    if (p_melody->p_notes[0] != 0)
+    {
+        buzzer_timing_get_pwm(p_options->clock_hz, p_melody->p_notes[0], &pwm);
+        ccr = MELODY_WAV_PWM_DC * (pwm.arr + 1);
+    }
+    for (uint32_t sample = 0; sample < num_samples; sample++)
+    {
+        uint64_t cycle = (uint64_t)sample * p_options->clock_hz / p_options->sample_rate_hz;
+        while ((cycle >= note_end) && (note + 1 < p_melody->melody_length))
+        {
+            note++;
+            note_start = note_end;
+            note_end += _get_note_cycles(p_melody, note, p_options);
+            ccr = 0;
+            if (p_melody->p_notes[note] != 0)
+            {
+                buzzer_timing_get_pwm(p_options->clock_hz, p_melody->p_notes[note], &pwm);
+                ccr = MELODY_WAV_PWM_DC * (pwm.arr + 1);
+            }
+        }
+        int16_t value = 0;
+        if (ccr > 0)
+        {
+            uint64_t count = ((cycle - note_start) / (pwm.psc + 1)) % (pwm.arr + 1);
+            value = (count < ccr) ? MELODY_WAV_AMPLITUDE : -MELODY_WAV_AMPLITUDE;
+        }
+        _write_le(p_file, (uint16_t)value, 2);
+    }
+    fclose(p_file);
+    return 0;
+}
+
+/* Main ----------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    const char *p_melody_name = "all";
+    wav_options_t options = {.speed = 1.0, .clock_hz = 16000000, .sample_rate_hz = 48000, .p_dir = NULL, .quiet = false};
+    int option;
+    while ((option = getopt(argc, argv, "m:s:c:r:o:q")) != -1)
+    {
+        switch (option)
+        {
+        case 'm':
+            p_melody_name = optarg;
+            break;
+        case 's':
+            options.speed = atof(optarg);
+            break;
+        case 'c':
+            options.clock_hz = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            options.sample_rate_hz = strtoul(optarg, NULL, 10);
+            break;
+        case 'o':
+            options.p_dir = optarg;
+            break;
+        case 'q':
+            options.quiet = true;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-m melody|all] [-s speed] [-c clock] [-r rate] [-o dir] [-q]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if ((options.speed <= 0) || (options.clock_hz == 0) || (options.sample_rate_hz == 0))
+    {
+        fprintf(stderr, "The speed, the clock and the sample rate must be positive\n");
+        return EXIT_FAILURE;
+    }
+
+    uint64_t start_ns = _get_ns();
+    uint32_t rendered = 0;
+    for (uint32_t i = 0; i < sizeof(wav_melodies) / sizeof(wav_melodies[0]); i++)
+    {
+        if (!strcmp(p_melody_name, "all") || !strcmp(p_melody_name, wav_melodies[i].p_name))
+        {
+            if (_render_melody(&wav_melodies[i], &options) != 0)
+            {
+                return EXIT_FAILURE;
+            }
+            rendered++;
+        }
+    }
+    if (rendered == 0)
+    {
+        fprintf(stderr, "Melody not found: %s\n", p_melody_name);
+        return EXIT_FAILURE;
+    }
+    printf("%u melodies in %.3f ms\n", (unsigned)rendered, (_get_ns() - start_ns) / 1e6);
+    return EXIT_SUCCESS;
+}
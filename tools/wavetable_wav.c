@@ -0,0 +1,211 @@
+/**
+ * @file wavetable_wav.c
+ * @brief Host tool that renders a melody with the wavetable oscillator of the DAC output to a WAV file, and measures the cost of the fill per sample.
+ * @author Rafael Horcas Mateo (r.horcasm@alumnos.upm.es)
+ * @author Victor Mendizabal Gimeno (v.mendizabal@alumnos.upm.es)
+ * @date 19/10/2026
+ *
+ * It links the same `wavetable.c` and `melodies.c` as the firmware, and fills the samples in blocks of half a buffer of the DMA as `port_dac.c` does, so the WAV file has the samples the DAC converts. The 12-bit samples are written as 16-bit signed PCM, `(sample - WAVETABLE_OUTPUT_MIDSCALE) << 4`. The notes have their nominal durations, at speed 1.
+ *
+ * Build and run on Linux, from the root of the repository:
+ *
+ *     cc -O2 -std=c11 -Icommon/include tools/wavetable_wav.c common/src/wavetable.c common/src/melodies.c -lm -o wavetable_wav
+ *     ./wavetable_wav [-m melody] [-w sine|organ] [-n] [-o file.wav]
+ *
+ * Options:
+ *   -m  Melody: scale, inverse_scale, happy_birthday, tetris, avemaria or pp_hymn (default: happy_birthday)
+ *   -w  Harmonics of the wavetable (default: organ, as the firmware)
+ *   -n  Do not interpolate between the samples of the wavetable
+ *   -o  Output file (default: wavetable.wav)
+ */
+
+/* Includes ------------------------------------------------------------------*/
+/* Standard C libraries */
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Other libraries */
+#include "melodies.h"
+#include "wavetable.h"
+
+/* Defines ------------------------------------------------------------------*/
+#define WAV_SAMPLE_RATE_HZ 32000  /*!<Sample rate, as `PORT_DAC_SAMPLE_RATE_HZ` in port_dac.h*/
+#define WAV_BLOCK_LENGTH 128      /*!<Samples filled at once, as `PORT_DAC_HALF_LENGTH` in port_dac.h*/
+
+/* Typedefs ------------------------------------------------------------------*/
+/**
+ * @brief Melody that can be rendered, by name.
+ *
+ */
+typedef struct
+{
+    const char *p_name;         /*!<Name of the option `-m`*/
+    const melody_t *p_melody;   /*!<Melody of melodies.c*/
+} wav_melody_t;
+
+/* Global variables */
+/**
+ * @brief Melodies that can be rendered.
+ *
+ */
+static const wav_melody_t wav_melodies[] = {
+    {"scale", &scale_melody},
+    {"inverse_scale", &inverse_scale_melody},
+    {"happy_birthday", &happy_birthday_melody},
+    {"tetris", &tetris_melody},
+    {"avemaria", &avemaria_melody},
+    {"pp_hymn", &pp_hymn_melody},
+};
+
+/* Private functions ----------------------------------------------------------*/
+/**
+ * @brief Write a little-endian value of 2 or 4 bytes.
+ *
+ * @param p_file File
+ * @param value Value
+ * @param bytes Number of bytes
+ */
+static void _write_le(FILE *p_file, uint32_t value, uint32_t bytes)
+{
+    for (uint32_t i = 0; i < bytes; i++)
+    {
+        fputc((value >> (8 * i)) & 0xFF, p_file);
+    }
+}
+
+/**
+ * @brief Write the header of a mono 16-bit PCM WAV file.
+ *
+ * @param p_file File
+ * @param num_samples Number of samples of the file
+ */
+static void _write_header(FILE *p_file, uint32_t num_samples)
+{
+    uint32_t data_bytes = num_samples * 2;
+    fwrite("RIFF", 1, 4, p_file);
+    _write_le(p_file, 36 + data_bytes, 4);
+    fwrite("WAVEfmt ", 1, 8, p_file);
+    _write_le(p_file, 16, 4);                       // Size of the fmt chunk
+    _write_le(p_file, 1, 2);                        // PCM
+    _write_le(p_file, 1, 2);                        // Mono
+    _write_le(p_file, WAV_SAMPLE_RATE_HZ, 4);
+    _write_le(p_file, WAV_SAMPLE_RATE_HZ * 2, 4);   // Bytes per second
+    _write_le(p_file, 2, 2);                        // Bytes per sample
+    _write_le(p_file, 16, 2);                       // Bits per sample
+    fwrite("data", 1, 4, p_file);
+    _write_le(p_file, data_bytes, 4);
+}
+
+/**
+ * @brief Return the time of the monotonic clock in ns.
+ *
+ * @return uint64_t Time in ns
+ */
+static uint64_t _get_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+/* Main ----------------------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+    const char *p_melody_name = "happy_birthday";
+    const char *p_output = "wavetable.wav";
+    bool organ = true;
+    bool interpolate = true;
+    int option;
+    while ((option = getopt(argc, argv, "m:w:no:")) != -1)
+    {
+        switch (option)
+        {
+        case 'm':
+            p_melody_name = optarg;
+            break;
+        case 'w':
+            organ = (strcmp(optarg, "sine") != 0);
+            break;
+        case 'n':
+            interpolate = false;
+            break;
+        case 'o':
+            p_output = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [-m melody] [-w sine|organ] [-n] [-o file.wav]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    const melody_t *p_melody = NULL;
+    for (uint32_t i = 0; i < sizeof(wav_melodies) / sizeof(wav_melodies[0]); i++)
+    {
+        if (!strcmp(p_melody_name, wav_melodies[i].p_name))
+        {
+            p_melody = wav_melodies[i].p_melody;
+        }
+    }
+    if (p_melody == NULL)
+    {
+        fprintf(stderr, "Melody not found: %s\n", p_melody_name);
+        return EXIT_FAILURE;
+    }
+
+    static const double harmonics_sine[] = WAVETABLE_HARMONICS_SINE;
+    static const double harmonics_organ[] = WAVETABLE_HARMONICS_ORGAN;
+    static int16_t table[WAVETABLE_LENGTH];
+    if (organ)
+    {
+        wavetable_init_table(table, harmonics_organ, sizeof(harmonics_organ) / sizeof(harmonics_organ[0]));
+    }
+    else
+    {
+        wavetable_init_table(table, harmonics_sine, sizeof(harmonics_sine) / sizeof(harmonics_sine[0]));
+    }
+    wavetable_osc_t osc;
+    wavetable_osc_init(&osc, table, interpolate);
+
+    uint32_t num_samples = 0;
+    for (uint32_t note = 0; note < p_melody->melody_length; note++)
+    {
+        num_samples += (uint32_t)p_melody->p_durations[note] * WAV_SAMPLE_RATE_HZ / 1000;
+    }
+
+    FILE *p_file = fopen(p_output, "wb");
+    if (p_file == NULL)
+    {
+        perror(p_output);
+        return EXIT_FAILURE;
+    }
+    _write_header(p_file, num_samples);
+
+    static uint16_t block[WAV_BLOCK_LENGTH] __attribute__((aligned(4)));
+    uint64_t fill_ns = 0;
+    for (uint32_t note = 0; note < p_melody->melody_length; note++)
+    {
+        wavetable_osc_set_frequency(&osc, p_melody->p_notes[note], WAV_SAMPLE_RATE_HZ);
+        uint32_t remaining = (uint32_t)p_melody->p_durations[note] * WAV_SAMPLE_RATE_HZ / 1000;
+        while (remaining > 0)
+        {
+            uint32_t count = (remaining < WAV_BLOCK_LENGTH) ? remaining : WAV_BLOCK_LENGTH;
+            uint64_t start_ns = _get_ns();
+            wavetable_fill(&osc, block, count);
+            fill_ns += _get_ns() - start_ns;
+            for (uint32_t i = 0; i < count; i++)
+            {
+                _write_le(p_file, (uint16_t)((int16_t)(block[i] - WAVETABLE_OUTPUT_MIDSCALE) * 16), 2);
+            }
+            remaining -= count;
+        }
+    }
+    fclose(p_file);
+
+    printf("%s: %s, %u notes, %u samples at %u Hz (%.2f s)\n", p_output, p_melody_name, (unsigned)p_melody->melody_length, (unsigned)num_samples, (unsigned)WAV_SAMPLE_RATE_HZ, (double)num_samples / WAV_SAMPLE_RATE_HZ);
+    printf("Fill: %.2f ns per sample (%s, %s)\n", (num_samples > 0) ? (double)fill_ns / num_samples : 0.0, organ ? "organ" : "sine", interpolate ? "interpolated" : "not interpolated");
+    return EXIT_SUCCESS;
+}